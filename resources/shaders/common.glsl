@@ -1,7 +1,12 @@
+// NOTE: MAX_N_LIGHTS, MAX_N_MATERIALS, LIGHTS_BUFFER_BINDING and the variant defines (SHADOW_MAP_PASS, UNLIT,
+// DISPLACEMENT, INSTANCING) are injected by the host, see pbr::ShaderVariant
+#if !defined(SHADOW_MAP_PASS) && !defined(UNLIT)
+#define LIT
+#endif
+
 const float PI = 3.14159265358979323846;
 const float EPSILON = 0.000001;
 
-const int MAX_N_LIGHTS = 8;
 const int MAX_N_SHADOW_MAPS = MAX_N_LIGHTS;
 
 const int POINT_LIGHT = 0;
@@ -9,18 +14,22 @@ const int DIRECTIONAL_LIGHT = 1;
 const int SPOT_LIGHT = 2;
 const int AMBIENT_LIGHT = 3;
 
+// NOTE: Packed into the std140 layout without the padding holes, it must
+// match the GPULight of system::lighting
 struct Light {
+    vec3 position;
     int type;
+
+    vec3 direction;
     int casts_shadows;
 
+    vec3 color;
     float intensity;
-    float inner_cutoff;
-    float outer_cutoff;
 
-    vec3 position;
     vec3 attenuation;
-    vec3 direction;
-    vec3 color;
+    float inner_cutoff;
+
+    float outer_cutoff;
 
     mat4 vp_mat;
 };
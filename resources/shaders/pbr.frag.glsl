@@ -3,34 +3,43 @@
 in vec3 v_world_pos;
 in vec2 v_tex_coord;
 in vec3 v_normal;
-in mat3 v_tbn;
+flat in int v_material_layer;
+flat in float v_material_min_lod;
 
-// NOTE: This represents the rasterized vertex position in a ndc light space.
-// Since there are more than 1 light, these positions are stored in the array.
-in vec4 v_light_positions[MAX_N_LIGHTS];
+#ifdef LIT
+in mat3 v_tbn;
+#endif
 
 // -----------------------------------------------------------------------
 // Uniforms
-uniform sampler2D u_shadow_maps[MAX_N_SHADOW_MAPS];
-
-uniform sampler2D u_albedo_map;
-uniform sampler2D u_metalness_map;
-uniform sampler2D u_normal_map;
-uniform sampler2D u_roughness_map;
-uniform sampler2D u_occlusion_map;
+uniform float u_shadow_map_max_dist;
+uniform vec3 u_camera_pos;
 
+// NOTE: Material maps are stored in texture arrays, one layer per material
+#ifndef SHADOW_MAP_PASS
+uniform sampler2DArray u_albedo_maps;
 uniform vec4 u_constant_color;
+#endif
+
+#ifdef LIT
+uniform sampler2D u_shadow_maps[MAX_N_SHADOW_MAPS];
+
+uniform sampler2DArray u_normal_maps;
+// NOTE: Occlusion, roughness, metalness, height
+uniform sampler2DArray u_ormh_maps;
 
-uniform int u_is_shadow_map_pass;
-uniform int u_is_light_enabled;
 uniform float u_shadow_map_bias;
-uniform float u_shadow_map_max_dist;
-uniform vec3 u_camera_pos;
-uniform int u_n_lights;
-uniform Light u_lights[MAX_N_LIGHTS];
+
+// NOTE: The host patches only the changed lights into this buffer
+layout(std140, binding = LIGHTS_BUFFER_BINDING) uniform Lights {
+    int u_n_lights;
+    Light u_lights[MAX_N_LIGHTS];
+};
+#endif
 
 out vec4 f_color;
 
+#ifdef LIT
 float mock_usage() {
     float f = 0.0;
     vec2 uv = vec2(0.0, 0.0);
@@ -40,11 +49,9 @@ float mock_usage() {
     f += v_normal.x;
     f += v_tbn[0][0];
 
-    f += texture(u_albedo_map, uv).x;
-    f += texture(u_metalness_map, uv).x;
-    f += texture(u_normal_map, uv).x;
-    f += texture(u_roughness_map, uv).x;
-    f += texture(u_occlusion_map, uv).x;
+    f += texture(u_albedo_maps, vec3(uv, 0.0)).x;
+    f += texture(u_normal_maps, vec3(uv, 0.0)).x;
+    f += texture(u_ormh_maps, vec3(uv, 0.0)).x;
 
     f += u_camera_pos.x;
     f += float(u_n_lights);
@@ -77,32 +84,47 @@ float GeomSmith(float nDotV, float nDotL, float roughness) {
     float ggx2 = nDotL / (nDotL * ik + k);
     return ggx1 * ggx2;
 }
+#endif
+
+#ifndef SHADOW_MAP_PASS
+// NOTE: Mips finer than the material's min lod are not streamed in yet.
+// The texture arrays are shared by all materials, so the clamp can't be done
+// with GL_TEXTURE_BASE_LEVEL and is applied per layer here instead
+vec4 sample_material_map(sampler2DArray maps) {
+    float lod = max(textureQueryLod(maps, v_tex_coord).y, v_material_min_lod);
+    return textureLod(maps, vec3(v_tex_coord, v_material_layer), lod);
+}
+#endif
 
+#ifdef SHADOW_MAP_PASS
 vec3 get_shadow_map_color() {
     float dist_to_camera = distance(u_camera_pos, v_world_pos);
     float depth = dist_to_camera / u_shadow_map_max_dist;
     return vec3(depth);
 }
+#endif
 
+#ifdef UNLIT
 vec3 get_albedo_color() {
-    vec2 uv = v_tex_coord;
-    vec3 color = texture(u_albedo_map, uv).rgb;
+    vec3 color = sample_material_map(u_albedo_maps).rgb;
     color = mix(color, u_constant_color.rgb, u_constant_color.a);
 
     return color;
 }
+#endif
 
+#ifdef LIT
 vec3 get_pbr_color() {
-    vec2 uv = v_tex_coord;
-    vec3 albedo = texture(u_albedo_map, uv).rgb;
+    vec3 albedo = sample_material_map(u_albedo_maps).rgb;
+    vec4 ormh = sample_material_map(u_ormh_maps);
 
     vec3 view_dir = normalize(v_world_pos - u_camera_pos);
-    float metallic = clamp(texture(u_metalness_map, uv).r, 0.04, 1.0);
-    float roughness = clamp(texture(u_roughness_map, uv).r, 0.04, 1.0);
-    float occlusion = texture(u_occlusion_map, uv).r;
+    float metallic = clamp(ormh.b, 0.04, 1.0);
+    float roughness = clamp(ormh.g, 0.04, 1.0);
+    float occlusion = ormh.r;
     vec3 base_reflection = mix(vec3(0.04), albedo.rgb, metallic);
 
-    vec3 normal = texture(u_normal_map, uv).rgb;
+    vec3 normal = sample_material_map(u_normal_maps).rgb;
     if (length(normal) > EPSILON) {
         normal = v_tbn * normalize(normal * 2.0 - 1.0);
     } else {
@@ -120,7 +142,10 @@ vec3 get_pbr_color() {
 
         bool is_in_shadow = false;
         if (light.casts_shadows == 1) {
-            vec4 ndc = v_light_positions[i];
+            // NOTE: The light space position is projected here rather than
+            // interpolated from the vertex stage, so lights which don't cast
+            // shadows cost nothing and the varyings stay small
+            vec4 ndc = light.vp_mat * vec4(v_world_pos, 1.0);
             vec2 uv = 0.5 * ((ndc.xy / ndc.w) + 1.0);
             if (uv.x < 0.0 || uv.y < 0.0 || uv.x > 1.0 || uv.y > 1.0) {
                 is_in_shadow = true;
@@ -192,18 +217,16 @@ vec3 get_pbr_color() {
 
     return color;
 }
+#endif
 
 void main() {
-    vec3 color;
-
-    // TODO: Introduce render type enum: SHADOW_MAP, ALBEDO, PBR
-    if (u_is_shadow_map_pass == 1) {
-        color = get_shadow_map_color();
-    } else if (u_is_light_enabled == 1) {
-        color = get_pbr_color();
-    } else {
-        color = get_albedo_color();
-    }
+#if defined(SHADOW_MAP_PASS)
+    vec3 color = get_shadow_map_color();
+#elif defined(UNLIT)
+    vec3 color = get_albedo_color();
+#else
+    vec3 color = get_pbr_color();
+#endif
 
     f_color = vec4(color, 1.0);
 }
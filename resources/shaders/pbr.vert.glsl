@@ -9,49 +9,80 @@ layout(location = 2) in vec3 a_normal;
 layout(location = 4) in vec4 a_tangent;
 // layout(location = 5) in vec2 a_tex_coord;
 
+#ifdef INSTANCING
+// NOTE: raylib's DrawMeshInstanced streams per-instance model matrices into
+// the attribute bound to SHADER_LOC_MATRIX_MODEL (takes 4 locations: 6..9).
+// The material layer is packed into the unused bottom row: [0][3]
+layout(location = 6) in mat4 a_instance_transform;
+#endif
+
 // Uniforms
+// NOTE: In the instanced variant u_mvp_mat holds only the view-projection matrix
 uniform mat4 u_mvp_mat;
+#ifndef INSTANCING
 uniform mat4 u_model_mat;
 uniform mat4 u_normal_mat;
+uniform int u_material_layer;
+#endif
 
-uniform vec2 u_tiling;
-
-uniform sampler2D u_height_map;
-uniform float u_displacement_scale;
+// NOTE: Indexed by the material layer. xy - tiling, z - displacement scale,
+// w - finest resident mip level (see MaterialPBR streaming)
+uniform vec4 u_material_params[MAX_N_MATERIALS];
 
-uniform int u_n_lights;
-uniform Light u_lights[MAX_N_LIGHTS];
+#ifdef DISPLACEMENT
+// NOTE: Occlusion, roughness, metalness, height
+uniform sampler2DArray u_ormh_maps;
+#endif
 
 // Outputs to fragment shader
 out vec3 v_world_pos;
 out vec2 v_tex_coord;
 out vec3 v_normal;
-out mat3 v_tbn;
+flat out int v_material_layer;
+flat out float v_material_min_lod;
 
-// NOTE: This represents vertex position in a ndc light space.
-// Since there are more than 1 light, these positions are stored in the array.
-out vec4 v_light_positions[MAX_N_LIGHTS];
+#ifdef LIT
+out mat3 v_tbn;
+#endif
 
 vec3 mat4_by_vec3(mat4 mat, vec3 vec) {
     return vec3(mat * vec4(vec, 1.0));
 }
 
 void main() {
+#ifdef INSTANCING
+    int layer = int(a_instance_transform[0][3] + 0.5);
+    mat4 model_mat = a_instance_transform;
+    model_mat[0][3] = 0.0;
+    mat4 mvp_mat = u_mvp_mat * model_mat;
+    // NOTE: Instanced meshes (tiles) are only rotated and translated,
+    // so the model matrix itself can transform normals
+    v_normal = normalize(mat3(model_mat) * a_normal);
+#else
+    int layer = u_material_layer;
+    mat4 model_mat = u_model_mat;
+    mat4 mvp_mat = u_mvp_mat;
     v_normal = normalize(mat4_by_vec3(u_normal_mat, a_normal));
-    v_tex_coord = u_tiling * a_tex_coord;
-    float height = texture(u_height_map, v_tex_coord).r;
-    vec3 position = a_position + a_normal * height * u_displacement_scale;
-    v_world_pos = mat4_by_vec3(u_model_mat, position);
+#endif
 
-    gl_Position = u_mvp_mat * vec4(position, 1.0);
+    vec4 params = u_material_params[layer];
+    v_material_layer = layer;
+    v_material_min_lod = params.w;
+    v_tex_coord = params.xy * a_tex_coord;
 
-    vec3 tangent = normalize(mat3(u_model_mat) * a_tangent.xyz);
+#ifdef DISPLACEMENT
+    float height = textureLod(u_ormh_maps, vec3(v_tex_coord, layer), params.w).a;
+    vec3 position = a_position + a_normal * height * params.z;
+#else
+    vec3 position = a_position;
+#endif
+
+    v_world_pos = mat4_by_vec3(model_mat, position);
+    gl_Position = mvp_mat * vec4(position, 1.0);
+
+#ifdef LIT
+    vec3 tangent = normalize(mat3(model_mat) * a_tangent.xyz);
     vec3 bitangent = normalize(cross(tangent, v_normal) * a_tangent.w);
     v_tbn = mat3(tangent, bitangent, v_normal);
-
-    for (int i = 0; i < u_n_lights; ++i) {
-        mat4 vp_mat = u_lights[i].vp_mat;
-        vec4 ndc = vp_mat * u_model_mat * vec4(position, 1.0);
-        v_light_positions[i] = ndc;
-    }
+#endif
 }
@@ -7,7 +7,14 @@ namespace soft_tissues::component {
 MyMesh::MyMesh(std::string mesh_key, std::string material_pbr_key)
     : mesh_key(std::move(mesh_key))
     , material_pbr_key(std::move(material_pbr_key))
-    , constant_color(BLANK) {}
+    , constant_color(BLANK) {
+    this->resolve();
+}
+
+void MyMesh::resolve() {
+    this->mesh = resources::get_mesh_handle(this->mesh_key);
+    this->material_pbr = resources::get_material_pbr_handle(this->material_pbr_key);
+}
 
 nlohmann::json MyMesh::to_json() const {
     nlohmann::json json;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "core/resources.hpp"
 #include "nlohmann/json.hpp"
 #include "raylib/raylib.h"
 #include <string>
@@ -7,12 +8,19 @@
 namespace soft_tissues::component {
 
 struct MyMesh {
+    // keys are kept for the serialization and the editor
     std::string mesh_key;
     std::string material_pbr_key;
     Color constant_color;
 
+    // resolved from the keys, resolve() must be called after changing a key
+    resources::MeshHandle mesh;
+    resources::MaterialHandle material_pbr;
+
     MyMesh(std::string mesh_key, std::string material_pbr_key);
 
+    void resolve();
+
     nlohmann::json to_json() const;
     static MyMesh from_json(const nlohmann::json &json_data);
 };
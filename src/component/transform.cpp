@@ -8,22 +8,18 @@ namespace soft_tissues::component {
 Transform::Transform(Vector3 position)
     : position(position)
     , scale(Vector3One())
-    , rotation(Vector3Zero()) {}
+    , rotation(QuaternionIdentity()) {}
 
 Transform::Transform(Vector3 position, Vector3 scale)
     : position(position)
     , scale(scale)
-    , rotation(Vector3Zero()) {}
+    , rotation(QuaternionIdentity()) {}
 
-Transform::Transform(Vector3 position, Vector3 scale, Vector3 rotation)
+Transform::Transform(Vector3 position, Vector3 scale, Quaternion rotation)
     : position(position)
     , scale(scale)
     , rotation(rotation) {}
 
-Quaternion Transform::get_local_quaternion() const {
-    return QuaternionFromEuler(this->rotation.x, this->rotation.y, this->rotation.z);
-}
-
 nlohmann::json Transform::to_json() const {
     nlohmann::json json;
 
@@ -37,7 +33,15 @@ nlohmann::json Transform::to_json() const {
 Transform Transform::from_json(const nlohmann::json &json_data) {
     Vector3 position = json_data["position"].get<Vector3>();
     Vector3 scale = json_data["scale"].get<Vector3>();
-    Vector3 rotation = json_data["rotation"].get<Vector3>();
+    // older worlds store the euler angles
+    const auto &rotation_json = json_data["rotation"];
+    Quaternion rotation;
+    if (rotation_json.size() == 3) {
+        Vector3 euler = rotation_json.get<Vector3>();
+        rotation = QuaternionFromEuler(euler.x, euler.y, euler.z);
+    } else {
+        rotation = QuaternionNormalize(rotation_json.get<Quaternion>());
+    }
 
     return Transform(position, scale, rotation);
 }
@@ -9,17 +9,34 @@ namespace soft_tissues::component {
 struct Transform {
     Vector3 position = Vector3Zero();
     Vector3 scale = Vector3One();
-    Vector3 rotation = Vector3Zero();
+    // Unit quaternion. Euler angles are only used by the editor ui and by the
+    // worlds saved before the quaternions (read by from_json)
+    Quaternion rotation = QuaternionIdentity();
 
     Transform() = default;
     Transform(Vector3 position);
     Transform(Vector3 position, Vector3 scale);
-    Transform(Vector3 position, Vector3 scale, Vector3 rotation);
-
-    Quaternion get_local_quaternion() const;
+    Transform(Vector3 position, Vector3 scale, Quaternion rotation);
 
     nlohmann::json to_json() const;
     static Transform from_json(const nlohmann::json &json_data);
 };
 
+// Position of the entity in the hierarchy order of system::transform, which
+// keeps the world transforms. Maintained by the system, never serialized
+struct HierarchyNode {
+    int idx = -1;
+};
+
+// Position owned by the fixed step simulation, the Transform gets the one
+// interpolated between the last two steps. Maintained by system::simulation,
+// never serialized
+struct SimulatedPosition {
+    Vector3 prev_position = Vector3Zero();
+    Vector3 position = Vector3Zero();
+    // last interpolated position, the Transform differs from it when the
+    // entity is moved outside of the simulation (editor, world loading)
+    Vector3 rendered_position = Vector3Zero();
+};
+
 }  // namespace soft_tissues::component
@@ -0,0 +1,119 @@
+#include "alloc_probe.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace soft_tissues::alloc_probe {
+
+static std::atomic<uint64_t> N_ALLOCATIONS = 0;
+static uint64_t N_FRAME_START_ALLOCATIONS = 0;
+static int N_FRAME_ALLOCATIONS = 0;
+
+#ifdef ALLOC_PROBE
+
+static void *allocate(size_t n_bytes) {
+    N_ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(n_bytes == 0 ? 1 : n_bytes);
+    if (ptr == nullptr) throw std::bad_alloc();
+
+    return ptr;
+}
+
+static void *allocate_aligned(size_t n_bytes, std::align_val_t alignment) {
+    N_ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+
+    // aligned_alloc wants the size to be a multiple of the alignment
+    size_t align = static_cast<size_t>(alignment);
+    size_t n_aligned_bytes = (std::max<size_t>(n_bytes, 1) + align - 1) / align * align;
+
+    void *ptr = std::aligned_alloc(align, n_aligned_bytes);
+    if (ptr == nullptr) throw std::bad_alloc();
+
+    return ptr;
+}
+
+#endif
+
+bool is_enabled() {
+#ifdef ALLOC_PROBE
+    return true;
+#else
+    return false;
+#endif
+}
+
+uint64_t get_n_allocations() {
+    return N_ALLOCATIONS.load(std::memory_order_relaxed);
+}
+
+void end_frame() {
+    uint64_t n_allocations = get_n_allocations();
+    N_FRAME_ALLOCATIONS = n_allocations - N_FRAME_START_ALLOCATIONS;
+    N_FRAME_START_ALLOCATIONS = n_allocations;
+}
+
+int get_n_frame_allocations() {
+    return N_FRAME_ALLOCATIONS;
+}
+
+}  // namespace soft_tissues::alloc_probe
+
+// -----------------------------------------------------------------------
+// global operator new/delete replacement
+// The nothrow versions of the standard library call the throwing ones, so
+// they are counted as well.
+
+#ifdef ALLOC_PROBE
+
+void *operator new(size_t n_bytes) {
+    return soft_tissues::alloc_probe::allocate(n_bytes);
+}
+
+void *operator new[](size_t n_bytes) {
+    return soft_tissues::alloc_probe::allocate(n_bytes);
+}
+
+void *operator new(size_t n_bytes, std::align_val_t alignment) {
+    return soft_tissues::alloc_probe::allocate_aligned(n_bytes, alignment);
+}
+
+void *operator new[](size_t n_bytes, std::align_val_t alignment) {
+    return soft_tissues::alloc_probe::allocate_aligned(n_bytes, alignment);
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+#endif
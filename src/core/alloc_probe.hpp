@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+namespace soft_tissues::alloc_probe {
+
+// Counter of the heap allocations. The global operator new is replaced in
+// alloc_probe.cpp only when it's built with ALLOC_PROBE defined: the tests
+// always are, the game when the flag is enabled in the Makefile. Only the C++
+// allocations are visible: the mallocs of raylib, GLFW and the driver are not
+// counted. Used to check that the steady state frames don't allocate.
+bool is_enabled();
+// Always 0 when the probe is disabled
+uint64_t get_n_allocations();
+
+// Closes the count of the current frame, called once per frame
+void end_frame();
+// Allocations made during the last finished frame
+int get_n_frame_allocations();
+
+}  // namespace soft_tissues::alloc_probe
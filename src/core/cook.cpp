@@ -0,0 +1,253 @@
+#include "cook.hpp"
+
+#include "nlohmann/json.hpp"
+#include "pack.hpp"
+#include "raylib/raylib.h"
+#include "utils.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+namespace soft_tissues::cook {
+
+// "STCM" - soft tissues cooked material
+static constexpr uint32_t MATERIAL_FILE_MAGIC = 0x4d435453;
+// bump on any change of the file layout or of the map processing
+static constexpr uint32_t MATERIAL_FILE_VERSION = 1;
+
+// Followed by the albedo, normal and ormh mip chains and the preview image,
+// all of them are RGBA8
+struct MaterialFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int32_t size;
+    int32_t n_levels;
+    int32_t preview_size;
+};
+
+// -----------------------------------------------------------------------
+// materials
+static MaterialFileHeader get_expected_header() {
+    static constexpr int size = render_config::MATERIAL_MAP_SIZE;
+
+    MaterialFileHeader header;
+    header.magic = MATERIAL_FILE_MAGIC;
+    header.version = MATERIAL_FILE_VERSION;
+    header.size = size;
+    header.n_levels = pbr::MaterialArray::get_n_levels(size);
+    header.preview_size = render_config::MATERIAL_PREVIEW_SIZE;
+
+    return header;
+}
+
+uint64_t get_material_hash(const pbr::MaterialDesc &desc) {
+    MaterialFileHeader header = get_expected_header();
+    uint64_t hash = utils::hash_fnv1a(&header, sizeof(header));
+
+    // unlisted maps are zero filled, so the list itself is a part of the key
+    for (auto type : pbr::MAP_TYPES) {
+        if (!desc.has_map(type)) continue;
+
+        auto file_name = pbr::map_type_to_str(type) + ".png";
+        std::ifstream file(desc.dir_path + file_name, std::ios::binary);
+        std::string data(
+            (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>()
+        );
+
+        hash = utils::hash_fnv1a(file_name, hash);
+        hash = utils::hash_fnv1a(data, hash);
+    }
+
+    return hash;
+}
+
+bool is_up_to_date(const pbr::MaterialDesc &desc, const CookedMaterial &cooked) {
+    for (auto type : pbr::MAP_TYPES) {
+        if (!desc.has_map(type)) continue;
+
+        auto file_path = desc.dir_path + pbr::map_type_to_str(type) + ".png";
+        if (!std::filesystem::exists(file_path)) return true;
+    }
+
+    return get_material_hash(desc) == cooked.hash;
+}
+
+std::string get_material_file_path(uint64_t hash) {
+    char file_name[32];
+    std::snprintf(file_name, sizeof(file_name), "%016llx.bin", (unsigned long long)hash);
+    return CACHE_DIR_PATH + file_name;
+}
+
+bool save_material_images(const std::string &file_path, const pbr::MaterialImages &images) {
+    MaterialFileHeader header = get_expected_header();
+
+    std::error_code ec;
+    std::filesystem::create_directories(CACHE_DIR_PATH, ec);
+
+    // the same temporary file trick as in the shader cache
+    auto tmp_file_path = file_path + ".tmp";
+    {
+        std::ofstream file(tmp_file_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+        for (const Image *image : {&images.albedo, &images.normal, &images.ormh}) {
+            if (image->width != header.size || image->mipmaps != header.n_levels
+                || image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) {
+                TraceLog(LOG_WARNING, "COOK: Unexpected map image layout: %s", file_path.c_str());
+                return false;
+            }
+
+            auto n_bytes = pbr::MaterialArray::get_map_n_bytes(header.size, header.n_levels);
+            file.write(static_cast<const char *>(image->data), n_bytes);
+        }
+
+        auto preview_n_bytes = pbr::MaterialArray::get_map_n_bytes(header.preview_size, 1);
+        file.write(static_cast<const char *>(images.preview.data), preview_n_bytes);
+
+        if (!file) {
+            TraceLog(LOG_WARNING, "COOK: Failed to write cooked material: %s", file_path.c_str());
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmp_file_path, file_path, ec);
+    return !ec;
+}
+
+static bool is_header_valid(const MaterialFileHeader &header) {
+    MaterialFileHeader expected = get_expected_header();
+    return header.magic == expected.magic && header.version == expected.version
+           && header.size == expected.size && header.n_levels == expected.n_levels
+           && header.preview_size == expected.preview_size;
+}
+
+static Image make_image(void *data, int size, int n_levels) {
+    Image image;
+    image.data = data;
+    image.width = size;
+    image.height = size;
+    image.mipmaps = n_levels;
+    image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+
+    return image;
+}
+
+static Image read_image(std::ifstream &file, int size, int n_levels) {
+    auto n_bytes = pbr::MaterialArray::get_map_n_bytes(size, n_levels);
+    Image image = make_image(MemAlloc(n_bytes), size, n_levels);
+    file.read(static_cast<char *>(image.data), n_bytes);
+
+    return image;
+}
+
+static bool read_material_images(
+    std::ifstream &file, const std::string &file_path, pbr::MaterialImages &images
+) {
+    MaterialFileHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || !is_header_valid(header)) {
+        TraceLog(LOG_WARNING, "COOK: Cooked material is outdated: %s", file_path.c_str());
+        return false;
+    }
+
+    pbr::MaterialImages loaded;
+    loaded.albedo = read_image(file, header.size, header.n_levels);
+    loaded.normal = read_image(file, header.size, header.n_levels);
+    loaded.ormh = read_image(file, header.size, header.n_levels);
+    loaded.preview = read_image(file, header.preview_size, 1);
+
+    if (!file) {
+        TraceLog(LOG_WARNING, "COOK: Cooked material is truncated: %s", file_path.c_str());
+        loaded.unload();
+        return false;
+    }
+
+    images = loaded;
+    return true;
+}
+
+// Points the images into the pack blob without copying
+static bool view_material_images(
+    std::span<const unsigned char> data,
+    const std::string &file_path,
+    pbr::MaterialImages &images
+) {
+    MaterialFileHeader header;
+    if (data.size() < sizeof(header)) return false;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (!is_header_valid(header)) {
+        TraceLog(LOG_WARNING, "COOK: Cooked material is outdated: %s", file_path.c_str());
+        return false;
+    }
+
+    auto map_n_bytes = pbr::MaterialArray::get_map_n_bytes(header.size, header.n_levels);
+    auto preview_n_bytes = pbr::MaterialArray::get_map_n_bytes(header.preview_size, 1);
+    if (data.size() < sizeof(header) + 3 * map_n_bytes + preview_n_bytes) {
+        TraceLog(LOG_WARNING, "COOK: Cooked material is truncated: %s", file_path.c_str());
+        return false;
+    }
+
+    // images are never written, the const is dropped only to fit the Image
+    auto ptr = const_cast<unsigned char *>(data.data()) + sizeof(header);
+    images.albedo = make_image(ptr, header.size, header.n_levels);
+    images.normal = make_image(ptr + map_n_bytes, header.size, header.n_levels);
+    images.ormh = make_image(ptr + 2 * map_n_bytes, header.size, header.n_levels);
+    images.preview = make_image(ptr + 3 * map_n_bytes, header.preview_size, 1);
+    images.is_borrowed = true;
+
+    return true;
+}
+
+bool load_material_images(const std::string &file_path, pbr::MaterialImages &images) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (file) return read_material_images(file, file_path, images);
+
+    auto data = pack::find(file_path);
+    if (data.empty()) return false;
+
+    return view_material_images(data, file_path, images);
+}
+
+// -----------------------------------------------------------------------
+// index
+std::unordered_map<std::string, CookedMaterial> load_index() {
+    std::unordered_map<std::string, CookedMaterial> index;
+
+    auto file = pack::load_file(INDEX_FILE_PATH);
+    if (!file.is_loaded()) return index;
+
+    auto json = nlohmann::json::parse(file.get_str());
+    for (const auto &[key, entry] : json.items()) {
+        // an index without the hashes is skipped, the next cook rewrites it
+        if (!entry.is_object()) continue;
+
+        index[key] = {entry["file_path"].get<std::string>(), entry["hash"].get<uint64_t>()};
+    }
+
+    return index;
+}
+
+void save_index(const std::unordered_map<std::string, CookedMaterial> &index) {
+    std::error_code ec;
+    std::filesystem::create_directories(CACHE_DIR_PATH, ec);
+
+    nlohmann::json json = nlohmann::json::object();
+    for (const auto &[key, cooked] : index) {
+        json[key] = {{"file_path", cooked.file_path}, {"hash", cooked.hash}};
+    }
+
+    std::ofstream file(INDEX_FILE_PATH);
+    file << json.dump(4);
+
+    if (!file) {
+        throw std::runtime_error("Failed to save cooked material index: " + INDEX_FILE_PATH);
+    }
+}
+
+}  // namespace soft_tissues::cook
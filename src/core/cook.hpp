@@ -0,0 +1,45 @@
+#pragma once
+
+#include "pbr.hpp"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace soft_tissues::cook {
+
+// Cooked materials are written by the offline cook tool (make cook) into a
+// cache directory. Each material is a single file holding the packed maps with
+// their full mip chains, so the runtime reads it without decoding the pngs or
+// generating mips. Files are named by the hash of the source maps, unchanged
+// materials are not recooked. The index maps material keys to the cooked files.
+inline const std::string CACHE_DIR_PATH = "cache/materials/";
+inline const std::string INDEX_FILE_PATH = CACHE_DIR_PATH + "index.json";
+
+// Index entry: the cooked file and the hash of the sources it was cooked from
+struct CookedMaterial {
+    std::string file_path;
+    uint64_t hash;
+};
+
+// Hash of the cook format and the listed source map files
+uint64_t get_material_hash(const pbr::MaterialDesc &desc);
+std::string get_material_file_path(uint64_t hash);
+
+// False if the loose source maps are present and differ from the ones the
+// material was cooked from. Without the loose maps (only the asset pack is
+// shipped) the cooked file is trusted. Reads the maps, so it's meant for the
+// worker threads
+bool is_up_to_date(const pbr::MaterialDesc &desc, const CookedMaterial &cooked);
+
+bool save_material_images(const std::string &file_path, const pbr::MaterialImages &images);
+
+// Returns false if the file is missing or was cooked with other settings.
+// A file found only in the asset pack is not copied, the images borrow its data.
+// Thread-safe, like pbr::load_material_images
+bool load_material_images(const std::string &file_path, pbr::MaterialImages &images);
+
+// Returns an empty index if nothing is cooked yet
+std::unordered_map<std::string, CookedMaterial> load_index();
+void save_index(const std::unordered_map<std::string, CookedMaterial> &index);
+
+}  // namespace soft_tissues::cook
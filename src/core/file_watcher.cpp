@@ -0,0 +1,88 @@
+#include "file_watcher.hpp"
+
+#include "raylib/raylib.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace soft_tissues::file_watcher {
+
+FileWatcher::FileWatcher() = default;
+
+#ifdef __linux__
+
+bool FileWatcher::watch_dir(const std::string &dir_path) {
+    if (this->fd == -1) {
+        this->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (this->fd == -1) {
+            TraceLog(LOG_WARNING, "FILE_WATCHER: Failed to init inotify");
+            return false;
+        }
+    }
+
+    // editors either write the file in place or move a new one over it
+    int wd = inotify_add_watch(this->fd, dir_path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd == -1) return false;
+
+    auto path = dir_path;
+    if (path.empty() || path.back() != '/') path += '/';
+    this->dir_paths[wd] = path;
+
+    return true;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    std::vector<std::string> file_paths;
+    if (this->fd == -1) return file_paths;
+
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t n_bytes = read(this->fd, buffer, sizeof(buffer));
+        if (n_bytes <= 0) break;
+
+        for (ssize_t offset = 0; offset < n_bytes;) {
+            auto *event = reinterpret_cast<const inotify_event *>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+
+            auto it = this->dir_paths.find(event->wd);
+            if (it == this->dir_paths.end() || event->len == 0) continue;
+
+            auto file_path = it->second + event->name;
+            if (std::find(file_paths.begin(), file_paths.end(), file_path)
+                == file_paths.end()) {
+                file_paths.push_back(file_path);
+            }
+        }
+    }
+
+    return file_paths;
+}
+
+void FileWatcher::unload() {
+    if (this->fd != -1) {
+        close(this->fd);
+        this->fd = -1;
+    }
+    this->dir_paths.clear();
+}
+
+#else
+
+bool FileWatcher::watch_dir(const std::string &) {
+    return false;
+}
+
+std::vector<std::string> FileWatcher::poll() {
+    return {};
+}
+
+void FileWatcher::unload() {}
+
+#endif
+
+}  // namespace soft_tissues::file_watcher
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace soft_tissues::file_watcher {
+
+// Reports the files written or moved into the watched directories. Backed by
+// the non-blocking inotify on Linux, so poll() never waits. Does nothing on
+// the other platforms.
+class FileWatcher {
+private:
+    int fd = -1;
+    // inotify watch descriptor -> directory path with the trailing slash
+    std::unordered_map<int, std::string> dir_paths;
+
+public:
+    FileWatcher();
+
+    // owns the inotify descriptor, which unload() closes
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+    FileWatcher(FileWatcher &&) = delete;
+    FileWatcher &operator=(FileWatcher &&) = delete;
+
+    // Returns false if the directory can't be watched (e.g. it doesn't exist)
+    bool watch_dir(const std::string &dir_path);
+
+    // Paths of the files changed since the last poll, without duplicates
+    std::vector<std::string> poll();
+
+    void unload();
+};
+
+}  // namespace soft_tissues::file_watcher
@@ -0,0 +1,87 @@
+#include "frame_arena.hpp"
+
+#include "raylib/raylib.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace soft_tissues::frame_arena {
+
+static char *BUFFER = nullptr;
+static size_t CAPACITY = 0;
+// keeps growing past the capacity, so the reset knows how much was needed
+static std::atomic<size_t> OFFSET = 0;
+static size_t N_USED_BYTES = 0;
+
+// heap blocks of the allocations which didn't fit
+static std::mutex OVERFLOW_MUTEX;
+static std::vector<void *> OVERFLOW_BLOCKS;
+
+static void free_overflow_blocks() {
+    for (void *block : OVERFLOW_BLOCKS) {
+        ::operator delete(block);
+    }
+    OVERFLOW_BLOCKS.clear();
+}
+
+void load(size_t n_bytes) {
+    BUFFER = static_cast<char *>(::operator new(n_bytes));
+    CAPACITY = n_bytes;
+    OFFSET = 0;
+}
+
+void unload() {
+    free_overflow_blocks();
+    ::operator delete(BUFFER);
+    BUFFER = nullptr;
+    CAPACITY = 0;
+    OFFSET = 0;
+}
+
+void reset() {
+    N_USED_BYTES = OFFSET.load();
+    OFFSET = 0;
+
+    if (!OVERFLOW_BLOCKS.empty()) {
+        free_overflow_blocks();
+
+        size_t n_bytes = N_USED_BYTES + N_USED_BYTES / 2;
+        TraceLog(
+            LOG_WARNING, "FRAME_ARENA: Frame didn't fit, growing to %zu bytes", n_bytes
+        );
+        unload();
+        load(n_bytes);
+    }
+}
+
+void *allocate(size_t n_bytes, size_t alignment) {
+    // the alignment padding is reserved along with the size, so a single
+    // atomic add is enough
+    size_t n_reserved_bytes = n_bytes + alignment - 1;
+    size_t offset = OFFSET.fetch_add(n_reserved_bytes, std::memory_order_relaxed);
+
+    if (offset + n_reserved_bytes <= CAPACITY) {
+        auto address = reinterpret_cast<uintptr_t>(BUFFER + offset);
+        address = (address + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        return reinterpret_cast<void *>(address);
+    }
+
+    // operator new is aligned to the fundamental alignment, which covers the
+    // containers of the engine types
+    std::lock_guard<std::mutex> lock(OVERFLOW_MUTEX);
+    void *block = ::operator new(n_bytes);
+    OVERFLOW_BLOCKS.push_back(block);
+
+    return block;
+}
+
+size_t get_capacity() {
+    return CAPACITY;
+}
+
+size_t get_n_used_bytes() {
+    return N_USED_BYTES;
+}
+
+}  // namespace soft_tissues::frame_arena
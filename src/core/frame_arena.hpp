@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace soft_tissues::frame_arena {
+
+// Bump allocator for the data which lives within a single frame. Allocation
+// is an atomic pointer bump, so the jobs may allocate from the workers, and
+// freeing is a no-op. Everything is released at once by reset(), so nothing
+// allocated from the arena may outlive the frame.
+void load(size_t n_bytes);
+void unload();
+// Called once per frame after EndDrawing, while no job uses the arena. If the
+// frame didn't fit, the arena grows here, so the next frames fit again
+void reset();
+
+// Falls back to the heap when the arena is full (or not loaded)
+void *allocate(size_t n_bytes, size_t alignment);
+
+size_t get_capacity();
+// Bytes used by the last frame, including the ones which didn't fit
+size_t get_n_used_bytes();
+
+// Standard allocator over the arena, for the containers below
+template <typename T> struct Allocator {
+    using value_type = T;
+
+    Allocator() = default;
+    template <typename U> Allocator(const Allocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(frame_arena::allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *, size_t) {}
+
+    template <typename U> bool operator==(const Allocator<U> &) const {
+        return true;
+    }
+};
+
+template <typename T> using Vector = std::vector<T, Allocator<T>>;
+
+}  // namespace soft_tissues::frame_arena
@@ -0,0 +1,107 @@
+#include "gl.hpp"
+
+#include "GLFW/glfw3.h"
+#include <stdexcept>
+#include <string>
+
+namespace soft_tissues::gl {
+
+const unsigned char *(*GetString)(GLenum name) = nullptr;
+void (*GetIntegerv)(GLenum pname, GLint *data) = nullptr;
+
+GLuint (*CreateProgram)() = nullptr;
+void (*DeleteProgram)(GLuint program) = nullptr;
+void (*AttachShader)(GLuint program, GLuint shader) = nullptr;
+void (*DetachShader)(GLuint program, GLuint shader) = nullptr;
+void (*DeleteShader)(GLuint shader) = nullptr;
+void (*LinkProgram)(GLuint program) = nullptr;
+void (*GetProgramiv)(GLuint program, GLenum pname, GLint *params) = nullptr;
+void (*GetProgramInfoLog)(
+    GLuint program, GLsizei buf_size, GLsizei *length, char *info_log
+) = nullptr;
+void (*ProgramParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+void (*GetProgramBinary)(
+    GLuint program, GLsizei buf_size, GLsizei *length, GLenum *binary_format, void *binary
+) = nullptr;
+void (*ProgramBinary)(
+    GLuint program, GLenum binary_format, const void *binary, GLsizei length
+) = nullptr;
+
+void (*GenQueries)(GLsizei n, GLuint *ids) = nullptr;
+void (*DeleteQueries)(GLsizei n, const GLuint *ids) = nullptr;
+void (*BeginQuery)(GLenum target, GLuint id) = nullptr;
+void (*EndQuery)(GLenum target) = nullptr;
+void (*GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params) = nullptr;
+
+void (*GenTextures)(GLsizei n, GLuint *textures) = nullptr;
+void (*DeleteTextures)(GLsizei n, const GLuint *textures) = nullptr;
+void (*BindTexture)(GLenum target, GLuint texture) = nullptr;
+void (*ActiveTexture)(GLenum texture) = nullptr;
+void (*TexParameteri)(GLenum target, GLenum pname, GLint param) = nullptr;
+void (*TexStorage3D)(
+    GLenum target, GLsizei levels, GLenum internal_format,
+    GLsizei width, GLsizei height, GLsizei depth
+) = nullptr;
+void (*TexSubImage3D)(
+    GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+    GLsizei width, GLsizei height, GLsizei depth,
+    GLenum format, GLenum type, const void *pixels
+) = nullptr;
+void (*GenerateMipmap)(GLenum target) = nullptr;
+
+void (*GenBuffers)(GLsizei n, GLuint *buffers) = nullptr;
+void (*DeleteBuffers)(GLsizei n, const GLuint *buffers) = nullptr;
+void (*BindBuffer)(GLenum target, GLuint buffer) = nullptr;
+void (*BindBufferBase)(GLenum target, GLuint index, GLuint buffer) = nullptr;
+void (*BufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage) = nullptr;
+void (*BufferSubData)(
+    GLenum target, GLintptr offset, GLsizeiptr size, const void *data
+) = nullptr;
+
+template <typename T> static void load_proc(T &proc, const char *name) {
+    proc = reinterpret_cast<T>(glfwGetProcAddress(name));
+    if (!proc) {
+        throw std::runtime_error("Failed to load OpenGL function: " + std::string(name));
+    }
+}
+
+void load() {
+    load_proc(GetString, "glGetString");
+    load_proc(GetIntegerv, "glGetIntegerv");
+
+    load_proc(CreateProgram, "glCreateProgram");
+    load_proc(DeleteProgram, "glDeleteProgram");
+    load_proc(AttachShader, "glAttachShader");
+    load_proc(DetachShader, "glDetachShader");
+    load_proc(DeleteShader, "glDeleteShader");
+    load_proc(LinkProgram, "glLinkProgram");
+    load_proc(GetProgramiv, "glGetProgramiv");
+    load_proc(GetProgramInfoLog, "glGetProgramInfoLog");
+    load_proc(ProgramParameteri, "glProgramParameteri");
+    load_proc(GetProgramBinary, "glGetProgramBinary");
+    load_proc(ProgramBinary, "glProgramBinary");
+
+    load_proc(GenQueries, "glGenQueries");
+    load_proc(DeleteQueries, "glDeleteQueries");
+    load_proc(BeginQuery, "glBeginQuery");
+    load_proc(EndQuery, "glEndQuery");
+    load_proc(GetQueryObjectui64v, "glGetQueryObjectui64v");
+
+    load_proc(GenTextures, "glGenTextures");
+    load_proc(DeleteTextures, "glDeleteTextures");
+    load_proc(BindTexture, "glBindTexture");
+    load_proc(ActiveTexture, "glActiveTexture");
+    load_proc(TexParameteri, "glTexParameteri");
+    load_proc(TexStorage3D, "glTexStorage3D");
+    load_proc(TexSubImage3D, "glTexSubImage3D");
+    load_proc(GenerateMipmap, "glGenerateMipmap");
+
+    load_proc(GenBuffers, "glGenBuffers");
+    load_proc(DeleteBuffers, "glDeleteBuffers");
+    load_proc(BindBuffer, "glBindBuffer");
+    load_proc(BindBufferBase, "glBindBufferBase");
+    load_proc(BufferData, "glBufferData");
+    load_proc(BufferSubData, "glBufferSubData");
+}
+
+}  // namespace soft_tissues::gl
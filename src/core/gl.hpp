@@ -0,0 +1,98 @@
+#pragma once
+
+// OpenGL entry points which are not exposed by rlgl.
+// Resolved through GLFW, so load() must be called after the window is created.
+namespace soft_tissues::gl {
+
+using GLenum = unsigned int;
+using GLuint = unsigned int;
+using GLint = int;
+using GLsizei = int;
+using GLintptr = long;
+using GLsizeiptr = long;
+using GLuint64 = unsigned long long;
+
+// -----------------------------------------------------------------------
+// constants
+constexpr GLenum VENDOR = 0x1F00;
+constexpr GLenum RENDERER = 0x1F01;
+constexpr GLenum VERSION = 0x1F02;
+constexpr GLenum LINK_STATUS = 0x8B82;
+constexpr GLenum INFO_LOG_LENGTH = 0x8B84;
+constexpr GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+constexpr GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+constexpr GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+constexpr GLenum TIME_ELAPSED = 0x88BF;
+constexpr GLenum QUERY_RESULT = 0x8866;
+constexpr GLenum TEXTURE0 = 0x84C0;
+constexpr GLenum TEXTURE_2D_ARRAY = 0x8C1A;
+constexpr GLenum TEXTURE_MIN_FILTER = 0x2801;
+constexpr GLenum TEXTURE_MAG_FILTER = 0x2800;
+constexpr GLenum TEXTURE_WRAP_S = 0x2802;
+constexpr GLenum TEXTURE_WRAP_T = 0x2803;
+constexpr GLenum LINEAR = 0x2601;
+constexpr GLenum LINEAR_MIPMAP_LINEAR = 0x2703;
+constexpr GLenum REPEAT = 0x2901;
+constexpr GLenum RGBA = 0x1908;
+constexpr GLenum RGBA8 = 0x8058;
+constexpr GLenum UNSIGNED_BYTE = 0x1401;
+constexpr GLenum UNIFORM_BUFFER = 0x8A11;
+constexpr GLenum DYNAMIC_DRAW = 0x88E8;
+
+// -----------------------------------------------------------------------
+// functions
+extern const unsigned char *(*GetString)(GLenum name);
+extern void (*GetIntegerv)(GLenum pname, GLint *data);
+
+extern GLuint (*CreateProgram)();
+extern void (*DeleteProgram)(GLuint program);
+extern void (*AttachShader)(GLuint program, GLuint shader);
+extern void (*DetachShader)(GLuint program, GLuint shader);
+extern void (*DeleteShader)(GLuint shader);
+extern void (*LinkProgram)(GLuint program);
+extern void (*GetProgramiv)(GLuint program, GLenum pname, GLint *params);
+extern void (*GetProgramInfoLog)(
+    GLuint program, GLsizei buf_size, GLsizei *length, char *info_log
+);
+extern void (*ProgramParameteri)(GLuint program, GLenum pname, GLint value);
+extern void (*GetProgramBinary)(
+    GLuint program, GLsizei buf_size, GLsizei *length, GLenum *binary_format, void *binary
+);
+extern void (*ProgramBinary)(
+    GLuint program, GLenum binary_format, const void *binary, GLsizei length
+);
+
+extern void (*GenQueries)(GLsizei n, GLuint *ids);
+extern void (*DeleteQueries)(GLsizei n, const GLuint *ids);
+extern void (*BeginQuery)(GLenum target, GLuint id);
+extern void (*EndQuery)(GLenum target);
+extern void (*GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params);
+
+extern void (*GenTextures)(GLsizei n, GLuint *textures);
+extern void (*DeleteTextures)(GLsizei n, const GLuint *textures);
+extern void (*BindTexture)(GLenum target, GLuint texture);
+extern void (*ActiveTexture)(GLenum texture);
+extern void (*TexParameteri)(GLenum target, GLenum pname, GLint param);
+extern void (*TexStorage3D)(
+    GLenum target, GLsizei levels, GLenum internal_format,
+    GLsizei width, GLsizei height, GLsizei depth
+);
+extern void (*TexSubImage3D)(
+    GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset,
+    GLsizei width, GLsizei height, GLsizei depth,
+    GLenum format, GLenum type, const void *pixels
+);
+extern void (*GenerateMipmap)(GLenum target);
+
+extern void (*GenBuffers)(GLsizei n, GLuint *buffers);
+extern void (*DeleteBuffers)(GLsizei n, const GLuint *buffers);
+extern void (*BindBuffer)(GLenum target, GLuint buffer);
+extern void (*BindBufferBase)(GLenum target, GLuint index, GLuint buffer);
+extern void (*BufferData)(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
+extern void (*BufferSubData)(
+    GLenum target, GLintptr offset, GLsizeiptr size, const void *data
+);
+
+void load();
+
+}  // namespace soft_tissues::gl
@@ -0,0 +1,47 @@
+#include "gpu_timer.hpp"
+
+#include "gl.hpp"
+#include "raylib/rlgl.h"
+
+namespace soft_tissues::gpu_timer {
+
+GPUTimer::GPUTimer() = default;
+
+void GPUTimer::begin() {
+    if (this->queries[0] == 0) {
+        gl::GenQueries(N_QUERIES, this->queries.data());
+    }
+
+    // read back the query which is going to be reused,
+    // it was issued N_QUERIES frames ago and is normally ready by now
+    auto query = this->queries[this->n_issued % N_QUERIES];
+    if (this->n_issued >= N_QUERIES) {
+        gl::GLuint64 ns = 0;
+        gl::GetQueryObjectui64v(query, gl::QUERY_RESULT, &ns);
+        this->ms = 0.9 * this->ms + 0.1 * (ns * 1.0e-6);
+    }
+
+    // flush the raylib's batch, so it's not accounted to the measured work
+    rlDrawRenderBatchActive();
+    gl::BeginQuery(gl::TIME_ELAPSED, query);
+}
+
+void GPUTimer::end() {
+    rlDrawRenderBatchActive();
+    gl::EndQuery(gl::TIME_ELAPSED);
+    this->n_issued += 1;
+}
+
+float GPUTimer::get_ms() const {
+    return this->ms;
+}
+
+void GPUTimer::unload() {
+    if (this->queries[0] != 0) {
+        gl::DeleteQueries(N_QUERIES, this->queries.data());
+        this->queries = {};
+        this->n_issued = 0;
+    }
+}
+
+}  // namespace soft_tissues::gpu_timer
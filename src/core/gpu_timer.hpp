@@ -0,0 +1,35 @@
+#pragma once
+
+#include <array>
+
+namespace soft_tissues::gpu_timer {
+
+// Measures the GPU time spent between begin() and end() with GL_TIME_ELAPSED
+// queries. Queries are recycled in a ring and read back N_QUERIES frames later,
+// so the CPU doesn't wait for the GPU to finish the measured work.
+class GPUTimer {
+private:
+    static constexpr int N_QUERIES = 4;
+
+    std::array<unsigned int, N_QUERIES> queries = {};
+    int n_issued = 0;
+    float ms = 0.0;
+
+public:
+    GPUTimer();
+
+    GPUTimer(const GPUTimer &) = delete;
+    GPUTimer &operator=(const GPUTimer &) = delete;
+    GPUTimer(GPUTimer &&) = default;
+    GPUTimer &operator=(GPUTimer &&) = default;
+
+    void begin();
+    void end();
+
+    // Exponential moving average of the measured time, in milliseconds
+    float get_ms() const;
+
+    void unload();
+};
+
+}  // namespace soft_tissues::gpu_timer
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace soft_tissues::handle {
+
+// Index into a HandleMap, typed by the stored value. The generation detects
+// handles which outlived their value: a removed slot bumps its generation, so
+// the old handles fail the check even after the slot is reused.
+template <typename T> struct Handle {
+    static constexpr uint32_t INVALID_IDX = UINT32_MAX;
+
+    uint32_t idx = INVALID_IDX;
+    uint32_t generation = 0;
+
+    bool is_valid() const {
+        return this->idx != INVALID_IDX;
+    }
+
+    bool operator==(const Handle &other) const = default;
+};
+
+// Values stored in slots and addressed by handles. String keys are resolved
+// into handles once (at load or spawn time), so the per-frame code indexes a
+// vector instead of hashing strings.
+template <typename T> class HandleMap {
+private:
+    struct Slot {
+        T value = {};
+        std::string key;
+        uint32_t generation = 1;
+        bool is_alive = false;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> free_idxs;
+    std::unordered_map<std::string, uint32_t> key_to_idx;
+
+    const Slot &get_slot(Handle<T> handle) const {
+        if (!this->is_alive(handle)) {
+            throw std::runtime_error(
+                "Stale or invalid handle: " + std::to_string(handle.idx)
+            );
+        }
+
+        return this->slots[handle.idx];
+    }
+
+public:
+    // Throws if the key is already taken
+    Handle<T> insert(const std::string &key, T value) {
+        if (this->key_to_idx.count(key) != 0) {
+            throw std::runtime_error("Handle key is already taken: " + key);
+        }
+
+        auto handle = this->insert(std::move(value));
+        this->slots[handle.idx].key = key;
+        this->key_to_idx[key] = handle.idx;
+
+        return handle;
+    }
+
+    // Anonymous value, it can't be found by a key
+    Handle<T> insert(T value) {
+        uint32_t idx;
+        if (!this->free_idxs.empty()) {
+            idx = this->free_idxs.back();
+            this->free_idxs.pop_back();
+        } else {
+            idx = this->slots.size();
+            this->slots.emplace_back();
+        }
+
+        Slot &slot = this->slots[idx];
+        slot.value = std::move(value);
+        slot.is_alive = true;
+
+        return {idx, slot.generation};
+    }
+
+    // Returns the removed value, so the caller can unload it
+    T remove(Handle<T> handle) {
+        this->get_slot(handle);
+
+        Slot &slot = this->slots[handle.idx];
+
+        T value = std::move(slot.value);
+        slot.value = {};
+        if (!slot.key.empty()) this->key_to_idx.erase(slot.key);
+        slot.key.clear();
+        slot.is_alive = false;
+        slot.generation += 1;
+        this->free_idxs.push_back(handle.idx);
+
+        return value;
+    }
+
+    bool is_alive(Handle<T> handle) const {
+        return handle.idx < this->slots.size()
+               && this->slots[handle.idx].generation == handle.generation
+               && this->slots[handle.idx].is_alive;
+    }
+
+    // Throws on a stale or invalid handle
+    T &get(Handle<T> handle) {
+        this->get_slot(handle);
+        return this->slots[handle.idx].value;
+    }
+
+    const T &get(Handle<T> handle) const {
+        return this->get_slot(handle).value;
+    }
+
+    const std::string &get_key(Handle<T> handle) const {
+        return this->get_slot(handle).key;
+    }
+
+    // Invalid handle if there is no such key
+    Handle<T> find(const std::string &key) const {
+        auto it = this->key_to_idx.find(key);
+        if (it == this->key_to_idx.end()) return {};
+
+        return {it->second, this->slots[it->second].generation};
+    }
+
+    // Upper bound of the handle indices, for the arrays indexed in parallel
+    size_t get_capacity() const {
+        return this->slots.size();
+    }
+
+    // Calls f(handle, value) for each alive value
+    template <typename F> void for_each(F &&f) {
+        for (uint32_t idx = 0; idx < this->slots.size(); ++idx) {
+            Slot &slot = this->slots[idx];
+            if (slot.is_alive) f(Handle<T>{idx, slot.generation}, slot.value);
+        }
+    }
+
+    void clear() {
+        this->slots.clear();
+        this->free_idxs.clear();
+        this->key_to_idx.clear();
+    }
+};
+
+}  // namespace soft_tissues::handle
@@ -0,0 +1,302 @@
+#include "jobs.hpp"
+
+#include "raylib/raylib.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace soft_tissues::jobs {
+
+struct Job {
+    std::function<void()> fn;
+    Group *group;
+};
+
+// Ring buffer of jobs: once grown to the peak size, the pushes and pops of
+// the steady state frames don't allocate
+struct Queue {
+    std::mutex mutex;
+    std::vector<Job> jobs = std::vector<Job>(64);
+    size_t head = 0;
+    size_t n_jobs = 0;
+
+    Job &at(size_t idx) {
+        return this->jobs[(this->head + idx) % this->jobs.size()];
+    }
+
+    void push_back(Job job) {
+        if (this->n_jobs == this->jobs.size()) {
+            std::vector<Job> jobs(2 * this->jobs.size());
+            for (size_t i = 0; i < this->n_jobs; ++i) {
+                jobs[i] = std::move(this->at(i));
+            }
+
+            this->jobs = std::move(jobs);
+            this->head = 0;
+        }
+
+        this->at(this->n_jobs++) = std::move(job);
+    }
+
+    Job pop_back() {
+        return std::move(this->at(--this->n_jobs));
+    }
+
+    Job pop_front() {
+        Job job = std::move(this->at(0));
+        this->head = (this->head + 1) % this->jobs.size();
+        --this->n_jobs;
+
+        return job;
+    }
+
+    // The back job takes the place of the popped one
+    Job pop_at(size_t idx) {
+        Job job = std::move(this->at(idx));
+        if (idx != this->n_jobs - 1) {
+            this->at(idx) = std::move(this->at(this->n_jobs - 1));
+        }
+        --this->n_jobs;
+
+        return job;
+    }
+};
+
+static bool IS_LOADED = false;
+static bool IS_STOPPING = false;
+
+static std::vector<std::thread> WORKERS;
+
+// One queue per worker, the last one is shared by the non-worker threads
+static std::vector<std::unique_ptr<Queue>> QUEUES;
+static std::mutex BACKGROUND_MUTEX;
+static std::deque<std::function<void()>> BACKGROUND_JOBS;
+// the jobs of all queues, the background ones included
+static std::atomic<int> N_QUEUED = 0;
+
+static std::mutex SLEEP_MUTEX;
+static std::condition_variable SLEEP_CONDITION;
+
+static thread_local int WORKER_IDX = -1;
+
+// -----------------------------------------------------------------------
+// queues
+
+static int get_own_queue_idx() {
+    return WORKER_IDX >= 0 ? WORKER_IDX : (int)WORKERS.size();
+}
+
+// The empty critical section orders the increment with the sleeping
+// worker's predicate check, so the notification is not lost
+static void notify_queued() {
+    N_QUEUED.fetch_add(1);
+    { std::lock_guard<std::mutex> lock(SLEEP_MUTEX); }
+    SLEEP_CONDITION.notify_one();
+}
+
+static void push_job(Job job) {
+    Queue &queue = *QUEUES[get_own_queue_idx()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.push_back(std::move(job));
+    }
+
+    notify_queued();
+}
+
+// The own queue is popped from the back (the most recent, cache-warm job),
+// the other ones are stolen from the front (the oldest, usually the largest)
+static bool pop_job(Job &job) {
+    int n_queues = QUEUES.size();
+    int own_idx = get_own_queue_idx();
+
+    for (int i = 0; i < n_queues; ++i) {
+        int idx = (own_idx + i) % n_queues;
+        Queue &queue = *QUEUES[idx];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.n_jobs == 0) continue;
+
+        job = idx == own_idx ? queue.pop_back() : queue.pop_front();
+
+        N_QUEUED.fetch_sub(1);
+        return true;
+    }
+
+    return false;
+}
+
+// Pops any job of the given group, wherever it's queued
+static bool pop_group_job(Job &job, const Group &group) {
+    for (auto &queue : QUEUES) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+
+        for (size_t i = 0; i < queue->n_jobs; ++i) {
+            if (queue->at(i).group != &group) continue;
+
+            job = queue->pop_at(i);
+
+            N_QUEUED.fetch_sub(1);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool pop_background_job(std::function<void()> &job) {
+    std::lock_guard<std::mutex> lock(BACKGROUND_MUTEX);
+    if (BACKGROUND_JOBS.empty()) return false;
+
+    job = std::move(BACKGROUND_JOBS.front());
+    BACKGROUND_JOBS.pop_front();
+
+    N_QUEUED.fetch_sub(1);
+    return true;
+}
+
+static void execute_job(Job &job) {
+    Group &group = *job.group;
+
+    try {
+        job.fn();
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        if (!group.exception) group.exception = std::current_exception();
+    }
+
+    // the group may be destroyed by the waiter right after this
+    group.n_pending.fetch_sub(1, std::memory_order_release);
+}
+
+static void run_worker(int worker_idx) {
+    WORKER_IDX = worker_idx;
+
+    while (true) {
+        Job job;
+        if (pop_job(job)) {
+            execute_job(job);
+            continue;
+        }
+
+        std::function<void()> background_job;
+        if (pop_background_job(background_job)) {
+            background_job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(SLEEP_MUTEX);
+        SLEEP_CONDITION.wait(lock, []() { return IS_STOPPING || N_QUEUED.load() > 0; });
+        if (IS_STOPPING && N_QUEUED.load() == 0) return;
+    }
+}
+
+// -----------------------------------------------------------------------
+// jobs
+
+void load(int n_workers) {
+    if (IS_LOADED) {
+        throw std::runtime_error("Jobs are already loaded");
+    }
+
+    IS_LOADED = true;
+    IS_STOPPING = false;
+
+    for (int i = 0; i < n_workers + 1; ++i) {
+        QUEUES.push_back(std::make_unique<Queue>());
+    }
+
+    for (int i = 0; i < n_workers; ++i) {
+        WORKERS.emplace_back(run_worker, i);
+    }
+
+    if (n_workers == 0) {
+        TraceLog(LOG_INFO, "JOBS: Single-threaded, jobs run inline");
+    } else {
+        TraceLog(LOG_INFO, "JOBS: Started %d workers", n_workers);
+    }
+}
+
+void unload() {
+    if (!IS_LOADED) return;
+
+    {
+        std::lock_guard<std::mutex> lock(SLEEP_MUTEX);
+        IS_STOPPING = true;
+    }
+    SLEEP_CONDITION.notify_all();
+
+    for (auto &worker : WORKERS) {
+        worker.join();
+    }
+
+    WORKERS.clear();
+    QUEUES.clear();
+    IS_LOADED = false;
+}
+
+int get_n_workers() {
+    return WORKERS.size();
+}
+
+bool is_single_threaded() {
+    return WORKERS.empty();
+}
+
+int get_default_n_workers() {
+    int n_threads = std::thread::hardware_concurrency();
+    return std::max(1, n_threads - 1);
+}
+
+void run(Group &group, std::function<void()> job) {
+    group.n_pending.fetch_add(1);
+
+    if (is_single_threaded()) {
+        Job inline_job = {std::move(job), &group};
+        execute_job(inline_job);
+    } else {
+        push_job({std::move(job), &group});
+    }
+}
+
+void run_background(std::function<void()> job) {
+    if (is_single_threaded()) {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(BACKGROUND_MUTEX);
+        BACKGROUND_JOBS.push_back(std::move(job));
+    }
+
+    notify_queued();
+}
+
+void wait(Group &group) {
+    // a non-worker thread helps only with its own group: otherwise the main
+    // thread could pick up the nested job of another thread's long wait
+    bool is_worker = WORKER_IDX >= 0;
+
+    while (group.n_pending.load(std::memory_order_acquire) > 0) {
+        Job job;
+        if (is_worker ? pop_job(job) : pop_group_job(job, group)) {
+            execute_job(job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(group.mutex);
+        std::swap(exception, group.exception);
+    }
+    if (exception) std::rethrow_exception(exception);
+}
+
+}  // namespace soft_tissues::jobs
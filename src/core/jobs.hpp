@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace soft_tissues::jobs {
+
+// Fork/join counter: run() adds jobs to the group, wait() blocks until
+// all of them are finished. The group must outlive its jobs. The first
+// exception thrown by a job is rethrown from wait().
+struct Group {
+    std::atomic<int> n_pending = 0;
+
+    std::mutex mutex;
+    std::exception_ptr exception;
+
+    Group() = default;
+    ~Group() = default;
+
+    Group(const Group &) = delete;
+    Group &operator=(const Group &) = delete;
+    Group(Group &&) = delete;
+    Group &operator=(Group &&) = delete;
+};
+
+// Starts the fixed worker pool. With 0 workers the jobs run inline, at the
+// moment they are submitted and in the submission order: the deterministic
+// single-threaded mode for debugging. Before load() the jobs run inline too.
+void load(int n_workers);
+// Finishes the queued jobs, the background ones included
+void unload();
+
+int get_n_workers();
+bool is_single_threaded();
+// Number of workers which leaves one hardware thread to the main one
+int get_default_n_workers();
+
+// Jobs are pushed into the submitting worker's queue. Idle workers steal
+// from the other queues, so the nested jobs don't need a central queue.
+void run(Group &group, std::function<void()> job);
+
+// The waiting thread executes the queued jobs instead of sleeping
+void wait(Group &group);
+
+// Background jobs (the asset decoding) go to a separate fifo queue. The
+// workers take them only when there are no other jobs and wait() never
+// executes them, so a long background job can't stall a frame-time wait.
+// The job must not throw, submit_background() forwards the exception.
+void run_background(std::function<void()> job);
+
+template <typename F> std::future<std::invoke_result_t<F>> submit_background(F &&f) {
+    using R = std::invoke_result_t<F>;
+
+    // std::function must be copyable, so the task is shared
+    auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+    std::future<R> future = task->get_future();
+    run_background([task]() { (*task)(); });
+
+    return future;
+}
+
+// Calls f(chunk_begin, chunk_end) over [begin, end) split into the chunks of
+// grain_size elements, the chunks are executed in parallel. Each chunk is
+// independent, f must not depend on their execution order.
+template <typename F> void parallel_for(int begin, int end, int grain_size, F &&f) {
+    if (end <= begin) return;
+
+    grain_size = std::max(1, grain_size);
+    if (is_single_threaded() || end - begin <= grain_size) {
+        for (int i = begin; i < end; i += grain_size) {
+            f(i, std::min(end, i + grain_size));
+        }
+        return;
+    }
+
+    Group group;
+    for (int i = begin; i < end; i += grain_size) {
+        int chunk_end = std::min(end, i + grain_size);
+        run(group, [&f, i, chunk_end]() { f(i, chunk_end); });
+    }
+    wait(group);
+}
+
+}  // namespace soft_tissues::jobs
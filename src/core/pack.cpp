@@ -0,0 +1,280 @@
+#include "pack.hpp"
+
+#include "raylib/raylib.h"
+#include "utils.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <utility>
+
+namespace soft_tissues::pack {
+
+// "STPK" - soft tissues pack
+static constexpr uint32_t PACK_FILE_MAGIC = 0x4b505453;
+static constexpr uint32_t PACK_FILE_VERSION = 1;
+
+// Followed by the n_entries toc entries, the paths string table and the blobs
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_entries;
+    uint32_t paths_size;
+};
+
+struct PackEntry {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t hash;
+    uint32_t path_offset;
+    uint32_t path_size;
+};
+
+static const unsigned char *PACK_DATA = nullptr;
+static size_t PACK_SIZE = 0;
+static std::unordered_map<std::string_view, PackEntry> ENTRIES;
+
+// Paths are stored relative to the working directory, with forward slashes
+static std::string get_entry_path(const std::string &path) {
+    std::filesystem::path fs_path(path);
+    if (fs_path.is_absolute()) {
+        fs_path = fs_path.lexically_proximate(std::filesystem::current_path());
+    }
+
+    return fs_path.lexically_normal().generic_string();
+}
+
+static std::span<const unsigned char> get_entry_data(const PackEntry &entry) {
+    return {PACK_DATA + entry.offset, entry.size};
+}
+
+// -----------------------------------------------------------------------
+// mounting
+static void parse_toc() {
+    PackHeader header;
+    if (PACK_SIZE < sizeof(header)) throw std::runtime_error("Pack is truncated");
+    std::memcpy(&header, PACK_DATA, sizeof(header));
+
+    if (header.magic != PACK_FILE_MAGIC || header.version != PACK_FILE_VERSION) {
+        throw std::runtime_error("Pack has unsupported format");
+    }
+
+    // the bounds are checked by the subtractions from the known sizes, so the
+    // corrupted offsets and sizes can't wrap the sums around
+    size_t toc_offset = sizeof(header);
+    if (header.n_entries > (PACK_SIZE - toc_offset) / sizeof(PackEntry)) {
+        throw std::runtime_error("Pack table of contents is truncated");
+    }
+
+    size_t paths_offset = toc_offset + header.n_entries * sizeof(PackEntry);
+    if (header.paths_size > PACK_SIZE - paths_offset) {
+        throw std::runtime_error("Pack table of contents is truncated");
+    }
+
+    auto paths = reinterpret_cast<const char *>(PACK_DATA + paths_offset);
+    for (uint32_t i = 0; i < header.n_entries; ++i) {
+        PackEntry entry;
+        std::memcpy(&entry, PACK_DATA + toc_offset + i * sizeof(entry), sizeof(entry));
+
+        if (entry.path_offset > header.paths_size
+            || entry.path_size > header.paths_size - entry.path_offset
+            || entry.offset > PACK_SIZE || entry.size > PACK_SIZE - entry.offset) {
+            throw std::runtime_error("Pack entry is out of bounds");
+        }
+
+        std::string_view path(paths + entry.path_offset, entry.path_size);
+        ENTRIES[path] = entry;
+    }
+}
+
+bool mount(const std::string &file_path) {
+    unmount();
+
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd == -1) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat pack: " + file_path);
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file referenced
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map pack: " + file_path);
+    }
+
+    PACK_DATA = static_cast<const unsigned char *>(data);
+    PACK_SIZE = st.st_size;
+
+    try {
+        parse_toc();
+    } catch (const std::runtime_error &e) {
+        unmount();
+        throw std::runtime_error(std::string(e.what()) + ": " + file_path);
+    }
+
+    TraceLog(
+        LOG_INFO,
+        "PACK: Mounted %zu files (%.2f MB): %s",
+        ENTRIES.size(),
+        PACK_SIZE / (1024.0 * 1024.0),
+        file_path.c_str()
+    );
+
+    return true;
+}
+
+void unmount() {
+    if (PACK_DATA == nullptr) return;
+
+    munmap(const_cast<unsigned char *>(PACK_DATA), PACK_SIZE);
+    PACK_DATA = nullptr;
+    PACK_SIZE = 0;
+    ENTRIES.clear();
+}
+
+bool is_mounted() {
+    return PACK_DATA != nullptr;
+}
+
+int verify() {
+    int n_corrupted = 0;
+    for (const auto &[path, entry] : ENTRIES) {
+        auto data = get_entry_data(entry);
+        if (utils::hash_fnv1a(data.data(), data.size()) != entry.hash) {
+            TraceLog(
+                LOG_WARNING,
+                "PACK: Blob is corrupted: %.*s",
+                (int)path.size(),
+                path.data()
+            );
+            n_corrupted += 1;
+        }
+    }
+
+    return n_corrupted;
+}
+
+std::span<const unsigned char> find(const std::string &path) {
+    if (PACK_DATA == nullptr) return {};
+
+    auto it = ENTRIES.find(get_entry_path(path));
+    if (it == ENTRIES.end()) return {};
+
+    return get_entry_data(it->second);
+}
+
+// -----------------------------------------------------------------------
+// files
+File::File() = default;
+
+File::File(std::vector<unsigned char> storage)
+    : storage(std::move(storage))
+    , data(this->storage)
+    , is_loaded_(true) {}
+
+File::File(std::span<const unsigned char> data)
+    : data(data)
+    , is_loaded_(true) {}
+
+bool File::is_loaded() const {
+    return this->is_loaded_;
+}
+
+std::span<const unsigned char> File::get_data() const {
+    return this->data;
+}
+
+std::string_view File::get_str() const {
+    return {reinterpret_cast<const char *>(this->data.data()), this->data.size()};
+}
+
+static bool read_loose_file(const std::string &path, std::vector<unsigned char> &data) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) return false;
+
+    data.resize(file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(data.data()), data.size());
+
+    return !file.fail();
+}
+
+File load_file(const std::string &path) {
+    std::vector<unsigned char> data;
+    if (read_loose_file(path, data)) return File(std::move(data));
+
+    auto view = find(path);
+    if (view.data() != nullptr) return File(view);
+
+    return File();
+}
+
+// -----------------------------------------------------------------------
+// building
+static size_t align_up(size_t offset) {
+    return (offset + BLOB_ALIGNMENT - 1) / BLOB_ALIGNMENT * BLOB_ALIGNMENT;
+}
+
+void write(const std::string &file_path, const std::vector<std::string> &paths) {
+    std::vector<std::vector<unsigned char>> blobs(paths.size());
+    std::vector<PackEntry> entries(paths.size());
+    std::string paths_table;
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!read_loose_file(paths[i], blobs[i])) {
+            throw std::runtime_error("Failed to read file for pack: " + paths[i]);
+        }
+
+        auto path = get_entry_path(paths[i]);
+        entries[i].size = blobs[i].size();
+        entries[i].hash = utils::hash_fnv1a(blobs[i].data(), blobs[i].size());
+        entries[i].path_offset = paths_table.size();
+        entries[i].path_size = path.size();
+        paths_table += path;
+    }
+
+    PackHeader header = {
+        PACK_FILE_MAGIC, PACK_FILE_VERSION, (uint32_t)paths.size(), (uint32_t)paths_table.size()
+    };
+
+    size_t offset = sizeof(header) + entries.size() * sizeof(PackEntry) + paths_table.size();
+    for (auto &entry : entries) {
+        offset = align_up(offset);
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    // the same temporary file trick as in the shader cache
+    auto tmp_file_path = file_path + ".tmp";
+    {
+        std::ofstream file(tmp_file_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(
+            reinterpret_cast<const char *>(entries.data()),
+            entries.size() * sizeof(PackEntry)
+        );
+        file.write(paths_table.data(), paths_table.size());
+
+        for (size_t i = 0; i < blobs.size(); ++i) {
+            static const char padding[BLOB_ALIGNMENT] = {};
+            file.write(padding, entries[i].offset - file.tellp());
+            file.write(reinterpret_cast<const char *>(blobs[i].data()), blobs[i].size());
+        }
+
+        if (!file) throw std::runtime_error("Failed to write pack: " + file_path);
+    }
+
+    std::filesystem::rename(tmp_file_path, file_path);
+}
+
+}  // namespace soft_tissues::pack
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace soft_tissues::pack {
+
+// Asset pack is a single file with a table of contents and the file contents
+// (blobs) aligned to BLOB_ALIGNMENT. The mounted pack is memory-mapped once and
+// the loaders get views into the mapping instead of copies. Blobs are keyed by
+// their paths relative to the working directory, e.g. "resources/worlds/world.json".
+//
+// Loose files take priority over the pack, so the assets can be edited during
+// the development with a pack around, while a shipped build has the pack only.
+inline constexpr size_t BLOB_ALIGNMENT = 64;
+
+// -----------------------------------------------------------------------
+// mounting
+// Returns false if there is no pack at the path. Throws if the pack is corrupted
+bool mount(const std::string &file_path);
+void unmount();
+bool is_mounted();
+
+// Checks the content hashes of all blobs, returns the number of corrupted ones
+int verify();
+
+// Empty span if the pack is not mounted or has no such blob
+std::span<const unsigned char> find(const std::string &path);
+
+// -----------------------------------------------------------------------
+// files
+// Contents of an asset file. A view into the pack stays valid until unmount()
+class File {
+private:
+    std::vector<unsigned char> storage;
+    std::span<const unsigned char> data;
+    bool is_loaded_ = false;
+
+public:
+    File();
+    explicit File(std::vector<unsigned char> storage);
+    explicit File(std::span<const unsigned char> data);
+
+    File(const File &) = delete;
+    File &operator=(const File &) = delete;
+    File(File &&) = default;
+    File &operator=(File &&) = default;
+
+    bool is_loaded() const;
+    std::span<const unsigned char> get_data() const;
+    std::string_view get_str() const;
+};
+
+// Reads the loose file or finds it in the pack. Not loaded if there is neither
+File load_file(const std::string &path);
+
+// -----------------------------------------------------------------------
+// building
+// Packs the files, throws if any of them can't be read
+void write(const std::string &file_path, const std::vector<std::string> &paths);
+
+}  // namespace soft_tissues::pack
@@ -1,71 +1,119 @@
 #include "pbr.hpp"
 
+#include "gl.hpp"
+#include "pack.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
 #include "raylib/rlgl.h"
+#include "serializers.hpp"
 #include "utils.hpp"
+#include "vram.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
 #include <stdexcept>
+#include <string>
+#include <utility>
 
 namespace soft_tissues::pbr {
 
 using namespace utils;
 
+// -----------------------------------------------------------------------
+// ShaderVariant
+bool ShaderVariant::is_lit() const {
+    return !is_shadow_map_pass && is_light_enabled;
+}
+
+uint32_t ShaderVariant::get_key() const {
+    uint32_t key = 0;
+    // is_light_enabled doesn't matter for the shadow map pass
+    if (is_shadow_map_pass) key |= 1 << 0;
+    else if (!is_light_enabled) key |= 1 << 1;
+    if (has_displacement) key |= 1 << 2;
+    if (is_instanced) key |= 1 << 3;
+
+    return key;
+}
+
+std::vector<std::string> ShaderVariant::get_defines() const {
+    std::vector<std::string> defines;
+    defines.push_back("MAX_N_LIGHTS " + std::to_string(render_config::MAX_N_LIGHTS));
+    defines.push_back("MAX_N_MATERIALS " + std::to_string(render_config::MAX_N_MATERIALS));
+    defines.push_back(
+        "LIGHTS_BUFFER_BINDING " + std::to_string(render_config::LIGHTS_BUFFER_BINDING)
+    );
+
+    if (is_shadow_map_pass) defines.push_back("SHADOW_MAP_PASS");
+    else if (!is_light_enabled) defines.push_back("UNLIT");
+    if (has_displacement) defines.push_back("DISPLACEMENT");
+    if (is_instanced) defines.push_back("INSTANCING");
+
+    return defines;
+}
+
 // -----------------------------------------------------------------------
 // PBRShader
 PBRShader::PBRShader() = default;
 
-PBRShader::PBRShader(const std::string &vs_file, const std::string &fs_file) {
-    shader = load_shader(vs_file, fs_file);
+PBRShader::PBRShader(
+    const std::string &vs_file, const std::string &fs_file, ShaderVariant variant
+)
+    : variant(variant) {
+    shader = load_shader(vs_file, fs_file, variant.get_defines());
+
+    // NOTE: Depending on the variant some inputs are compiled out,
+    // so only the ones which every variant uses are required
+    bool is_lit = variant.is_lit();
 
     // vertex attributes
     shader.locs[SHADER_LOC_VERTEX_POSITION] = get_attribute_loc(shader, "a_position");
-    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = get_attribute_loc(shader, "a_tex_coord");
-    shader.locs[SHADER_LOC_VERTEX_NORMAL] = get_attribute_loc(shader, "a_normal");
-    shader.locs[SHADER_LOC_VERTEX_TANGENT] = get_attribute_loc(shader, "a_tangent");
+    shader.locs[SHADER_LOC_VERTEX_TEXCOORD01] = get_attribute_loc(shader, "a_tex_coord", true);
+    shader.locs[SHADER_LOC_VERTEX_NORMAL] = get_attribute_loc(shader, "a_normal", true);
+    shader.locs[SHADER_LOC_VERTEX_TANGENT] = get_attribute_loc(shader, "a_tangent", !is_lit);
 
-    // matrix uniforms (used by raylib's DrawMesh)
+    // matrix uniforms (used by raylib's DrawMesh and DrawMeshInstanced)
     shader.locs[SHADER_LOC_MATRIX_MVP] = get_uniform_loc(shader, "u_mvp_mat");
-    shader.locs[SHADER_LOC_MATRIX_MODEL] = get_uniform_loc(shader, "u_model_mat");
-    shader.locs[SHADER_LOC_MATRIX_NORMAL] = get_uniform_loc(shader, "u_normal_mat");
+    if (variant.is_instanced) {
+        // DrawMeshInstanced streams instance transforms into this attribute
+        shader.locs[SHADER_LOC_MATRIX_MODEL] = get_attribute_loc(
+            shader, "a_instance_transform"
+        );
+        shader.locs[SHADER_LOC_MATRIX_NORMAL] = -1;
+    } else {
+        shader.locs[SHADER_LOC_MATRIX_MODEL] = get_uniform_loc(shader, "u_model_mat");
+        shader.locs[SHADER_LOC_MATRIX_NORMAL] = get_uniform_loc(shader, "u_normal_mat", true);
+    }
 
-    // texture map uniforms (used by raylib's DrawMesh)
-    shader.locs[SHADER_LOC_MAP_ALBEDO] = get_uniform_loc(shader, "u_albedo_map");
-    shader.locs[SHADER_LOC_MAP_METALNESS] = get_uniform_loc(shader, "u_metalness_map");
-    shader.locs[SHADER_LOC_MAP_NORMAL] = get_uniform_loc(shader, "u_normal_map");
-    shader.locs[SHADER_LOC_MAP_ROUGHNESS] = get_uniform_loc(shader, "u_roughness_map");
-    shader.locs[SHADER_LOC_MAP_OCCLUSION] = get_uniform_loc(shader, "u_occlusion_map");
-    shader.locs[SHADER_LOC_MAP_HEIGHT] = get_uniform_loc(shader, "u_height_map");
+    // material map arrays (bound by MaterialArray, so the slots never change)
+    bool has_ormh_maps = is_lit || variant.has_displacement;
+    std::array<std::pair<const char *, bool>, 3> map_samplers = {{
+        {"u_albedo_maps", !variant.is_shadow_map_pass},
+        {"u_normal_maps", is_lit},
+        {"u_ormh_maps", has_ormh_maps},
+    }};
+    for (int i = 0; i < (int)map_samplers.size(); ++i) {
+        auto [name, is_used] = map_samplers[i];
+        int loc = get_uniform_loc(shader, name, !is_used);
+        int slot = render_config::MATERIAL_MAPS_TEXTURE_SLOT_OFFSET + i;
+        if (loc != -1) SetShaderValue(shader, loc, &slot, SHADER_UNIFORM_INT);
+    }
 
     // per-draw uniforms
-    is_shadow_map_pass_loc = get_uniform_loc(shader, "u_is_shadow_map_pass");
-    camera_pos_loc = get_uniform_loc(shader, "u_camera_pos");
-    is_light_enabled_loc = get_uniform_loc(shader, "u_is_light_enabled");
-    constant_color_loc = get_uniform_loc(shader, "u_constant_color");
-    shadow_map_bias_loc = get_uniform_loc(shader, "u_shadow_map_bias");
-    shadow_map_max_dist_loc = get_uniform_loc(shader, "u_shadow_map_max_dist");
-    n_lights_loc = get_uniform_loc(shader, "u_n_lights");
-    tiling_loc = get_uniform_loc(shader, "u_tiling");
-    displacement_scale_loc = get_uniform_loc(shader, "u_displacement_scale");
-
-    // per-light uniforms (resolve for all array indices)
-    for (int i = 0; i < render_config::MAX_N_LIGHTS; ++i) {
-        std::string prefix = "u_lights[" + std::to_string(i) + "].";
-        auto &ll = light_locs[i];
-
-        ll.position = get_uniform_loc(shader, prefix + "position");
-        ll.type = get_uniform_loc(shader, prefix + "type");
-        ll.color = get_uniform_loc(shader, prefix + "color");
-        ll.intensity = get_uniform_loc(shader, prefix + "intensity");
-        ll.casts_shadows = get_uniform_loc(shader, prefix + "casts_shadows");
-        ll.vp_mat = get_uniform_loc(shader, prefix + "vp_mat");
-        ll.direction = get_uniform_loc(shader, prefix + "direction");
-        ll.attenuation = get_uniform_loc(shader, prefix + "attenuation");
-        ll.inner_cutoff = get_uniform_loc(shader, prefix + "inner_cutoff");
-        ll.outer_cutoff = get_uniform_loc(shader, prefix + "outer_cutoff");
-
-        ll.shadow_map = GetShaderLocation(
-            shader, TextFormat("u_shadow_maps[%d]", i)
-        );
+    camera_pos_loc = get_uniform_loc(shader, "u_camera_pos", true);
+    constant_color_loc = get_uniform_loc(shader, "u_constant_color", true);
+    shadow_map_bias_loc = get_uniform_loc(shader, "u_shadow_map_bias", !is_lit);
+    shadow_map_max_dist_loc = get_uniform_loc(shader, "u_shadow_map_max_dist", true);
+    material_layer_loc = get_uniform_loc(shader, "u_material_layer", variant.is_instanced);
+    material_params_loc = get_uniform_loc(shader, "u_material_params[0]");
+
+    // shadow maps (the light i samples the slot of the same offset, the
+    // maps themselves are bound by system::lighting)
+    for (int i = 0; i < render_config::MAX_N_SHADOW_MAPS; ++i) {
+        int loc = GetShaderLocation(shader, TextFormat("u_shadow_maps[%d]", i));
+        int slot = render_config::SHADOW_MAP_TEXTURE_SLOT_OFFSET + i;
+        if (loc != -1) SetShaderValue(shader, loc, &slot, SHADER_UNIFORM_INT);
     }
 }
 
@@ -73,24 +121,18 @@ Shader PBRShader::get_shader() const {
     return shader;
 }
 
-void PBRShader::unload() {
-    UnloadShader(shader);
+ShaderVariant PBRShader::get_variant() const {
+    return variant;
 }
 
-void PBRShader::set_shadow_map_pass(bool value) {
-    int v = static_cast<int>(value);
-    SetShaderValue(shader, is_shadow_map_pass_loc, &v, SHADER_UNIFORM_INT);
+void PBRShader::unload() {
+    UnloadShader(shader);
 }
 
 void PBRShader::set_camera_pos(Vector3 pos) {
     SetShaderValue(shader, camera_pos_loc, &pos, SHADER_UNIFORM_VEC3);
 }
 
-void PBRShader::set_light_enabled(bool value) {
-    int v = static_cast<int>(value);
-    SetShaderValue(shader, is_light_enabled_loc, &v, SHADER_UNIFORM_INT);
-}
-
 void PBRShader::set_constant_color(Color color) {
     Vector4 v = ColorNormalize(color);
     SetShaderValue(shader, constant_color_loc, &v, SHADER_UNIFORM_VEC4);
@@ -104,80 +146,549 @@ void PBRShader::set_shadow_map_max_dist(float dist) {
     SetShaderValue(shader, shadow_map_max_dist_loc, &dist, SHADER_UNIFORM_FLOAT);
 }
 
-void PBRShader::set_n_lights(int n) {
-    SetShaderValue(shader, n_lights_loc, &n, SHADER_UNIFORM_INT);
+void PBRShader::set_material_layer(int layer) {
+    SetShaderValue(shader, material_layer_loc, &layer, SHADER_UNIFORM_INT);
+}
+
+void PBRShader::set_material_params(const std::vector<Vector4> &params) {
+    SetShaderValueV(
+        shader, material_params_loc, params.data(), SHADER_UNIFORM_VEC4, params.size()
+    );
+}
+
+// -----------------------------------------------------------------------
+// PBRShaderCache
+PBRShaderCache::PBRShaderCache() = default;
+
+PBRShaderCache::PBRShaderCache(std::string vs_file, std::string fs_file)
+    : vs_file(std::move(vs_file))
+    , fs_file(std::move(fs_file)) {}
+
+PBRShader &PBRShaderCache::get(ShaderVariant variant) {
+    uint32_t key = variant.get_key();
+
+    auto &shader = this->shaders[key];
+    if (shader) return *shader;
+
+    shader.emplace(this->vs_file, this->fs_file, variant);
+    TraceLog(LOG_INFO, "PBR: Compiled shader variant %u", key);
+
+    return *shader;
+}
+
+bool PBRShaderCache::uses_file(const std::string &file_name) const {
+    return file_name == this->vs_file || file_name == this->fs_file
+           || file_name == "common.glsl";
+}
+
+int PBRShaderCache::reload() {
+    int n_reloaded = 0;
+    for (auto &shader : this->shaders) {
+        if (!shader) continue;
+
+        try {
+            PBRShader reloaded(this->vs_file, this->fs_file, shader->get_variant());
+            shader->unload();
+            shader = std::move(reloaded);
+            n_reloaded += 1;
+        } catch (const std::runtime_error &e) {
+            TraceLog(
+                LOG_WARNING,
+                "PBR: Shader variant %u is not reloaded: %s",
+                shader->get_variant().get_key(),
+                e.what()
+            );
+        }
+    }
+
+    return n_reloaded;
+}
+
+void PBRShaderCache::unload() {
+    for (auto &shader : this->shaders) {
+        if (shader) shader->unload();
+        shader.reset();
+    }
+}
+
+// -----------------------------------------------------------------------
+// material manifest
+std::string map_type_to_str(MapType type) {
+    switch (type) {
+        case MapType::ALBEDO: return "albedo";
+        case MapType::NORMAL: return "normal";
+        case MapType::OCCLUSION: return "occlusion";
+        case MapType::ROUGHNESS: return "roughness";
+        case MapType::METALNESS: return "metalness";
+        case MapType::HEIGHT: return "height";
+        default: throw std::runtime_error("Failed to get map type name");
+    }
+}
+
+MapType str_to_map_type(const std::string &str) {
+    if (str == "albedo") return MapType::ALBEDO;
+    if (str == "normal") return MapType::NORMAL;
+    if (str == "occlusion") return MapType::OCCLUSION;
+    if (str == "roughness") return MapType::ROUGHNESS;
+    if (str == "metalness") return MapType::METALNESS;
+    if (str == "height") return MapType::HEIGHT;
+    throw std::runtime_error("Invalid map type string: " + str);
+}
+
+bool MaterialDesc::has_map(MapType type) const {
+    return this->has_maps[static_cast<int>(type)];
+}
+
+nlohmann::json MaterialDesc::to_json() const {
+    nlohmann::json json;
+
+    json["tiling"] = this->tiling;
+    json["displacement_scale"] = this->displacement_scale;
+
+    json["maps"] = nlohmann::json::array();
+    for (auto type : MAP_TYPES) {
+        if (this->has_map(type)) json["maps"].push_back(map_type_to_str(type));
+    }
+
+    return json;
+}
+
+MaterialDesc MaterialDesc::from_json(
+    const std::string &key, const nlohmann::json &json_data
+) {
+    MaterialDesc desc;
+    desc.key = key;
+    desc.tiling = json_data.value("tiling", Vector2{1.0, 1.0});
+    desc.displacement_scale = json_data.value("displacement_scale", 0.0f);
+
+    for (const auto &map_json : json_data["maps"]) {
+        auto type = str_to_map_type(map_json.get<std::string>());
+        desc.has_maps[static_cast<int>(type)] = true;
+    }
+
+    return desc;
+}
+
+std::vector<MaterialDesc> load_material_manifest(const std::string &file_path) {
+    auto file = pack::load_file(file_path);
+    if (!file.is_loaded()) {
+        throw std::runtime_error("Failed to open material manifest: " + file_path);
+    }
+
+    auto json = nlohmann::json::parse(file.get_str());
+
+    auto dir_path = std::filesystem::path(file_path).parent_path();
+
+    std::vector<MaterialDesc> descs;
+    for (const auto &[key, material_json] : json["materials"].items()) {
+        MaterialDesc desc = MaterialDesc::from_json(key, material_json);
+        desc.dir_path = (dir_path / key).string() + "/";
+        descs.push_back(std::move(desc));
+    }
+
+    std::sort(descs.begin(), descs.end(), [](const auto &a, const auto &b) {
+        return a.key < b.key;
+    });
+
+    return descs;
+}
+
+// -----------------------------------------------------------------------
+// MaterialArray
+int MaterialArray::get_n_levels(int size) {
+    return 1 + std::floor(std::log2(size));
+}
+
+static unsigned int create_texture_array(int size, int n_levels, int n_layers) {
+    unsigned int id = 0;
+    gl::GenTextures(1, &id);
+    gl::BindTexture(gl::TEXTURE_2D_ARRAY, id);
+    gl::TexStorage3D(gl::TEXTURE_2D_ARRAY, n_levels, gl::RGBA8, size, size, n_layers);
+    gl::TexParameteri(gl::TEXTURE_2D_ARRAY, gl::TEXTURE_MIN_FILTER, gl::LINEAR_MIPMAP_LINEAR);
+    gl::TexParameteri(gl::TEXTURE_2D_ARRAY, gl::TEXTURE_MAG_FILTER, gl::LINEAR);
+    gl::TexParameteri(gl::TEXTURE_2D_ARRAY, gl::TEXTURE_WRAP_S, gl::REPEAT);
+    gl::TexParameteri(gl::TEXTURE_2D_ARRAY, gl::TEXTURE_WRAP_T, gl::REPEAT);
+    gl::BindTexture(gl::TEXTURE_2D_ARRAY, 0);
+
+    return id;
+}
+
+// Uploads the [first_level, end_level) mips of the image mip chain (as laid out
+// by raylib's ImageMipmaps) into the layer
+static void upload_texture_array_layer(
+    unsigned int id, int layer, const Image &image, int first_level, int end_level
+) {
+    gl::BindTexture(gl::TEXTURE_2D_ARRAY, id);
+
+    auto data = static_cast<const unsigned char *>(image.data);
+    int width = image.width;
+    int height = image.height;
+    for (int level = 0; level < end_level; ++level) {
+        if (level >= first_level) {
+            gl::TexSubImage3D(
+                gl::TEXTURE_2D_ARRAY, level, 0, 0, layer,
+                width, height, 1,
+                gl::RGBA, gl::UNSIGNED_BYTE, data
+            );
+        }
+        data += GetPixelDataSize(width, height, image.format);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    gl::BindTexture(gl::TEXTURE_2D_ARRAY, 0);
+}
+
+MaterialArray::MaterialArray() = default;
+
+MaterialArray::MaterialArray(int size, int n_layers)
+    : size(size)
+    , n_levels(get_n_levels(size))
+    , n_layers(n_layers)
+    , params(n_layers, Vector4{1.0, 1.0, 0.0, 0.0}) {
+    if (n_layers > render_config::MAX_N_MATERIALS) {
+        throw std::runtime_error("Material array can't exceed MAX_N_MATERIALS layers");
+    }
+    if (n_layers < 2) {
+        throw std::runtime_error("Material array needs at least 2 layers");
+    }
+
+    this->albedo_id = create_texture_array(size, this->n_levels, n_layers);
+    this->normal_id = create_texture_array(size, this->n_levels, n_layers);
+    this->ormh_id = create_texture_array(size, this->n_levels, n_layers);
+
+    // storage is immutable, so the arrays take their full size upfront
+    size_t map_n_bytes = n_layers * get_map_n_bytes(size, this->n_levels);
+    std::array<const char *, 3> names = {"albedo", "normal", "ormh"};
+    for (int i = 0; i < (int)names.size(); ++i) {
+        this->vram_ids[i] = vram::add(
+            vram::Category::MATERIAL_MAPS,
+            std::string("material_array/") + names[i],
+            map_n_bytes
+        );
+    }
+
+    // higher layers first, so allocate_layer() hands out the lower ones
+    for (int layer = n_layers - 1; layer > PLACEHOLDER_LAYER; --layer) {
+        this->free_layers.push_back(layer);
+    }
+
+    // placeholder: flat grey, fully rough, without normal map and height
+    Image albedo = GenImageColor(size, size, {128, 128, 128, 255});
+    Image normal = GenImageColor(size, size, BLANK);
+    Image ormh = GenImageColor(size, size, {255, 255, 0, 0});
+    for (Image *image : {&albedo, &normal, &ormh}) {
+        ImageMipmaps(image);
+    }
+
+    this->upload_layer_levels(PLACEHOLDER_LAYER, albedo, normal, ormh, 0, this->n_levels);
+
+    UnloadImage(albedo);
+    UnloadImage(normal);
+    UnloadImage(ormh);
+}
+
+size_t MaterialArray::get_map_n_bytes(int size, int n_levels) {
+    size_t n_bytes = 0;
+    for (int level = 0; level < n_levels; ++level) {
+        int level_size = std::max(1, size >> level);
+        n_bytes += GetPixelDataSize(
+            level_size, level_size, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+        );
+    }
+
+    return n_bytes;
+}
+
+size_t MaterialArray::get_layer_n_bytes(int size) {
+    // albedo, normal and ormh
+    return 3 * get_map_n_bytes(size, get_n_levels(size));
 }
 
-void PBRShader::set_tiling(Vector2 tiling) {
-    SetShaderValue(shader, tiling_loc, &tiling, SHADER_UNIFORM_VEC2);
+int MaterialArray::get_n_levels() const {
+    return this->n_levels;
 }
 
-void PBRShader::set_displacement_scale(float scale) {
-    SetShaderValue(shader, displacement_scale_loc, &scale, SHADER_UNIFORM_FLOAT);
+int MaterialArray::get_n_layers() const {
+    return this->n_layers;
 }
 
-const PBRShader::LightLocs &PBRShader::get_light_locs(int idx) const {
-    if (idx < 0 || idx >= render_config::MAX_N_LIGHTS) {
-        throw std::runtime_error("Light index out of bounds");
+int MaterialArray::get_n_free_layers() const {
+    return this->free_layers.size();
+}
+
+int MaterialArray::allocate_layer() {
+    if (this->free_layers.empty()) return -1;
+
+    int layer = this->free_layers.back();
+    this->free_layers.pop_back();
+
+    return layer;
+}
+
+void MaterialArray::free_layer(int layer) {
+    if (layer <= PLACEHOLDER_LAYER || layer >= this->n_layers) {
+        throw std::runtime_error("Can't free material array layer: " + std::to_string(layer));
+    }
+
+    this->params[layer] = {1.0, 1.0, 0.0, 0.0};
+    this->free_layers.push_back(layer);
+}
+
+void MaterialArray::upload_layer_levels(
+    int layer,
+    const Image &albedo,
+    const Image &normal,
+    const Image &ormh,
+    int first_level,
+    int end_level
+) {
+    for (const Image *image : {&albedo, &normal, &ormh}) {
+        if (image->width != this->size || image->height != this->size
+            || image->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+            || image->mipmaps != this->n_levels) {
+            throw std::runtime_error("Material map image doesn't match the array");
+        }
+    }
+
+    upload_texture_array_layer(this->albedo_id, layer, albedo, first_level, end_level);
+    upload_texture_array_layer(this->normal_id, layer, normal, first_level, end_level);
+    upload_texture_array_layer(this->ormh_id, layer, ormh, first_level, end_level);
+}
+
+void MaterialArray::set_layer_params(
+    int layer, Vector2 tiling, float displacement_scale, int min_level
+) {
+    this->params[layer] = {tiling.x, tiling.y, displacement_scale, (float)min_level};
+}
+
+const std::vector<Vector4> &MaterialArray::get_params() const {
+    return this->params;
+}
+
+void MaterialArray::bind() const {
+    std::array<unsigned int, 3> ids = {this->albedo_id, this->normal_id, this->ormh_id};
+    for (int i = 0; i < (int)ids.size(); ++i) {
+        int slot = render_config::MATERIAL_MAPS_TEXTURE_SLOT_OFFSET + i;
+        gl::ActiveTexture(gl::TEXTURE0 + slot);
+        gl::BindTexture(gl::TEXTURE_2D_ARRAY, ids[i]);
+    }
+    gl::ActiveTexture(gl::TEXTURE0);
+}
+
+void MaterialArray::unload() {
+    if (this->albedo_id == 0) return;
+
+    std::array<unsigned int, 3> ids = {this->albedo_id, this->normal_id, this->ormh_id};
+    gl::DeleteTextures(ids.size(), ids.data());
+    this->albedo_id = this->normal_id = this->ormh_id = 0;
+    for (int &vram_id : this->vram_ids) {
+        vram::remove(vram_id);
+        vram_id = vram::INVALID_ID;
     }
-    return light_locs[idx];
+    this->params.clear();
+    this->free_layers.clear();
 }
 
 // -----------------------------------------------------------------------
 // MaterialPBR
+
+// Loads the map as RGBA8 image of the given size
+static Image load_map_image(const std::string &file_path, int size) {
+    Image image = LoadImage(file_path.c_str());
+    if (image.data == nullptr) {
+        TraceLog(LOG_WARNING, "Failed to load material map: %s", file_path.c_str());
+        return GenImageColor(size, size, BLANK);
+    }
+
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+    if (image.width != size || image.height != size) {
+        ImageResize(&image, size, size);
+    }
+
+    return image;
+}
+
+static std::string get_map_file_path(const MaterialDesc &desc, MapType type) {
+    return desc.dir_path + map_type_to_str(type) + ".png";
+}
+
+static Image load_map_image(const MaterialDesc &desc, MapType type, int size) {
+    if (!desc.has_map(type)) return GenImageColor(size, size, BLANK);
+    return load_map_image(get_map_file_path(desc, type), size);
+}
+
+// Packs the red channels of occlusion, roughness, metalness and height maps
+static Image pack_ormh_image(const MaterialDesc &desc, int size) {
+    static constexpr std::array<MapType, 4> channel_types = {
+        MapType::OCCLUSION, MapType::ROUGHNESS, MapType::METALNESS, MapType::HEIGHT
+    };
+
+    Image ormh = GenImageColor(size, size, BLANK);
+    auto dst = static_cast<unsigned char *>(ormh.data);
+
+    for (int channel = 0; channel < 4; ++channel) {
+        // missing maps leave their channel zeroed
+        if (!desc.has_map(channel_types[channel])) continue;
+
+        Image image = load_map_image(get_map_file_path(desc, channel_types[channel]), size);
+        auto src = static_cast<const unsigned char *>(image.data);
+        for (int i = 0; i < size * size; ++i) {
+            dst[4 * i + channel] = src[4 * i];
+        }
+        UnloadImage(image);
+    }
+
+    return ormh;
+}
+
+void MaterialImages::unload() {
+    if (this->is_borrowed) {
+        *this = {};
+        return;
+    }
+
+    for (Image *image : {&this->albedo, &this->normal, &this->ormh, &this->preview}) {
+        UnloadImage(*image);
+        *image = {};
+    }
+}
+
+MaterialImages load_material_images(const MaterialDesc &desc) {
+    static constexpr int size = render_config::MATERIAL_MAP_SIZE;
+    static constexpr int preview_size = render_config::MATERIAL_PREVIEW_SIZE;
+
+    // the maps are decoded sequentially, the materials are decoded in parallel
+    // instead: a nested fork here would let the waits of the frame jobs pick
+    // up a long decode
+    MaterialImages images;
+    images.albedo = load_map_image(desc, MapType::ALBEDO, size);
+    images.preview = ImageCopy(images.albedo);
+    ImageResize(&images.preview, preview_size, preview_size);
+    ImageMipmaps(&images.albedo);
+
+    images.normal = load_map_image(desc, MapType::NORMAL, size);
+    ImageMipmaps(&images.normal);
+
+    images.ormh = pack_ormh_image(desc, size);
+    ImageMipmaps(&images.ormh);
+
+    return images;
+}
+
 MaterialPBR::MaterialPBR() = default;
 
-MaterialPBR::MaterialPBR(PBRShader &pbr_shader, std::string dir_path, Vector2 tiling, float displacement_scale)
-    : pbr_shader(&pbr_shader)
-    , dir_path(std::move(dir_path))
-    , tiling(tiling)
-    , displacement_scale(displacement_scale) {
-    Material material = LoadMaterialDefault();
-    material.shader = pbr_shader.get_shader();
+MaterialPBR::MaterialPBR(MaterialDesc desc)
+    : desc(std::move(desc)) {}
+
+void MaterialPBR::make_resident(
+    const MaterialImages &images, MaterialArray &material_array, int mip_level
+) {
+    if (this->is_resident()) return;
+
+    int layer = material_array.allocate_layer();
+    if (layer == -1) {
+        throw std::runtime_error("No free material array layer for: " + this->desc.key);
+    }
+
+    int n_levels = material_array.get_n_levels();
+    mip_level = std::clamp(mip_level, 0, n_levels - 1);
+    material_array.upload_layer_levels(
+        layer, images.albedo, images.normal, images.ormh, mip_level, n_levels
+    );
+
+    this->layer = layer;
+    this->set_mip_level(mip_level, material_array);
+
+    this->preview = LoadTextureFromImage(images.preview);
+    SetTextureFilter(this->preview, TEXTURE_FILTER_BILINEAR);
+    this->preview_vram_id = vram::add(
+        vram::Category::MATERIAL_PREVIEWS,
+        this->desc.key,
+        vram::get_texture_n_bytes(
+            this->preview.width,
+            this->preview.height,
+            this->preview.format,
+            this->preview.mipmaps
+        )
+    );
+}
+
+void MaterialPBR::stream_in_level(const MaterialImages &images, MaterialArray &material_array) {
+    if (!this->is_resident() || this->mip_level == 0) return;
+
+    int level = this->mip_level - 1;
+    material_array.upload_layer_levels(
+        this->layer, images.albedo, images.normal, images.ormh, level, level + 1
+    );
+    this->set_mip_level(level, material_array);
+}
+
+void MaterialPBR::reupload(const MaterialImages &images, MaterialArray &material_array) {
+    if (!this->is_resident()) return;
+
+    material_array.upload_layer_levels(
+        this->layer,
+        images.albedo,
+        images.normal,
+        images.ormh,
+        this->mip_level,
+        material_array.get_n_levels()
+    );
+    UpdateTexture(this->preview, images.preview.data);
+}
+
+void MaterialPBR::set_mip_level(int mip_level, MaterialArray &material_array) {
+    this->mip_level = mip_level;
+    material_array.set_layer_params(
+        this->layer, this->desc.tiling, this->desc.displacement_scale, mip_level
+    );
+}
 
-    // texture maps
-    material.maps[MATERIAL_MAP_ALBEDO].texture = load_texture(this->dir_path, "albedo.png");
-    material.maps[MATERIAL_MAP_METALNESS].texture = load_texture(this->dir_path, "metalness.png");
-    material.maps[MATERIAL_MAP_NORMAL].texture = load_texture(this->dir_path, "normal.png");
-    material.maps[MATERIAL_MAP_ROUGHNESS].texture = load_texture(this->dir_path, "roughness.png");
-    material.maps[MATERIAL_MAP_OCCLUSION].texture = load_texture(this->dir_path, "occlusion.png");
-    material.maps[MATERIAL_MAP_HEIGHT].texture = load_texture(this->dir_path, "height.png");
+void MaterialPBR::evict(MaterialArray &material_array) {
+    if (!this->is_resident()) return;
 
-    this->material = material;
+    material_array.free_layer(this->layer);
+    this->layer = -1;
+    this->unload();
+}
+
+bool MaterialPBR::is_resident() const {
+    return this->layer != -1;
+}
+
+const MaterialDesc &MaterialPBR::get_desc() const {
+    return this->desc;
 }
 
 Texture MaterialPBR::get_texture() const {
-    return this->material.maps[0].texture;
+    return this->preview;
 }
 
-Material MaterialPBR::get_material() const {
-    return this->material;
+int MaterialPBR::get_mip_level() const {
+    return this->mip_level;
 }
 
-PBRShader &MaterialPBR::get_pbr_shader() const {
-    return *this->pbr_shader;
+int MaterialPBR::get_layer() const {
+    return this->is_resident() ? this->layer : MaterialArray::PLACEHOLDER_LAYER;
 }
 
 Vector2 MaterialPBR::get_tiling() const {
-    return this->tiling;
+    return this->desc.tiling;
 }
 
 float MaterialPBR::get_displacement_scale() const {
-    return this->displacement_scale;
+    return this->desc.displacement_scale;
 }
 
 void MaterialPBR::unload() {
-    if (this->material.maps == nullptr) return;
-
-    // Unload textures only; the shared PBR shader is managed by resources
-    UnloadTexture(this->material.maps[MATERIAL_MAP_ALBEDO].texture);
-    UnloadTexture(this->material.maps[MATERIAL_MAP_METALNESS].texture);
-    UnloadTexture(this->material.maps[MATERIAL_MAP_NORMAL].texture);
-    UnloadTexture(this->material.maps[MATERIAL_MAP_ROUGHNESS].texture);
-    UnloadTexture(this->material.maps[MATERIAL_MAP_OCCLUSION].texture);
-    UnloadTexture(this->material.maps[MATERIAL_MAP_HEIGHT].texture);
-    RL_FREE(this->material.maps);
-    this->material.maps = nullptr;
+    // Unload the preview only; the maps are owned by the MaterialArray
+    if (this->preview.id == 0) return;
+
+    UnloadTexture(this->preview);
+    this->preview = {};
+    vram::remove(this->preview_vram_id);
+    this->preview_vram_id = vram::INVALID_ID;
 }
 
 }  // namespace soft_tissues::pbr
@@ -1,47 +1,77 @@
 #pragma once
 
+#include "nlohmann/json.hpp"
 #include "raylib/raylib.h"
 #include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace soft_tissues::render_config {
 
+// 0 is uncapped
+inline constexpr int TARGET_FPS = 60;
+
 inline constexpr int MAX_N_LIGHTS = 8;
 inline constexpr int MAX_N_SHADOW_MAPS = MAX_N_LIGHTS;
 inline constexpr int SHADOW_MAP_SIZE = 1024;
 inline constexpr int SHADOW_MAP_TEXTURE_SLOT_OFFSET = 10;
 inline constexpr float SHADOW_CAMERA_FOV = 90.0;
+// uniform buffer binding point of the Lights block
+inline constexpr int LIGHTS_BUFFER_BINDING = 0;
+
+inline constexpr int MAX_N_MATERIALS = 64;
+inline constexpr int MATERIAL_MAP_SIZE = 512;
+inline constexpr int MATERIAL_PREVIEW_SIZE = 128;
+// albedo, normal and ormh texture arrays are bound to the consecutive slots
+inline constexpr int MATERIAL_MAPS_TEXTURE_SLOT_OFFSET = 4;
+// VRAM for the resident material maps, determines the number of array layers
+inline constexpr size_t MATERIAL_MAPS_VRAM_BUDGET = 64 * 1024 * 1024;
+// Materials used within this number of frames are never evicted
+inline constexpr int MATERIAL_EVICTION_MIN_AGE_FRAMES = 120;
+// Size of the coarsest resident mip, uploaded when a material becomes resident
+inline constexpr int MATERIAL_STREAMING_MIN_SIZE = 64;
 
 }  // namespace soft_tissues::render_config
 
 namespace soft_tissues::pbr {
 
-class PBRShader {
-public:
-    struct LightLocs {
-        int position, type, color, intensity, casts_shadows, vp_mat;
-        int direction, attenuation, inner_cutoff, outer_cutoff;
-        int shadow_map;
-    };
+// Compile-time permutation of the pbr shader. Each variant is injected into the
+// shader sources as #defines and compiled into its own program, so the shaders
+// don't branch on these at runtime.
+struct ShaderVariant {
+    // keys are in [0, N_KEYS)
+    static constexpr uint32_t N_KEYS = 16;
+
+    bool is_shadow_map_pass = false;
+    bool is_light_enabled = true;
+    bool has_displacement = false;
+    bool is_instanced = false;
+
+    bool is_lit() const;
+    uint32_t get_key() const;
+    std::vector<std::string> get_defines() const;
+};
 
+// The lights are not uniforms of the program: lit variants read them from
+// the uniform buffer kept by system::lighting
+class PBRShader {
 private:
     Shader shader = {};
+    ShaderVariant variant;
 
-    int is_shadow_map_pass_loc = -1;
     int camera_pos_loc = -1;
-    int is_light_enabled_loc = -1;
     int constant_color_loc = -1;
     int shadow_map_bias_loc = -1;
     int shadow_map_max_dist_loc = -1;
-    int n_lights_loc = -1;
-    int tiling_loc = -1;
-    int displacement_scale_loc = -1;
-
-    std::array<LightLocs, render_config::MAX_N_LIGHTS> light_locs;
+    int material_layer_loc = -1;
+    int material_params_loc = -1;
 
 public:
     PBRShader();
-    PBRShader(const std::string &vs_file, const std::string &fs_file);
+    PBRShader(const std::string &vs_file, const std::string &fs_file, ShaderVariant variant);
 
     PBRShader(const PBRShader &) = delete;
     PBRShader &operator=(const PBRShader &) = delete;
@@ -50,43 +80,220 @@ public:
 
     // Returns Shader by value (shallow copy sharing GPU handle). Do not call UnloadShader() on the copy.
     Shader get_shader() const;
+    ShaderVariant get_variant() const;
     void unload();
 
-    void set_shadow_map_pass(bool value);
     void set_camera_pos(Vector3 pos);
-    void set_light_enabled(bool value);
     void set_constant_color(Color color);
     void set_shadow_map_bias(float bias);
     void set_shadow_map_max_dist(float dist);
-    void set_n_lights(int n);
-    void set_tiling(Vector2 tiling);
-    void set_displacement_scale(float scale);
+    void set_material_layer(int layer);
+    void set_material_params(const std::vector<Vector4> &params);
+};
+
+// Owns one PBRShader program per variant key
+class PBRShaderCache {
+private:
+    std::string vs_file;
+    std::string fs_file;
+    std::array<std::optional<PBRShader>, ShaderVariant::N_KEYS> shaders;
+
+public:
+    PBRShaderCache();
+    PBRShaderCache(std::string vs_file, std::string fs_file);
 
-    const LightLocs &get_light_locs(int idx) const;
+    PBRShaderCache(const PBRShaderCache &) = delete;
+    PBRShaderCache &operator=(const PBRShaderCache &) = delete;
+    PBRShaderCache(PBRShaderCache &&) = default;
+    PBRShaderCache &operator=(PBRShaderCache &&) = default;
+
+    // Compiles the variant on the first request. Returned references stay valid
+    // until unload().
+    PBRShader &get(ShaderVariant variant);
+    // True if the programs are built from the shader file (incl. common.glsl)
+    bool uses_file(const std::string &file_name) const;
+    // Recompiles the compiled variants in place. A variant which fails to
+    // compile keeps its previous program. Returns the number of recompiled ones
+    int reload();
+    void unload();
 };
 
-class MaterialPBR {
+// Texture maps of the pbr materials, stored in texture arrays with one layer
+// per resident material. Occlusion, roughness, metalness and height are packed
+// into the rgba channels of a single ORMH map. Switching the material only
+// changes the layer index, so draws with different materials can be batched.
+// The PLACEHOLDER_LAYER is filled on creation and is never freed.
+class MaterialArray {
+public:
+    static constexpr int PLACEHOLDER_LAYER = 0;
+
 private:
-    Material material = {};
-    PBRShader *pbr_shader = nullptr;
+    unsigned int albedo_id = 0;
+    unsigned int normal_id = 0;
+    unsigned int ormh_id = 0;
+    // vram allocations of the albedo, normal and ormh arrays
+    std::array<int, 3> vram_ids = {-1, -1, -1};
+
+    int size = 0;
+    int n_levels = 0;
+    int n_layers = 0;
+
+    // per layer: xy - tiling, z - displacement scale
+    std::vector<Vector4> params;
+    std::vector<int> free_layers;
+
+public:
+    MaterialArray();
+    MaterialArray(int size, int n_layers);
+
+    MaterialArray(const MaterialArray &) = delete;
+    MaterialArray &operator=(const MaterialArray &) = delete;
+    MaterialArray(MaterialArray &&) = default;
+    MaterialArray &operator=(MaterialArray &&) = default;
+
+    // Number of levels in the full mip chain
+    static int get_n_levels(int size);
+    // Size of a single RGBA8 map with the given number of mips
+    static size_t get_map_n_bytes(int size, int n_levels);
+    // Size of a single layer of all arrays, including mips
+    static size_t get_layer_n_bytes(int size);
+
+    int get_n_levels() const;
+    int get_n_layers() const;
+    int get_n_free_layers() const;
+
+    // Returns -1 if all layers are taken
+    int allocate_layer();
+    void free_layer(int layer);
 
+    // Uploads the [first_level, end_level) mips. Images must be RGBA8 of the
+    // array size with the full mip chain
+    void upload_layer_levels(
+        int layer,
+        const Image &albedo,
+        const Image &normal,
+        const Image &ormh,
+        int first_level,
+        int end_level
+    );
+    // Shaders never sample the layer mips finer than min_level
+    void set_layer_params(int layer, Vector2 tiling, float displacement_scale, int min_level);
+
+    const std::vector<Vector4> &get_params() const;
+
+    // Binds the arrays to the MATERIAL_MAPS_TEXTURE_SLOT_OFFSET slots
+    void bind() const;
+    void unload();
+};
+
+// -----------------------------------------------------------------------
+// material manifest
+enum class MapType {
+    ALBEDO = 0,
+    NORMAL,
+    OCCLUSION,
+    ROUGHNESS,
+    METALNESS,
+    HEIGHT,
+};
+
+constexpr std::array<MapType, 6> MAP_TYPES = {
+    MapType::ALBEDO,
+    MapType::NORMAL,
+    MapType::OCCLUSION,
+    MapType::ROUGHNESS,
+    MapType::METALNESS,
+    MapType::HEIGHT,
+};
+
+// Also the map file name without the ".png" extension
+std::string map_type_to_str(MapType type);
+MapType str_to_map_type(const std::string &str);
+
+// Material entry of the material manifest. The maps which are not listed
+// are never looked up on the disk and are zero filled
+struct MaterialDesc {
+    std::string key;
+    // not serialized, resolved relative to the manifest file
     std::string dir_path;
+
     Vector2 tiling = {1.0, 1.0};
     float displacement_scale = 0.0;
+    std::array<bool, MAP_TYPES.size()> has_maps = {};
+
+    bool has_map(MapType type) const;
+
+    nlohmann::json to_json() const;
+    static MaterialDesc from_json(const std::string &key, const nlohmann::json &json_data);
+};
+
+// Materials are sorted by key, so the load order doesn't depend on the file
+std::vector<MaterialDesc> load_material_manifest(const std::string &file_path);
+
+// -----------------------------------------------------------------------
+// material maps
+
+// Decoded material maps, ready for the upload into a MaterialArray layer
+struct MaterialImages {
+    Image albedo = {};
+    Image normal = {};
+    Image ormh = {};
+    Image preview = {};
+    // image data points into the mounted asset pack and is not freed
+    bool is_borrowed = false;
+
+    void unload();
+};
+
+// Decodes and packs the material maps listed in the description and generates
+// their mips. Doesn't touch GL, so it's safe to call from the worker threads
+MaterialImages load_material_images(const MaterialDesc &desc);
+
+// Material description which is always available, while its maps are uploaded
+// into the MaterialArray on demand. Non-resident material renders with the
+// placeholder layer and has no preview texture.
+// Resident material streams its mips: only the levels from mip_level to the
+// coarsest one are uploaded and sampled, finer ones are streamed in one level
+// at a time and kept until the material is evicted.
+class MaterialPBR {
+private:
+    MaterialDesc desc;
+
+    int layer = -1;
+    int mip_level = 0;
+    Texture preview = {};
+    int preview_vram_id = -1;
+
+    void set_mip_level(int mip_level, MaterialArray &material_array);
 
 public:
     MaterialPBR();
-    MaterialPBR(PBRShader &pbr_shader, std::string dir_path, Vector2 tiling, float displacement_scale);
+    explicit MaterialPBR(MaterialDesc desc);
 
     MaterialPBR(const MaterialPBR &) = delete;
     MaterialPBR &operator=(const MaterialPBR &) = delete;
     MaterialPBR(MaterialPBR &&) = default;
     MaterialPBR &operator=(MaterialPBR &&) = default;
 
+    // Uploads the images into a free layer starting from the mip_level, must be
+    // called on the main thread, like the other residency changes
+    void make_resident(
+        const MaterialImages &images, MaterialArray &material_array, int mip_level
+    );
+    // Uploads the next finer mip level
+    void stream_in_level(const MaterialImages &images, MaterialArray &material_array);
+    // Uploads the changed images over the resident levels and the preview,
+    // keeping the layer and the textures
+    void reupload(const MaterialImages &images, MaterialArray &material_array);
+    void evict(MaterialArray &material_array);
+    bool is_resident() const;
+
+    const MaterialDesc &get_desc() const;
+    // Downscaled albedo texture for the editor ui, zero id if not resident
     Texture get_texture() const;
-    // Returns Material by value (shallow copy sharing internal maps pointer). Do not call UnloadMaterial() on the copy.
-    Material get_material() const;
-    PBRShader &get_pbr_shader() const;
+    // Finest resident mip level
+    int get_mip_level() const;
+    int get_layer() const;
     Vector2 get_tiling() const;
     float get_displacement_scale() const;
 
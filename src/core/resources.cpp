@@ -1,16 +1,28 @@
 #include "resources.hpp"
 
 #include "pbr.hpp"
+#include "cook.hpp"
+#include "file_watcher.hpp"
 #include "gameplay_config.hpp"
+#include "jobs.hpp"
 #include "raylib/raylib.h"
 #include "raylib/rlgl.h"
 #include "utils.hpp"
+#include "vram.hpp"
+#include <algorithm>
 #include <array>
+#include <cfloat>
+#include <chrono>
+#include <climits>
+#include <deque>
+#include <filesystem>
+#include <future>
 #include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace soft_tissues::resources {
 
@@ -18,98 +30,492 @@ using namespace utils;
 
 static Material DEFAULT_MATERIAL;
 
-static pbr::PBRShader PBR_SHADER;
-static std::unordered_map<std::string, pbr::MaterialPBR> MATERIALS_PBR;
-static std::unordered_map<std::string, Mesh> MESHES;
+static pbr::PBRShaderCache PBR_SHADERS;
+static pbr::MaterialArray MATERIAL_ARRAY;
+static handle::HandleMap<pbr::MaterialPBR> MATERIALS_PBR;
+static handle::HandleMap<Mesh> MESHES;
 
-static std::unordered_map<std::string, Mesh> WALL_MESHES;
+static std::vector<WallMesh> WALL_MESHES;
 
 static std::unordered_set<int> FREE_SHADOW_MAP_IDXS;
 static std::array<RenderTexture2D, render_config::MAX_N_SHADOW_MAPS> SHADOW_MAPS;
+static std::array<int, render_config::MAX_N_SHADOW_MAPS> SHADOW_MAP_VRAM_IDS;
+
+// -----------------------------------------------------------------------
+// material residency
+// Materials are made resident on the first use. Their images are decoded on
+// the worker threads and uploaded on the main thread by update() within the
+// time budget. When the material array is full, the least recently used
+// material is evicted, unless it was used in the last few frames.
+//
+// Mips are streamed: a new material gets only its coarse mips, then the finer
+// ones are uploaded one level per step towards the level requested by the
+// renderer from the projected texel density. A resident material which needs
+// finer mips has its images loaded again. The uploaded levels are kept until
+// the material is evicted: the material array storage is immutable, so
+// dropping them would free no VRAM and only cost a reload when they are
+// requested again.
+static constexpr double MATERIAL_UPLOAD_BUDGET_MS = 4.0;
+
+struct PendingMaterial {
+    MaterialHandle handle;
+    // the source maps have changed, the resident levels are uploaded again
+    bool is_reload;
+    std::future<pbr::MaterialImages> images;
+    // taken out of the future once ready, kept until all levels are uploaded
+    pbr::MaterialImages ready_images;
+    bool is_ready = false;
+};
+
+// Residency bookkeeping, indexed by the material handle idx
+struct MaterialState {
+    static constexpr int NEVER_USED_FRAME_IDX = INT_MIN / 2;
+
+    int last_use_frame_idx = NEVER_USED_FRAME_IDX;
+    int mip_request_frame_idx = -1;
+    int requested_mip_level = 0;
+    bool is_pending = false;
+    bool is_reload_requested = false;
+};
+
+static std::deque<PendingMaterial> PENDING_MATERIALS;
+static std::vector<MaterialState> MATERIAL_STATES;
+static int FRAME_IDX = 0;
+
+static const std::string MATERIAL_MANIFEST_FILE_PATH = "resources/pbr/manifest.json";
+
+// material key -> cooked material, see cook.hpp
+static std::unordered_map<std::string, cook::CookedMaterial> COOKED_MATERIALS;
+
+static void request_material_pbr(MaterialHandle handle, bool is_reload = false) {
+    auto &state = MATERIAL_STATES[handle.idx];
+    if (state.is_pending) return;
+
+    auto desc = MATERIALS_PBR.get(handle).get_desc();
+    auto it = COOKED_MATERIALS.find(desc.key);
+    auto cooked = it != COOKED_MATERIALS.end() ? it->second : cook::CookedMaterial{};
+
+    auto images = jobs::submit_background([desc, cooked]() {
+        // prefer the cooked maps, they don't need the decoding and mips,
+        // unless the source maps were edited since the last cook
+        pbr::MaterialImages images;
+        if (!cooked.file_path.empty() && cook::is_up_to_date(desc, cooked)
+            && cook::load_material_images(cooked.file_path, images)) {
+            return images;
+        }
+
+        return pbr::load_material_images(desc);
+    });
+
+    PENDING_MATERIALS.push_back({handle, is_reload, std::move(images)});
+    state.is_pending = true;
+}
+
+// Returns false if every resident material has been used recently
+static bool evict_lru_material() {
+    int max_frame_idx = FRAME_IDX - render_config::MATERIAL_EVICTION_MIN_AGE_FRAMES;
+
+    pbr::MaterialPBR *lru_material = nullptr;
+    int lru_frame_idx = max_frame_idx + 1;
+    MATERIALS_PBR.for_each([&](MaterialHandle handle, pbr::MaterialPBR &material) {
+        if (!material.is_resident()) return;
+
+        int frame_idx = MATERIAL_STATES[handle.idx].last_use_frame_idx;
+        if (frame_idx < lru_frame_idx) {
+            lru_material = &material;
+            lru_frame_idx = frame_idx;
+        }
+    });
+
+    if (lru_material == nullptr) return false;
+
+    lru_material->evict(MATERIAL_ARRAY);
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: Material evicted: %s",
+        lru_material->get_desc().key.c_str()
+    );
+
+    return true;
+}
+
+static bool is_material_used(MaterialHandle handle) {
+    int frame_idx = MATERIAL_STATES[handle.idx].last_use_frame_idx;
+    return FRAME_IDX - frame_idx < render_config::MATERIAL_EVICTION_MIN_AGE_FRAMES;
+}
+
+// Level of the MATERIAL_STREAMING_MIN_SIZE mip
+static int get_coarsest_mip_level() {
+    return pbr::MaterialArray::get_n_levels(
+        render_config::MATERIAL_MAP_SIZE / render_config::MATERIAL_STREAMING_MIN_SIZE
+    ) - 1;
+}
 
-static std::string get_material_pbr_dir_path(const std::string &key) {
-    return "resources/pbr/" + key + "/";
+// The finest level requested in the last frame. Materials without requests
+// (e.g. used only by the editor previews) get the coarsest streamed level
+static int get_material_target_mip_level(MaterialHandle handle) {
+    const auto &state = MATERIAL_STATES[handle.idx];
+    if (state.mip_request_frame_idx == -1 || !is_material_used(handle)) {
+        return get_coarsest_mip_level();
+    }
+
+    return std::min(state.requested_mip_level, get_coarsest_mip_level());
+}
+
+// Requests the finer mips of the resident materials which need them
+static void update_material_streaming() {
+    MATERIALS_PBR.for_each([](MaterialHandle handle, pbr::MaterialPBR &material) {
+        if (!material.is_resident()) return;
+
+        // waits for the pending request, its images may predate the change
+        auto &state = MATERIAL_STATES[handle.idx];
+        if (state.is_reload_requested && !state.is_pending) {
+            state.is_reload_requested = false;
+            request_material_pbr(handle, true);
+            return;
+        }
+
+        if (get_material_target_mip_level(handle) < material.get_mip_level()) {
+            request_material_pbr(handle);
+        }
+    });
+}
+
+// Uploads the loaded materials in the request order until the time budget is
+// spent, one mip level at a time from the coarse to the fine ones. Never waits
+// for the workers. Returns the number of pending materials
+static int upload_pending_materials(double budget_ms) {
+    double start_time = GetTime();
+    auto is_budget_spent = [&]() {
+        return (GetTime() - start_time) * 1000.0 >= budget_ms;
+    };
+
+    while (!PENDING_MATERIALS.empty() && !is_budget_spent()) {
+        auto &pending = PENDING_MATERIALS.front();
+        if (!pending.is_ready) {
+            auto status = pending.images.wait_for(std::chrono::seconds(0));
+            if (status != std::future_status::ready) break;
+
+            pending.ready_images = pending.images.get();
+            pending.is_ready = true;
+        }
+
+        auto &material = MATERIALS_PBR.get(pending.handle);
+        int mip_level = get_material_target_mip_level(pending.handle);
+
+        if (!material.is_resident()) {
+            if (MATERIAL_ARRAY.get_n_free_layers() == 0 && !evict_lru_material()) {
+                break;
+            }
+
+            material.make_resident(
+                pending.ready_images, MATERIAL_ARRAY, get_coarsest_mip_level()
+            );
+            TraceLog(
+                LOG_INFO,
+                "RESOURCES: Material is resident: %s",
+                material.get_desc().key.c_str()
+            );
+        } else if (pending.is_reload) {
+            material.reupload(pending.ready_images, MATERIAL_ARRAY);
+            pending.is_reload = false;
+            TraceLog(
+                LOG_INFO,
+                "RESOURCES: Material is reloaded: %s",
+                material.get_desc().key.c_str()
+            );
+        }
+
+        while (material.get_mip_level() > mip_level && !is_budget_spent()) {
+            material.stream_in_level(pending.ready_images, MATERIAL_ARRAY);
+        }
+
+        // continues with the finer levels in the next frame
+        if (material.get_mip_level() > mip_level) break;
+
+        pending.ready_images.unload();
+        MATERIAL_STATES[pending.handle.idx].is_pending = false;
+        PENDING_MATERIALS.pop_front();
+    }
+
+    return PENDING_MATERIALS.size();
+}
+
+// -----------------------------------------------------------------------
+// mesh lifetime
+// Number of frames the released meshes are kept for, covers the frames which
+// the driver may still have queued
+static constexpr int MESH_DESTROY_DELAY_FRAMES = 3;
+
+// Indexed by the mesh handle idx. The built-in meshes are never released, so
+// they hold no counted references
+struct MeshState {
+    int n_refs = 0;
+    int vram_id = vram::INVALID_ID;
+    BoundingBox bounds = {};
+};
+
+struct DestroyedMesh {
+    Mesh mesh;
+    int vram_id;
+    int destroy_frame_idx;
+};
+
+static std::vector<MeshState> MESH_STATES;
+static std::deque<DestroyedMesh> DESTROYED_MESHES;
+
+static MeshHandle insert_mesh(
+    const std::string &key, Mesh mesh, const std::string &name, vram::Category category
+) {
+    auto handle = key.empty() ? MESHES.insert(mesh) : MESHES.insert(key, mesh);
+    MESH_STATES.resize(MESHES.get_capacity());
+    MESH_STATES[handle.idx] = {0, vram::add(category, name, vram::get_mesh_n_bytes(mesh))};
+
+    // meshes without the cpu side vertices are never culled
+    if (mesh.vertices != nullptr) {
+        MESH_STATES[handle.idx].bounds = GetMeshBoundingBox(mesh);
+    } else {
+        MESH_STATES[handle.idx].bounds = {{-FLT_MAX, -FLT_MAX, -FLT_MAX}, {FLT_MAX, FLT_MAX, FLT_MAX}};
+    }
+
+    return handle;
+}
+
+// Destroys the meshes whose delay has passed, or all of them if is_forced
+static void destroy_released_meshes(bool is_forced) {
+    while (!DESTROYED_MESHES.empty()) {
+        auto &destroyed = DESTROYED_MESHES.front();
+        if (!is_forced && destroyed.destroy_frame_idx > FRAME_IDX) break;
+
+        UnloadMesh(destroyed.mesh);
+        vram::remove(destroyed.vram_id);
+        DESTROYED_MESHES.pop_front();
+    }
+}
+
+// -----------------------------------------------------------------------
+// hot reload
+// The shader and material directories are watched for changes. A changed
+// shader recompiles the pbr variants, a changed material map reloads the
+// material from its source maps into the layer it already occupies.
+static file_watcher::FileWatcher FILE_WATCHER;
+
+static void watch_resource_dirs() {
+    int n_dirs = 0;
+    n_dirs += FILE_WATCHER.watch_dir(utils::get_shader_file_path(""));
+    MATERIALS_PBR.for_each([&](MaterialHandle, pbr::MaterialPBR &material) {
+        n_dirs += FILE_WATCHER.watch_dir(material.get_desc().dir_path);
+    });
+
+    TraceLog(LOG_INFO, "RESOURCES: %d directories are watched for changes", n_dirs);
+}
+
+static void reload_changed_shader(const std::string &file_name) {
+    if (!PBR_SHADERS.uses_file(file_name)) return;
+
+    double start_time = GetTime();
+    int n_reloaded = PBR_SHADERS.reload();
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: %d PBR shader variants are reloaded in %.2f ms",
+        n_reloaded,
+        (GetTime() - start_time) * 1000.0
+    );
+}
+
+static void reload_changed_material(MaterialHandle handle) {
+    // the cooked maps are stale now, the reload reads the source ones
+    COOKED_MATERIALS.erase(MATERIALS_PBR.get_key(handle));
+
+    if (MATERIALS_PBR.get(handle).is_resident()) {
+        MATERIAL_STATES[handle.idx].is_reload_requested = true;
+    }
+}
+
+static void update_hot_reload() {
+    for (const auto &file_path : FILE_WATCHER.poll()) {
+        auto path = std::filesystem::path(file_path);
+        auto dir_path = path.parent_path().string() + "/";
+
+        if (dir_path == utils::get_shader_file_path("")) {
+            reload_changed_shader(path.filename().string());
+            continue;
+        }
+
+        MATERIALS_PBR.for_each([&](MaterialHandle handle, pbr::MaterialPBR &material) {
+            if (material.get_desc().dir_path == dir_path) {
+                reload_changed_material(handle);
+            }
+        });
+    }
 }
 
 void load() {
     DEFAULT_MATERIAL = LoadMaterialDefault();
 
     // -------------------------------------------------------------------
-    // pbr shader
-    PBR_SHADER = pbr::PBRShader("pbr.vert.glsl", "pbr.frag.glsl");
+    // materials pbr (only registered, they are loaded on the first use)
+    size_t layer_n_bytes = pbr::MaterialArray::get_layer_n_bytes(
+        render_config::MATERIAL_MAP_SIZE
+    );
+    int n_layers = std::min<size_t>(
+        render_config::MAX_N_MATERIALS,
+        render_config::MATERIAL_MAPS_VRAM_BUDGET / layer_n_bytes
+    );
+    MATERIAL_ARRAY = pbr::MaterialArray(render_config::MATERIAL_MAP_SIZE, n_layers);
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: Material array has %d layers of %.1f MB",
+        n_layers,
+        layer_n_bytes / (1024.0 * 1024.0)
+    );
 
-    // -------------------------------------------------------------------
-    // materials pbr
-    static const std::array<std::string, 5> material_keys = {
-        "brick_wall",
-        "tiled_stone",
-        "modern_shattered_wallpaper",
-        "hungarian_point_flooring",
-        "muddy_scattered_brickwork",
-    };
+    auto descs = pbr::load_material_manifest(MATERIAL_MANIFEST_FILE_PATH);
+    for (auto &desc : descs) {
+        auto key = desc.key;
+        MATERIALS_PBR.insert(key, pbr::MaterialPBR(std::move(desc)));
+    }
+    MATERIAL_STATES.resize(MATERIALS_PBR.get_capacity());
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: %zu materials are registered from %s",
+        descs.size(),
+        MATERIAL_MANIFEST_FILE_PATH.c_str()
+    );
+
+    COOKED_MATERIALS = cook::load_index();
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: %zu materials are cooked",
+        COOKED_MATERIALS.size()
+    );
 
-    for (const auto &key : material_keys) {
-        auto dir_path = get_material_pbr_dir_path(key);
-        MATERIALS_PBR.emplace(key, pbr::MaterialPBR(PBR_SHADER, dir_path, {1.0, 1.0}, 0.0));
+    watch_resource_dirs();
+
+    // -------------------------------------------------------------------
+    // pbr shader variants (compiled upfront to avoid hitches on the first draw)
+    double shaders_start_time = GetTime();
+    PBR_SHADERS = pbr::PBRShaderCache("pbr.vert.glsl", "pbr.frag.glsl");
+    // mode: 0 - shadow map pass, 1 - unlit, 2 - lit
+    for (int mode = 0; mode < 3; ++mode) {
+        for (int flags = 0; flags < 4; ++flags) {
+            pbr::ShaderVariant variant;
+            variant.is_shadow_map_pass = mode == 0;
+            variant.is_light_enabled = mode == 2;
+            variant.has_displacement = (flags & 1) != 0;
+            variant.is_instanced = (flags & 2) != 0;
+            PBR_SHADERS.get(variant);
+        }
     }
+    TraceLog(
+        LOG_INFO,
+        "RESOURCES: PBR shader variants are loaded in %.2f ms",
+        (GetTime() - shaders_start_time) * 1000.0
+    );
 
     // -------------------------------------------------------------------
     // meshes
-    MESHES["plane"] = gen_mesh_plane(2);
-    MESHES["cube"] = gen_mesh_cube();
-    MESHES["sphere"] = gen_mesh_sphere(64, 64);
-    MESHES["player_cylinder"] = GenMeshCylinder(0.25, gameplay_config::PLAYER_HEIGHT, 16);
+    std::pair<std::string, Mesh> builtin_meshes[] = {
+        {"plane", gen_mesh_plane(2)},
+        {"cube", gen_mesh_cube()},
+        {"sphere", gen_mesh_sphere(64, 64)},
+        {"player_cylinder", GenMeshCylinder(0.25, gameplay_config::PLAYER_HEIGHT, 16)},
+    };
+    for (auto &[key, mesh] : builtin_meshes) {
+        insert_mesh(key, mesh, key, vram::Category::MESHES);
+    }
 
     // -------------------------------------------------------------------
     // shadow maps
     for (size_t i = 0; i < SHADOW_MAPS.size(); ++i) {
-        SHADOW_MAPS[i] = LoadRenderTexture(
-            render_config::SHADOW_MAP_SIZE, render_config::SHADOW_MAP_SIZE
-        );
+        static constexpr int size = render_config::SHADOW_MAP_SIZE;
+        SHADOW_MAPS[i] = LoadRenderTexture(size, size);
         FREE_SHADOW_MAP_IDXS.insert(i);
+
+        // color texture and depth renderbuffer
+        SHADOW_MAP_VRAM_IDS[i] = vram::add(
+            vram::Category::SHADOW_MAPS,
+            "shadow_map/" + std::to_string(i),
+            vram::get_texture_n_bytes(size, size, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1)
+                + vram::get_depth_n_bytes(size, size)
+        );
     }
 }
 
-const std::unordered_map<std::string, Mesh> &get_wall_meshes() {
+void update() {
+    update_hot_reload();
+    update_material_streaming();
+    upload_pending_materials(MATERIAL_UPLOAD_BUDGET_MS);
+    destroy_released_meshes(false);
+
+    // the frame's draws stamp their requests with the new index
+    FRAME_IDX += 1;
+}
+
+const std::vector<WallMesh> &get_wall_meshes() {
     return WALL_MESHES;
 }
 
 void set_wall_meshes(std::unordered_map<std::string, Mesh> meshes) {
-    unload_wall_meshes();
-    WALL_MESHES = std::move(meshes);
+    release_wall_meshes();
+    for (auto &[key, mesh] : meshes) {
+        auto mesh_handle = add_mesh(mesh, key, vram::Category::WALL_MESHES);
+        WALL_MESHES.push_back({get_material_pbr_handle(key), mesh_handle});
+    }
 }
 
-void unload_wall_meshes() {
-    for (auto &[_, mesh] : WALL_MESHES) {
-        UnloadMesh(mesh);
+void release_wall_meshes() {
+    for (auto &wall_mesh : WALL_MESHES) {
+        release_mesh(wall_mesh.mesh);
     }
     WALL_MESHES.clear();
 }
 
 void unload() {
-    unload_wall_meshes();
+    // waits for the queued decodes (jobs are unloaded after the resources),
+    // their images are released
+    for (auto &pending : PENDING_MATERIALS) {
+        if (pending.is_ready) {
+            pending.ready_images.unload();
+        } else {
+            pending.images.get().unload();
+        }
+    }
+    PENDING_MATERIALS.clear();
+    MATERIAL_STATES.clear();
+    COOKED_MATERIALS.clear();
+    FILE_WATCHER.unload();
+
+    release_wall_meshes();
+    destroy_released_meshes(true);
     UnloadMaterial(DEFAULT_MATERIAL);
 
     // -------------------------------------------------------------------
-    // materials pbr (unload before shader since they reference it)
-    for (auto &[_, material] : MATERIALS_PBR) {
+    // materials pbr
+    MATERIALS_PBR.for_each([](MaterialHandle, pbr::MaterialPBR &material) {
         material.unload();
-    }
+    });
+    MATERIALS_PBR.clear();
+    MATERIAL_ARRAY.unload();
 
     // -------------------------------------------------------------------
-    // pbr shader
-    PBR_SHADER.unload();
+    // pbr shader variants
+    PBR_SHADERS.unload();
 
     // -------------------------------------------------------------------
     // meshes
-    for (auto &[_, mesh] : MESHES) {
+    MESHES.for_each([](MeshHandle handle, Mesh &mesh) {
         UnloadMesh(mesh);
-    }
+        vram::remove(MESH_STATES[handle.idx].vram_id);
+    });
+    MESHES.clear();
+    MESH_STATES.clear();
 
     // -------------------------------------------------------------------
     // shadow maps
-    for (auto &shadow_map : SHADOW_MAPS) {
-        UnloadRenderTexture(shadow_map);
+    for (size_t i = 0; i < SHADOW_MAPS.size(); ++i) {
+        UnloadRenderTexture(SHADOW_MAPS[i]);
+        vram::remove(SHADOW_MAP_VRAM_IDS[i]);
     }
 }
 
@@ -122,23 +528,114 @@ Material get_material_color(Color color) {
     return material;
 }
 
-pbr::PBRShader &get_pbr_shader() {
-    return PBR_SHADER;
+pbr::PBRShader &get_pbr_shader(pbr::ShaderVariant variant) {
+    return PBR_SHADERS.get(variant);
+}
+
+const pbr::MaterialArray &get_material_array() {
+    return MATERIAL_ARRAY;
+}
+
+MaterialHandle get_material_pbr_handle(const std::string &key) {
+    auto handle = MATERIALS_PBR.find(key);
+    if (!handle.is_valid()) {
+        throw std::runtime_error("Unknown pbr material: " + key);
+    }
+
+    return handle;
+}
+
+const pbr::MaterialPBR &get_material_pbr(MaterialHandle handle) {
+    use_material_pbr(handle);
+    return MATERIALS_PBR.get(handle);
 }
 
 const pbr::MaterialPBR &get_material_pbr(const std::string &key) {
-    return MATERIALS_PBR.at(key);
+    return get_material_pbr(get_material_pbr_handle(key));
+}
+
+const pbr::MaterialPBR &peek_material_pbr(MaterialHandle handle) {
+    return std::as_const(MATERIALS_PBR).get(handle);
+}
+
+void use_material_pbr(MaterialHandle handle) {
+    const auto &material = MATERIALS_PBR.get(handle);
+
+    MATERIAL_STATES[handle.idx].last_use_frame_idx = FRAME_IDX;
+    if (!material.is_resident()) request_material_pbr(handle);
+}
+
+void request_material_mip_level(MaterialHandle handle, int mip_level) {
+    auto &state = MATERIAL_STATES[handle.idx];
+    if (state.mip_request_frame_idx != FRAME_IDX) {
+        state.mip_request_frame_idx = FRAME_IDX;
+        state.requested_mip_level = mip_level;
+    } else {
+        state.requested_mip_level = std::min(state.requested_mip_level, mip_level);
+    }
+}
+
+MeshHandle get_mesh_handle(const std::string &key) {
+    auto handle = MESHES.find(key);
+    if (!handle.is_valid()) {
+        throw std::runtime_error("Unknown mesh: " + key);
+    }
+
+    return handle;
+}
+
+const Mesh &get_mesh(MeshHandle handle) {
+    return MESHES.get(handle);
 }
 
 const Mesh &get_mesh(const std::string &key) {
-    return MESHES.at(key);
+    return MESHES.get(get_mesh_handle(key));
+}
+
+BoundingBox get_mesh_bounds(MeshHandle handle) {
+    if (!MESHES.is_alive(handle)) {
+        throw std::runtime_error("Stale or invalid mesh handle");
+    }
+
+    return MESH_STATES[handle.idx].bounds;
+}
+
+MeshHandle add_mesh(Mesh mesh, const std::string &name, vram::Category category) {
+    auto handle = insert_mesh("", mesh, name, category);
+    MESH_STATES[handle.idx].n_refs = 1;
+
+    return handle;
+}
+
+void acquire_mesh(MeshHandle handle) {
+    if (!MESHES.is_alive(handle) || MESH_STATES[handle.idx].n_refs == 0) {
+        throw std::runtime_error("Can't acquire the mesh which is not reference counted");
+    }
+
+    MESH_STATES[handle.idx].n_refs += 1;
+}
+
+void release_mesh(MeshHandle handle) {
+    if (!MESHES.is_alive(handle) || MESH_STATES[handle.idx].n_refs == 0) {
+        throw std::runtime_error("Can't release the mesh which is not reference counted");
+    }
+
+    auto &state = MESH_STATES[handle.idx];
+    state.n_refs -= 1;
+    if (state.n_refs > 0) return;
+
+    Mesh mesh = MESHES.remove(handle);
+    DESTROYED_MESHES.push_back(
+        {mesh, state.vram_id, FRAME_IDX + MESH_DESTROY_DELAY_FRAMES}
+    );
+    state.vram_id = vram::INVALID_ID;
 }
 
 std::vector<std::string> get_material_pbr_keys() {
     std::vector<std::string> keys;
-    for (auto &[key, _] : MATERIALS_PBR) {
-        keys.push_back(key);
-    }
+    MATERIALS_PBR.for_each([&](MaterialHandle handle, pbr::MaterialPBR &) {
+        keys.push_back(MATERIALS_PBR.get_key(handle));
+    });
 
     return keys;
 }
@@ -1,28 +1,74 @@
 #pragma once
 
+#include "handle.hpp"
 #include "pbr.hpp"
 #include "raylib/raylib.h"
+#include "vram.hpp"
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 namespace soft_tissues::resources {
 
-pbr::PBRShader &get_pbr_shader();
+using MeshHandle = handle::Handle<Mesh>;
+using MaterialHandle = handle::Handle<pbr::MaterialPBR>;
+
+// Mesh built from all the walls of a single material
+struct WallMesh {
+    MaterialHandle material;
+    MeshHandle mesh;
+};
+
+pbr::PBRShader &get_pbr_shader(pbr::ShaderVariant variant);
 Material get_material_color(Color color);
+const pbr::MaterialArray &get_material_array();
+// Handles are resolved once, when the keys are loaded or assigned. Throw on
+// unknown keys
+MaterialHandle get_material_pbr_handle(const std::string &key);
+MeshHandle get_mesh_handle(const std::string &key);
+
+// Marks the material as used. Non-resident material is requested for loading
+// and renders with the placeholder until update() makes it resident
+const pbr::MaterialPBR &get_material_pbr(MaterialHandle handle);
+// Key lookups for the editor and one-off uses, per-frame code takes handles
 const pbr::MaterialPBR &get_material_pbr(const std::string &key);
+// Read-only lookup which doesn't mark the material as used, so it's safe on
+// the worker threads. The use is marked later, on the main thread
+const pbr::MaterialPBR &peek_material_pbr(MaterialHandle handle);
+void use_material_pbr(MaterialHandle handle);
+// Requests the material mips down to the level, the finest request of a frame
+// is streamed in by the next update()
+void request_material_mip_level(MaterialHandle handle, int mip_level);
+const Mesh &get_mesh(MeshHandle handle);
 const Mesh &get_mesh(const std::string &key);
+// Local space bounds, computed once when the mesh is added
+BoundingBox get_mesh_bounds(MeshHandle handle);
+
+// Meshes created at runtime are reference counted. The returned handle holds
+// one reference owned by the caller. When the last reference is released, the
+// handle goes stale at once, but the GPU buffers are destroyed a few frames
+// later, so the frames still in flight can finish with them. The built-in
+// meshes are owned by the resources and live until unload(). The name and
+// category are for the vram accounting
+MeshHandle add_mesh(
+    Mesh mesh, const std::string &name, vram::Category category = vram::Category::MESHES
+);
+void acquire_mesh(MeshHandle handle);
+void release_mesh(MeshHandle handle);
 
 std::vector<std::string> get_material_pbr_keys();
 
 RenderTexture2D *get_shadow_map();
 void free_shadow_map(RenderTexture2D *shadow_map);
 
-const std::unordered_map<std::string, Mesh> &get_wall_meshes();
+const std::vector<WallMesh> &get_wall_meshes();
+// Swaps the wall meshes (material key -> mesh), the previous ones are released
 void set_wall_meshes(std::unordered_map<std::string, Mesh> meshes);
-void unload_wall_meshes();
+void release_wall_meshes();
 
 void load();
+// Uploads the loaded materials, must be called once per frame
+void update();
 void unload();
 
 }  // namespace soft_tissues::resources
@@ -0,0 +1,205 @@
+#include "shader_cache.hpp"
+
+#include "gl.hpp"
+#include "raylib/raylib.h"
+#include "raylib/rlgl.h"
+#include "utils.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace soft_tissues::shader_cache {
+
+static const std::string CACHE_DIR_PATH = "cache/shaders/";
+
+// "STPB" - soft tissues program binary
+static constexpr uint32_t BINARY_FILE_MAGIC = 0x42505453;
+
+struct BinaryFileHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t size;
+};
+
+// -----------------------------------------------------------------------
+// gl helpers
+static bool is_binary_supported() {
+    gl::GLint n_formats = 0;
+    gl::GetIntegerv(gl::NUM_PROGRAM_BINARY_FORMATS, &n_formats);
+    return n_formats > 0;
+}
+
+static std::string get_driver_id() {
+    std::string id;
+    for (auto name : {gl::VENDOR, gl::RENDERER, gl::VERSION}) {
+        auto str = gl::GetString(name);
+        id += str ? reinterpret_cast<const char *>(str) : "";
+        id += "\n";
+    }
+
+    return id;
+}
+
+static bool is_linked(gl::GLuint program) {
+    gl::GLint status = 0;
+    gl::GetProgramiv(program, gl::LINK_STATUS, &status);
+    return status != 0;
+}
+
+static Shader make_shader(gl::GLuint program) {
+    Shader shader;
+    shader.id = program;
+    shader.locs = (int *)RL_CALLOC(RL_MAX_SHADER_LOCATIONS, sizeof(int));
+    for (int i = 0; i < RL_MAX_SHADER_LOCATIONS; ++i) shader.locs[i] = -1;
+
+    return shader;
+}
+
+// -----------------------------------------------------------------------
+// binary
+static gl::GLuint load_binary(const std::string &file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) return 0;
+
+    BinaryFileHeader header;
+    file.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!file || header.magic != BINARY_FILE_MAGIC) return 0;
+
+    std::vector<char> binary(header.size);
+    file.read(binary.data(), binary.size());
+    if (!file) return 0;
+
+    gl::GLuint program = gl::CreateProgram();
+    gl::ProgramBinary(program, header.format, binary.data(), binary.size());
+
+    if (!is_linked(program)) {
+        gl::DeleteProgram(program);
+        TraceLog(
+            LOG_WARNING,
+            "SHADER_CACHE: Program binary is rejected by the driver: %s",
+            file_path.c_str()
+        );
+        return 0;
+    }
+
+    return program;
+}
+
+static void save_binary(gl::GLuint program, const std::string &file_path) {
+    gl::GLint size = 0;
+    gl::GetProgramiv(program, gl::PROGRAM_BINARY_LENGTH, &size);
+    if (size <= 0) return;
+
+    BinaryFileHeader header = {BINARY_FILE_MAGIC, 0, 0};
+    std::vector<char> binary(size);
+    gl::GLsizei length = 0;
+    gl::GetProgramBinary(program, size, &length, &header.format, binary.data());
+    header.size = length;
+
+    std::error_code ec;
+    std::filesystem::create_directories(CACHE_DIR_PATH, ec);
+
+    // write into a temporary file first, so a killed process never leaves
+    // a truncated binary under the final name
+    auto tmp_file_path = file_path + ".tmp";
+    {
+        std::ofstream file(tmp_file_path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            TraceLog(
+                LOG_WARNING,
+                "SHADER_CACHE: Failed to write program binary: %s",
+                file_path.c_str()
+            );
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmp_file_path, file_path, ec);
+}
+
+// -----------------------------------------------------------------------
+// source
+static gl::GLuint compile(const std::string &vs_src, const std::string &fs_src) {
+    gl::GLuint vs = rlCompileShader(vs_src.c_str(), RL_VERTEX_SHADER);
+    gl::GLuint fs = rlCompileShader(fs_src.c_str(), RL_FRAGMENT_SHADER);
+
+    gl::GLuint program = 0;
+    if (vs != 0 && fs != 0) {
+        program = gl::CreateProgram();
+        gl::ProgramParameteri(program, gl::PROGRAM_BINARY_RETRIEVABLE_HINT, 1);
+        gl::AttachShader(program, vs);
+        gl::AttachShader(program, fs);
+        gl::LinkProgram(program);
+        gl::DetachShader(program, vs);
+        gl::DetachShader(program, fs);
+
+        if (!is_linked(program)) {
+            gl::GLint log_length = 0;
+            gl::GetProgramiv(program, gl::INFO_LOG_LENGTH, &log_length);
+            std::string log(log_length > 0 ? log_length : 1, '\0');
+            gl::GetProgramInfoLog(program, log.size(), nullptr, log.data());
+            TraceLog(LOG_WARNING, "SHADER_CACHE: Failed to link program: %s", log.c_str());
+
+            gl::DeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (vs != 0) gl::DeleteShader(vs);
+    if (fs != 0) gl::DeleteShader(fs);
+
+    return program;
+}
+
+// -----------------------------------------------------------------------
+// cache
+Shader load_shader(const std::string &vs_src, const std::string &fs_src) {
+    double start_time = GetTime();
+
+    static const bool is_supported = is_binary_supported();
+    static const uint64_t driver_hash = utils::hash_fnv1a(get_driver_id());
+
+    // sources are separated by the zero byte, so moving text from the end of
+    // the vertex shader to the start of the fragment one changes the key
+    uint64_t hash = utils::hash_fnv1a(vs_src, driver_hash);
+    hash = utils::hash_fnv1a("", 1, hash);
+    hash = utils::hash_fnv1a(fs_src, hash);
+
+    char file_name[32];
+    std::snprintf(file_name, sizeof(file_name), "%016llx.bin", (unsigned long long)hash);
+    auto file_path = CACHE_DIR_PATH + file_name;
+
+    gl::GLuint program = 0;
+    if (is_supported && (program = load_binary(file_path)) != 0) {
+        TraceLog(
+            LOG_INFO,
+            "SHADER_CACHE: [ID %u] Program loaded from binary in %.2f ms: %s",
+            program,
+            (GetTime() - start_time) * 1000.0,
+            file_path.c_str()
+        );
+        return make_shader(program);
+    }
+
+    program = compile(vs_src, fs_src);
+    if (program == 0) return Shader{0, nullptr};
+
+    if (is_supported) save_binary(program, file_path);
+
+    TraceLog(
+        LOG_INFO,
+        "SHADER_CACHE: [ID %u] Program compiled from source in %.2f ms",
+        program,
+        (GetTime() - start_time) * 1000.0
+    );
+
+    return make_shader(program);
+}
+
+}  // namespace soft_tissues::shader_cache
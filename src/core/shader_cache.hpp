@@ -0,0 +1,15 @@
+#pragma once
+
+#include "raylib/raylib.h"
+#include <string>
+
+namespace soft_tissues::shader_cache {
+
+// Links the shader program from a program binary cached on disk, or compiles it
+// from the sources and caches its binary. Cache entries are keyed by the hash of
+// the assembled sources and the driver vendor, renderer and version strings.
+// A binary which is rejected by the driver is silently rebuilt from the sources.
+// Returns a shader with zero id on failure.
+Shader load_shader(const std::string &vs_src, const std::string &fs_src);
+
+}  // namespace soft_tissues::shader_cache
@@ -18,14 +18,24 @@ TileMaterials::TileMaterials() = default;
 TileMaterials::TileMaterials(const std::string &material_pbr_key)
     : floor_key(material_pbr_key)
     , wall_key(material_pbr_key)
-    , ceil_key(material_pbr_key) {}
+    , ceil_key(material_pbr_key) {
+    this->resolve();
+}
 
 TileMaterials::TileMaterials(
     std::string floor_key, std::string wall_key, std::string ceil_key
 )
     : floor_key(std::move(floor_key))
     , wall_key(std::move(wall_key))
-    , ceil_key(std::move(ceil_key)) {}
+    , ceil_key(std::move(ceil_key)) {
+    this->resolve();
+}
+
+void TileMaterials::resolve() {
+    this->floor = resources::get_material_pbr_handle(this->floor_key);
+    this->wall = resources::get_material_pbr_handle(this->wall_key);
+    this->ceil = resources::get_material_pbr_handle(this->ceil_key);
+}
 
 nlohmann::json TileMaterials::to_json() const {
     return {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "raylib/raylib.h"
+#include "resources.hpp"
 #include "utils.hpp"
 #include "nlohmann/json.hpp"
 #include <array>
@@ -12,14 +13,23 @@ namespace soft_tissues::tile {
 using utils::Direction;
 
 struct TileMaterials {
+    // keys are kept for the serialization and the editor
     std::string floor_key;
     std::string wall_key;
     std::string ceil_key;
 
+    // resolved from the keys, resolve() must be called after changing a key.
+    // Invalid for the default constructed materials
+    resources::MaterialHandle floor;
+    resources::MaterialHandle wall;
+    resources::MaterialHandle ceil;
+
     TileMaterials();
     TileMaterials(const std::string &material_pbr_key);
     TileMaterials(std::string floor_key, std::string wall_key, std::string ceil_key);
 
+    void resolve();
+
     nlohmann::json to_json() const;
     static TileMaterials from_json(const nlohmann::json &json_data);
 };
@@ -0,0 +1,155 @@
+#include "vram.hpp"
+
+#include "nlohmann/json.hpp"
+#include "raylib/raylib.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace soft_tissues::vram {
+
+struct Allocation {
+    Category category;
+    std::string name;
+    size_t n_bytes;
+};
+
+static std::unordered_map<int, Allocation> ALLOCATIONS;
+static int NEXT_ID = 0;
+
+std::string category_to_str(Category category) {
+    switch (category) {
+        case Category::MATERIAL_MAPS: return "material_maps";
+        case Category::MATERIAL_PREVIEWS: return "material_previews";
+        case Category::MESHES: return "meshes";
+        case Category::WALL_MESHES: return "wall_meshes";
+        case Category::SHADOW_MAPS: return "shadow_maps";
+        case Category::BUFFERS: return "buffers";
+        case Category::EDITOR: return "editor";
+        default: throw std::runtime_error("Failed to get vram category name");
+    }
+}
+
+int add(Category category, std::string name, size_t n_bytes) {
+    int id = NEXT_ID++;
+    ALLOCATIONS.emplace(id, Allocation{category, std::move(name), n_bytes});
+
+    return id;
+}
+
+void remove(int id) {
+    if (id == INVALID_ID) return;
+
+    if (ALLOCATIONS.erase(id) == 0) {
+        throw std::runtime_error("Unknown vram allocation: " + std::to_string(id));
+    }
+}
+
+size_t get_n_bytes(Category category) {
+    size_t n_bytes = 0;
+    for (const auto &[_, allocation] : ALLOCATIONS) {
+        if (allocation.category == category) n_bytes += allocation.n_bytes;
+    }
+
+    return n_bytes;
+}
+
+int get_n_allocations(Category category) {
+    int n_allocations = 0;
+    for (const auto &[_, allocation] : ALLOCATIONS) {
+        if (allocation.category == category) n_allocations += 1;
+    }
+
+    return n_allocations;
+}
+
+size_t get_total_n_bytes() {
+    size_t n_bytes = 0;
+    for (const auto &[_, allocation] : ALLOCATIONS) {
+        n_bytes += allocation.n_bytes;
+    }
+
+    return n_bytes;
+}
+
+nlohmann::json to_json() {
+    std::vector<const Allocation *> allocations;
+    for (const auto &[_, allocation] : ALLOCATIONS) {
+        allocations.push_back(&allocation);
+    }
+    std::sort(allocations.begin(), allocations.end(), [](auto a, auto b) {
+        return std::tie(a->category, a->name, a->n_bytes)
+               < std::tie(b->category, b->name, b->n_bytes);
+    });
+
+    nlohmann::json json;
+    json["total_n_bytes"] = get_total_n_bytes();
+
+    json["categories"] = nlohmann::json::object();
+    for (auto category : CATEGORIES) {
+        json["categories"][category_to_str(category)] = {
+            {"n_bytes", get_n_bytes(category)},
+            {"n_allocations", get_n_allocations(category)},
+        };
+    }
+
+    json["allocations"] = nlohmann::json::array();
+    for (const auto *allocation : allocations) {
+        json["allocations"].push_back({
+            {"category", category_to_str(allocation->category)},
+            {"name", allocation->name},
+            {"n_bytes", allocation->n_bytes},
+        });
+    }
+
+    return json;
+}
+
+void save_json(const std::string &file_path) {
+    std::ofstream file(file_path);
+    if (!file) {
+        throw std::runtime_error("Failed to save vram dump: " + file_path);
+    }
+
+    file << to_json().dump(4);
+    TraceLog(LOG_INFO, "VRAM: Dump saved: %s", file_path.c_str());
+}
+
+size_t get_texture_n_bytes(int width, int height, int format, int n_mipmaps) {
+    size_t n_bytes = 0;
+    for (int level = 0; level < n_mipmaps; ++level) {
+        n_bytes += GetPixelDataSize(width, height, format);
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    return n_bytes;
+}
+
+size_t get_depth_n_bytes(int width, int height) {
+    return (size_t)width * height * 4;
+}
+
+size_t get_mesh_n_bytes(const Mesh &mesh) {
+    size_t n_floats = 0;
+    if (mesh.vertices != nullptr) n_floats += 3;
+    if (mesh.texcoords != nullptr) n_floats += 2;
+    if (mesh.texcoords2 != nullptr) n_floats += 2;
+    if (mesh.normals != nullptr) n_floats += 3;
+    if (mesh.tangents != nullptr) n_floats += 4;
+
+    size_t n_bytes = mesh.vertexCount * n_floats * sizeof(float);
+    if (mesh.colors != nullptr) n_bytes += mesh.vertexCount * 4;
+    if (mesh.indices != nullptr) {
+        n_bytes += mesh.triangleCount * 3 * sizeof(unsigned short);
+    }
+
+    return n_bytes;
+}
+
+}  // namespace soft_tissues::vram
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "nlohmann/json.hpp"
+#include "raylib/raylib.h"
+#include <array>
+#include <cstddef>
+#include <string>
+
+namespace soft_tissues::vram {
+
+enum class Category {
+    MATERIAL_MAPS = 0,
+    MATERIAL_PREVIEWS,
+    MESHES,
+    WALL_MESHES,
+    SHADOW_MAPS,
+    BUFFERS,
+    EDITOR,
+};
+
+constexpr std::array<Category, 7> CATEGORIES = {
+    Category::MATERIAL_MAPS,
+    Category::MATERIAL_PREVIEWS,
+    Category::MESHES,
+    Category::WALL_MESHES,
+    Category::SHADOW_MAPS,
+    Category::BUFFERS,
+    Category::EDITOR,
+};
+
+std::string category_to_str(Category category);
+
+// Registry of the GL allocations. It only accounts the sizes reported by the
+// allocating code, the GL objects themselves are owned by their modules. The
+// sizes are estimated from the formats and don't include the driver padding.
+// Must be used from the main thread, like the GL calls it accounts.
+inline constexpr int INVALID_ID = -1;
+
+// Returns the id for remove()
+int add(Category category, std::string name, size_t n_bytes);
+// Does nothing for the INVALID_ID
+void remove(int id);
+
+size_t get_n_bytes(Category category);
+int get_n_allocations(Category category);
+size_t get_total_n_bytes();
+
+// Totals per category and every allocation sorted by the category and name,
+// so the dumps of two builds can be diffed
+nlohmann::json to_json();
+void save_json(const std::string &file_path);
+
+// Size of the texture including its mips
+size_t get_texture_n_bytes(int width, int height, int format, int n_mipmaps);
+// Size of the depth texture or renderbuffer, 24-bit depth is padded to 4 bytes
+size_t get_depth_n_bytes(int width, int height);
+// Size of the vertex and index buffers uploaded by UploadMesh
+size_t get_mesh_n_bytes(const Mesh &mesh);
+
+}  // namespace soft_tissues::vram
@@ -18,8 +18,8 @@ using namespace utils;
 
 static constexpr int N_TILES = N_ROWS * N_COLS;
 static std::array<tile::Tile, N_TILES> TILES;
-static std::unordered_map<int, std::vector<tile::Tile *>> ROOM_ID_TO_TILES;
-static std::unordered_map<tile::Tile *, int> TILE_TO_ROOM_ID;
+static RoomIdToTiles ROOM_ID_TO_TILES;
+static TileToRoomId TILE_TO_ROOM_ID;
 
 void reset() {
     for (int i = 0; i < N_TILES; ++i) {
@@ -30,8 +30,8 @@ void reset() {
     TILE_TO_ROOM_ID.clear();
 }
 
-tile::Tile *get_tiles() {
-    return TILES.data();
+std::span<tile::Tile> get_tiles() {
+    return TILES;
 }
 
 int get_tiles_count() {
@@ -147,7 +147,7 @@ std::array<tile::Tile *, 4> get_tile_neighbors(tile::Tile *tile) {
     return neighbors;
 }
 
-std::vector<tile::Tile *> get_tiles_between_corners(
+frame_arena::Vector<tile::Tile *> get_tiles_between_corners(
     tile::Tile *corner_0, tile::Tile *corner_1
 ) {
     auto [row_0, col_0] = get_tile_row_col(corner_0);
@@ -159,7 +159,7 @@ std::vector<tile::Tile *> get_tiles_between_corners(
     int col_min = std::min(col_0, col_1);
     int col_max = std::max(col_0, col_1);
 
-    std::vector<tile::Tile *> tiles;
+    frame_arena::Vector<tile::Tile *> tiles;
     for (int row = row_min; row <= row_max; ++row) {
         for (int col = col_min; col <= col_max; ++col) {
             tile::Tile *tile = get_tile_at_row_col(row, col);
@@ -264,37 +264,27 @@ void set_door_between_neighbor_tiles(tile::Tile *tile0, tile::Tile *tile1) {
     }
 }
 
-std::vector<int> get_room_ids() {
-    std::vector<int> ids;
-    for (auto &pair : ROOM_ID_TO_TILES) {
-        ids.push_back(pair.first);
-    }
-    return ids;
-}
-
 int get_tile_room_id(tile::Tile *tile) {
-    if (TILE_TO_ROOM_ID.count(tile) == 0) {
+    // find() keeps the lookup read-only, it's called from the worker threads
+    auto it = TILE_TO_ROOM_ID.find(tile);
+    if (it == TILE_TO_ROOM_ID.end()) {
         return -1;
     }
 
-    return TILE_TO_ROOM_ID[tile];
+    return it->second;
 }
 
-std::vector<tile::Tile *> get_room_tiles(int room_id) {
-    if (ROOM_ID_TO_TILES.count(room_id) == 0) {
-        return {};
-    }
-
-    return ROOM_ID_TO_TILES[room_id];
+const RoomIdToTiles &get_rooms() {
+    return ROOM_ID_TO_TILES;
 }
 
-std::vector<tile::Tile *> get_all_rooms_tiles() {
-    std::vector<tile::Tile *> tiles;
-    for (auto &[room_id, room_tiles] : ROOM_ID_TO_TILES) {
-        tiles.insert(tiles.end(), room_tiles.begin(), room_tiles.end());
+std::span<tile::Tile *const> get_room_tiles(int room_id) {
+    auto it = ROOM_ID_TO_TILES.find(room_id);
+    if (it == ROOM_ID_TO_TILES.end()) {
+        return {};
     }
 
-    return tiles;
+    return it->second;
 }
 
 void set_room_tile_materials(int room_id, tile::TileMaterials materials) {
@@ -325,12 +315,8 @@ void add_tile_to_room(tile::Tile *tile, int room_id) {
     }
 }
 
-std::vector<std::pair<tile::Tile *, int>> get_tiles_with_room_ids() {
-    std::vector<std::pair<tile::Tile *, int>> result;
-    for (const auto &[tile, room_id] : TILE_TO_ROOM_ID) {
-        result.push_back({tile, room_id});
-    }
-    return result;
+const TileToRoomId &get_tiles_with_room_ids() {
+    return TILE_TO_ROOM_ID;
 }
 
 void load_tile_to_room(tile::Tile tile, int room_id) {
@@ -1,9 +1,13 @@
 #pragma once
 
+#include "core/frame_arena.hpp"
 #include "raylib/raylib.h"
 #include "tile.hpp"
 #include "world_config.hpp"
 #include <array>
+#include <ranges>
+#include <span>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -11,7 +15,8 @@ namespace soft_tissues::world {
 
 void reset();
 
-tile::Tile *get_tiles();
+// All tiles, the storage is fixed, so the span is never invalidated
+std::span<tile::Tile> get_tiles();
 int get_tiles_count();
 int get_rooms_count();
 
@@ -24,7 +29,9 @@ tile::Tile *get_nearest_tile_neighbor_at_position(Vector2 pos);
 
 std::pair<int, int> get_tile_row_col(tile::Tile *tile);
 std::array<tile::Tile *, 4> get_tile_neighbors(tile::Tile *tile);
-std::vector<tile::Tile *> get_tiles_between_corners(
+// The tile list lives in the frame arena, it must not be kept beyond the
+// current frame
+frame_arena::Vector<tile::Tile *> get_tiles_between_corners(
     tile::Tile *corner_0, tile::Tile *corner_1
 );
 
@@ -34,17 +41,40 @@ void remove_room(int room_id);
 void clear_tile(tile::Tile *tile);
 void set_door_between_neighbor_tiles(tile::Tile *tile0, tile::Tile *tile1);
 
-std::vector<int> get_room_ids();
 int get_tile_room_id(tile::Tile *tile);
-std::vector<tile::Tile *> get_room_tiles(int room_id);
-std::vector<tile::Tile *> get_all_rooms_tiles();
+
+// -----------------------------------------------------------------------
+// room queries
+// Views over the world storage, they don't allocate. Iteration stability:
+// - a room's tile span is invalidated by any change of that room's tiles
+//   (add_tile_to_room, clear_tile, load_tile_to_room), by remove_room and reset;
+// - the room views and the tile room ids are invalidated by any room or
+//   tile change (add_room as well), so collect what is needed before
+//   modifying the world inside such a loop;
+// - the room order and the tile order within the views are unspecified.
+using RoomIdToTiles = std::unordered_map<int, std::vector<tile::Tile *>>;
+using TileToRoomId = std::unordered_map<tile::Tile *, int>;
+
+const RoomIdToTiles &get_rooms();
+
+inline auto get_room_ids() {
+    return std::views::keys(get_rooms());
+}
+
+// Empty for a nonexistent room
+std::span<tile::Tile *const> get_room_tiles(int room_id);
+
+inline auto get_all_rooms_tiles() {
+    return std::views::join(std::views::values(get_rooms()));
+}
 
 void set_room_tile_materials(int room_id, tile::TileMaterials materials);
 
 void add_tile_to_room(tile::Tile *tile, int room_id);
 
 // serialization helpers
-std::vector<std::pair<tile::Tile *, int>> get_tiles_with_room_ids();
+// (tile, room_id) pairs of all room tiles, with the stability of the room views
+const TileToRoomId &get_tiles_with_room_ids();
 void load_tile_to_room(tile::Tile tile, int room_id);
 
 }  // namespace soft_tissues::world
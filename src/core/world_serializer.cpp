@@ -1,196 +1,827 @@
 #include "world_serializer.hpp"
 
+// before the components, their inline to_json instantiate the entity serializer
+#include "serializers.hpp"
+
 #include "component/component.hpp"
 #include "globals.hpp"
+#include "pack.hpp"
 #include "prefabs.hpp"
+#include "resources.hpp"
 #include "tile.hpp"
 #include "world.hpp"
 #include "nlohmann/json.hpp"
 #include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <bit>
 #include <cstdint>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <unordered_set>
+#include <variant>
 #include <vector>
 
 namespace soft_tissues::world_serializer {
 
-void save(const std::string &file_path) {
-    nlohmann::json json;
+// -----------------------------------------------------------------------
+// world data
+
+WorldData capture() {
+    WorldData data;
 
     // -------------------------------------------------------------------
     // TILES
-    json["tiles"] = nlohmann::json::array();
+    // sorted by the id, so the same world gives the same file
     for (const auto &[tile, room_id] : world::get_tiles_with_room_ids()) {
-        nlohmann::json tile_json = tile->to_json();
-        tile_json["room_id"] = room_id;
-        json["tiles"].push_back(tile_json);
+        const auto &materials = tile->materials;
+        data.tiles.push_back(
+            {tile->id,
+             room_id,
+             tile->walls,
+             tile->constant_color,
+             materials.floor_key,
+             materials.wall_key,
+             materials.ceil_key}
+        );
     }
+    std::sort(data.tiles.begin(), data.tiles.end(), [](const auto &a, const auto &b) {
+        return a.id < b.id;
+    });
 
     // -------------------------------------------------------------------
     // ENTITIES
-    json["entities"] = nlohmann::json::array();
-    auto view = globals::registry.view<entt::entity>();
-    for (auto entity : view) {
+    const auto &reg = globals::registry;
+    for (auto entity : reg.view<entt::entity>()) {
         // skip entities with no serializable components
-        bool has_serializable =
-            globals::registry.any_of<
-                component::Transform,
-                component::MyMesh,
-                component::Parent,
-                component::Light,
-                component::Player,
-                component::Flashlight
-            >(entity);
+        bool has_serializable = reg.any_of<
+            component::Transform,
+            component::MyMesh,
+            component::Parent,
+            component::Light,
+            component::Player,
+            component::Flashlight>(entity);
         if (!has_serializable) continue;
 
-        nlohmann::json entity_json;
-
-        // id
-        entity_json["id"] = static_cast<uint32_t>(entity);
+        uint32_t id = static_cast<uint32_t>(entity);
+        data.entities.push_back(id);
 
-        // Transform
-        if (globals::registry.all_of<component::Transform>(entity)) {
-            auto &c = globals::registry.get<component::Transform>(entity);
-            entity_json["Transform"] = c.to_json();
+        if (const auto *c = reg.try_get<component::Transform>(entity)) {
+            data.transforms.push_back({id, *c});
         }
-
-        // MyMesh
-        if (globals::registry.all_of<component::MyMesh>(entity)) {
-            auto &c = globals::registry.get<component::MyMesh>(entity);
-            entity_json["MyMesh"] = c.to_json();
+        if (const auto *c = reg.try_get<component::MyMesh>(entity)) {
+            data.meshes.push_back({id, {c->mesh_key, c->material_pbr_key, c->constant_color}});
         }
+        if (const auto *c = reg.try_get<component::Parent>(entity)) {
+            data.parents.push_back({id, static_cast<uint32_t>(c->entity)});
+        }
+        if (const auto *c = reg.try_get<component::Light>(entity)) {
+            data.lights.push_back({id, *c});
+        }
+        if (reg.all_of<component::Player>(entity)) data.players.push_back(id);
+        if (reg.all_of<component::Flashlight>(entity)) data.flashlights.push_back(id);
+    }
 
-        // Parent
-        if (globals::registry.all_of<component::Parent>(entity)) {
-            auto &c = globals::registry.get<component::Parent>(entity);
-            entity_json["Parent"] = c.to_json();
+    return data;
+}
+
+// Everything apply() could fail on, checked before the world is cleared
+static void validate(const WorldData &data) {
+    for (const auto &t : data.tiles) {
+        if (t.id >= (uint32_t)world::get_tiles_count() || t.room_id < 0) {
+            throw std::runtime_error("World tile " + std::to_string(t.id) + " is out of bounds");
         }
 
-        // Light
-        if (globals::registry.all_of<component::Light>(entity)) {
-            auto &c = globals::registry.get<component::Light>(entity);
-            entity_json["Light"] = c.to_json();
+        // throw on the unknown keys
+        resources::get_material_pbr_handle(t.floor_key);
+        resources::get_material_pbr_handle(t.wall_key);
+        resources::get_material_pbr_handle(t.ceil_key);
+    }
+
+    std::unordered_set<uint32_t> ids(data.entities.begin(), data.entities.end());
+    auto check_id = [&](uint32_t id) {
+        if (ids.count(id) == 0) {
+            throw std::runtime_error("World component of unknown entity " + std::to_string(id));
         }
+    };
+    for (const auto &r : data.transforms) check_id(r.entity);
+    for (const auto &r : data.lights) check_id(r.entity);
+    for (const auto &r : data.parents) check_id(r.entity);
+    for (uint32_t id : data.players) check_id(id);
+    for (uint32_t id : data.flashlights) check_id(id);
+
+    for (const auto &[id, mesh] : data.meshes) {
+        check_id(id);
+        resources::get_mesh_handle(mesh.mesh_key);
+        resources::get_material_pbr_handle(mesh.material_pbr_key);
+    }
+}
+
+void apply(const WorldData &data) {
+    auto &reg = globals::registry;
+
+    validate(data);
+
+    reg.clear();
+    world::reset();
+
+    // -------------------------------------------------------------------
+    // TILES
+    for (const auto &t : data.tiles) {
+        tile::TileMaterials materials(t.floor_key, t.wall_key, t.ceil_key);
+        tile::Tile tile(t.id, t.walls, materials, t.constant_color);
+        world::load_tile_to_room(tile, t.room_id);
+    }
+
+    // -------------------------------------------------------------------
+    // ENTITIES
+    std::unordered_map<uint32_t, entt::entity> id_map;
+    for (uint32_t id : data.entities) {
+        id_map[id] = reg.create();
+    }
 
-        // Player
-        if (globals::registry.all_of<component::Player>(entity)) {
-            entity_json["Player"] = component::Player().to_json();
+    auto get_entity = [&](uint32_t id) {
+        auto it = id_map.find(id);
+        if (it == id_map.end()) {
+            throw std::runtime_error("World component of unknown entity " + std::to_string(id));
         }
+        return it->second;
+    };
+
+    for (const auto &[id, transform] : data.transforms) {
+        reg.emplace<component::Transform>(get_entity(id), transform);
+    }
+
+    for (const auto &[id, mesh] : data.meshes) {
+        component::MyMesh my_mesh(mesh.mesh_key, mesh.material_pbr_key);
+        my_mesh.constant_color = mesh.constant_color;
+        reg.emplace<component::MyMesh>(get_entity(id), std::move(my_mesh));
+    }
 
-        // Flashlight
-        if (globals::registry.all_of<component::Flashlight>(entity)) {
-            entity_json["Flashlight"] = component::Flashlight().to_json();
+    for (const auto &[id, light] : data.lights) {
+        reg.emplace<component::Light>(get_entity(id), light);
+    }
+
+    for (uint32_t id : data.players) {
+        reg.emplace<component::Player>(get_entity(id));
+    }
+
+    for (uint32_t id : data.flashlights) {
+        reg.emplace<component::Flashlight>(get_entity(id));
+    }
+
+    // assign parents after all entities have been created
+    for (const auto &[id, parent_id] : data.parents) {
+        if (id_map.count(parent_id) == 0) {
+            TraceLog(LOG_WARNING, "Skipping parent assignment: entity %u not found", parent_id);
+            continue;
         }
+        reg.emplace<component::Parent>(get_entity(id), component::Parent{id_map[parent_id]});
+    }
 
-        json["entities"].push_back(entity_json);
+    // ensure a player exists — corrupt or hand-edited saves may lack one
+    if (reg.view<component::Player>().empty()) {
+        TraceLog(LOG_WARNING, "Loaded world has no player, spawning default");
+        prefabs::spawn_player(world::ORIGIN);
     }
+}
+
+// -----------------------------------------------------------------------
+// json
+
+nlohmann::json to_json(const WorldData &data) {
+    nlohmann::json json;
 
     // -------------------------------------------------------------------
-    // save file
-    std::ofstream file(file_path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file for writing: " + file_path);
+    // TILES
+    json["tiles"] = nlohmann::json::array();
+    for (const auto &t : data.tiles) {
+        json["tiles"].push_back({
+            {"id", t.id},
+            {"walls", t.walls},
+            {"materials", {{"floor", t.floor_key}, {"wall", t.wall_key}, {"ceil", t.ceil_key}}},
+            {"constant_color", t.constant_color},
+            {"room_id", t.room_id},
+        });
     }
 
-    file << json.dump(4);
+    // -------------------------------------------------------------------
+    // ENTITIES
+    json["entities"] = nlohmann::json::array();
+    std::unordered_map<uint32_t, size_t> idxs;
+    for (uint32_t id : data.entities) {
+        idxs[id] = json["entities"].size();
+        json["entities"].push_back({{"id", id}});
+    }
 
-    if (file.fail()) {
-        throw std::runtime_error("Failed to write to file: " + file_path);
+    auto get_entity_json = [&](uint32_t id) -> nlohmann::json & {
+        auto it = idxs.find(id);
+        if (it == idxs.end()) {
+            throw std::runtime_error("World component of unknown entity " + std::to_string(id));
+        }
+        return json["entities"][it->second];
+    };
+
+    for (const auto &[id, transform] : data.transforms) {
+        get_entity_json(id)["Transform"] = transform.to_json();
     }
 
-    file.close();
-}
+    for (const auto &[id, mesh] : data.meshes) {
+        get_entity_json(id)["MyMesh"] = {
+            {"mesh_key", mesh.mesh_key},
+            {"material_pbr_key", mesh.material_pbr_key},
+            {"constant_color", mesh.constant_color},
+        };
+    }
 
-void load(const std::string &file_path) {
-    // parse file before clearing state — a failed parse must not wipe the world
-    std::ifstream file(file_path);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + file_path);
+    for (const auto &[id, parent_id] : data.parents) {
+        get_entity_json(id)["Parent"] = {{"entity", parent_id}};
     }
 
-    nlohmann::json json;
-    file >> json;
-    file.close();
+    for (const auto &[id, light] : data.lights) {
+        get_entity_json(id)["Light"] = light.to_json();
+    }
 
-    globals::registry.clear();
-    world::reset();
+    for (uint32_t id : data.players) {
+        get_entity_json(id)["Player"] = component::Player().to_json();
+    }
+
+    for (uint32_t id : data.flashlights) {
+        get_entity_json(id)["Flashlight"] = component::Flashlight().to_json();
+    }
+
+    return json;
+}
+
+WorldData from_json(const nlohmann::json &json) {
+    WorldData data;
 
     // -------------------------------------------------------------------
     // TILES
     for (const auto &tile_json : json["tiles"]) {
-        tile::Tile tile = tile::Tile::from_json(tile_json);
-        int room_id = tile_json["room_id"];
-        world::load_tile_to_room(tile, room_id);
+        const auto &materials_json = tile_json["materials"];
+        data.tiles.push_back(
+            {tile_json["id"].get<uint32_t>(),
+             tile_json["room_id"].get<int>(),
+             tile_json["walls"].get<std::array<tile::TileWall, 4>>(),
+             tile_json["constant_color"].get<Color>(),
+             materials_json["floor"].get<std::string>(),
+             materials_json["wall"].get<std::string>(),
+             materials_json["ceil"].get<std::string>()}
+        );
     }
 
     // -------------------------------------------------------------------
     // ENTITIES
-    std::unordered_map<uint32_t, entt::entity> id_map;
-    std::vector<std::pair<entt::entity, uint32_t>> parents_to_assign;
-
     for (const auto &entity_json : json["entities"]) {
-        uint32_t old_id = entity_json["id"].get<uint32_t>();
-        auto new_entity = globals::registry.create();
-        id_map[old_id] = new_entity;
+        uint32_t id = entity_json["id"].get<uint32_t>();
+        data.entities.push_back(id);
 
-        // Transform
         if (entity_json.contains("Transform")) {
-            auto transform = component::Transform::from_json(
-                entity_json["Transform"]
+            data.transforms.push_back(
+                {id, component::Transform::from_json(entity_json["Transform"])}
             );
-            globals::registry.emplace<component::Transform>(new_entity, std::move(transform));
         }
 
-        // MyMesh
         if (entity_json.contains("MyMesh")) {
-            auto my_mesh = component::MyMesh::from_json(entity_json["MyMesh"]);
-            globals::registry.emplace<component::MyMesh>(new_entity, std::move(my_mesh));
+            const auto &mesh_json = entity_json["MyMesh"];
+            data.meshes.push_back(
+                {id,
+                 {mesh_json["mesh_key"].get<std::string>(),
+                  mesh_json["material_pbr_key"].get<std::string>(),
+                  mesh_json["constant_color"].get<Color>()}}
+            );
         }
 
-        // Parent
         if (entity_json.contains("Parent")) {
-            auto parent_json = entity_json["Parent"];
-            uint32_t parent_old_id = parent_json["entity"].get<uint32_t>();
-            parents_to_assign.push_back({new_entity, parent_old_id});
+            data.parents.push_back({id, entity_json["Parent"]["entity"].get<uint32_t>()});
         }
 
-        // Light
         if (entity_json.contains("Light")) {
-            auto light = component::Light::from_json(entity_json["Light"]);
-            globals::registry.emplace<component::Light>(new_entity, std::move(light));
+            data.lights.push_back({id, component::Light::from_json(entity_json["Light"])});
+        }
+
+        if (entity_json.contains("Player")) data.players.push_back(id);
+        if (entity_json.contains("Flashlight")) data.flashlights.push_back(id);
+    }
+
+    return data;
+}
+
+// -----------------------------------------------------------------------
+// binary
+// Little-endian sections of the packed arrays and the fixed-size records,
+// the strings are referenced by their index in the string table. A reader
+// skips the section types it doesn't know, so a section can be added without
+// breaking the older readers; a changed layout bumps the version.
+
+// the records are copied in the host byte order
+static_assert(std::endian::native == std::endian::little, "World files are little-endian");
+
+// "STWD" - soft tissues world
+static constexpr uint32_t WORLD_FILE_MAGIC = 0x44575453;
+static constexpr uint32_t WORLD_FILE_VERSION = 1;
+
+// Followed by the n_sections sections
+struct WorldFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_sections;
+};
+
+// Followed by the n_bytes of the section payload
+struct SectionHeader {
+    uint32_t type;
+    uint32_t n_bytes;
+};
+
+enum class SectionType : uint32_t {
+    // n, then n times (size, chars)
+    STRINGS = 1,
+    // n, then the arrays of n: ids, room ids, walls (4 bytes), constant colors,
+    // floor, wall and ceil material strings
+    TILES,
+    // n, then n saved ids
+    ENTITIES,
+    // n, then n records of TransformRecord, MeshRecord, ...
+    TRANSFORMS,
+    MESHES,
+    PARENTS,
+    LIGHTS,
+    // n, then n saved ids
+    PLAYERS,
+    FLASHLIGHTS,
+};
+
+struct TransformRecord {
+    uint32_t entity;
+    Vector3 position;
+    Vector3 scale;
+    Quaternion rotation;
+};
+
+struct MeshRecord {
+    uint32_t entity;
+    uint32_t mesh_key;
+    uint32_t material_pbr_key;
+    Color constant_color;
+};
+
+struct ParentRecord {
+    uint32_t entity;
+    uint32_t parent;
+};
+
+// The params of all light types, unused ones are zero
+struct LightRecord {
+    uint32_t entity;
+    uint8_t light_type;
+    uint8_t shadow_type;
+    uint8_t is_on;
+    uint8_t casts_shadows;
+    Color color;
+    float intensity;
+    Vector3 attenuation;
+    float inner_cutoff;
+    float outer_cutoff;
+};
+
+static_assert(sizeof(TransformRecord) == 44);
+static_assert(sizeof(MeshRecord) == 16);
+static_assert(sizeof(ParentRecord) == 8);
+static_assert(sizeof(LightRecord) == 36);
+
+class Writer {
+private:
+    std::vector<unsigned char> bytes;
+    size_t section_offset = 0;
+    uint32_t n_sections = 0;
+
+public:
+    Writer() {
+        this->write(WorldFileHeader{WORLD_FILE_MAGIC, WORLD_FILE_VERSION, 0});
+    }
+
+    template <typename T> void write(const T &value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto *p = reinterpret_cast<const unsigned char *>(&value);
+        this->bytes.insert(this->bytes.end(), p, p + sizeof(T));
+    }
+
+    template <typename T, typename F> void write_array(const std::vector<T> &values, F &&get) {
+        for (const auto &value : values) {
+            this->write(get(value));
         }
+    }
+
+    void begin_section(SectionType type, size_t n) {
+        this->section_offset = this->bytes.size();
+        this->write(SectionHeader{static_cast<uint32_t>(type), 0});
+        this->write(static_cast<uint32_t>(n));
+    }
+
+    void end_section() {
+        SectionHeader header;
+        std::memcpy(&header, &this->bytes[this->section_offset], sizeof(header));
+        header.n_bytes = this->bytes.size() - this->section_offset - sizeof(header);
+        std::memcpy(&this->bytes[this->section_offset], &header, sizeof(header));
+
+        this->n_sections += 1;
+    }
+
+    std::vector<unsigned char> finish() {
+        WorldFileHeader header = {WORLD_FILE_MAGIC, WORLD_FILE_VERSION, this->n_sections};
+        std::memcpy(this->bytes.data(), &header, sizeof(header));
+
+        return std::move(this->bytes);
+    }
+};
+
+class Reader {
+private:
+    std::span<const unsigned char> bytes;
+    size_t offset = 0;
 
-        // Player
-        if (entity_json.contains("Player")) {
-            globals::registry.emplace<component::Player>(new_entity);
+public:
+    explicit Reader(std::span<const unsigned char> bytes)
+        : bytes(bytes) {}
+
+    bool is_end() const {
+        return this->offset == this->bytes.size();
+    }
+
+    template <typename T> T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (this->bytes.size() - this->offset < sizeof(T)) {
+            throw std::runtime_error("World file is truncated");
         }
 
-        // Flashlight
-        if (entity_json.contains("Flashlight")) {
-            globals::registry.emplace<component::Flashlight>(new_entity);
+        T value;
+        std::memcpy(&value, this->bytes.data() + this->offset, sizeof(T));
+        this->offset += sizeof(T);
+
+        return value;
+    }
+
+    std::string read_str(size_t n) {
+        if (this->bytes.size() - this->offset < n) {
+            throw std::runtime_error("World file is truncated");
         }
+
+        auto *p = reinterpret_cast<const char *>(this->bytes.data() + this->offset);
+        this->offset += n;
+
+        return std::string(p, n);
     }
 
-    // assign parents after all entities have been created
-    for (const auto &[child_entity, parent_old_id] : parents_to_assign) {
-        if (id_map.count(parent_old_id) == 0) {
-            TraceLog(LOG_WARNING, "Skipping parent assignment: entity %u not found", parent_old_id);
-            continue;
+    // Reader of the next n bytes, which are skipped by this one
+    Reader read_reader(size_t n) {
+        if (this->bytes.size() - this->offset < n) {
+            throw std::runtime_error("World file is truncated");
+        }
+
+        Reader reader(this->bytes.subspan(this->offset, n));
+        this->offset += n;
+
+        return reader;
+    }
+
+    template <typename T> void read_array(std::vector<T> &values, size_t n) {
+        if ((this->bytes.size() - this->offset) / sizeof(T) < n) {
+            throw std::runtime_error("World file is truncated");
+        }
+
+        values.resize(n);
+        for (auto &value : values) {
+            value = this->read<T>();
         }
-        entt::entity parent_entity = id_map[parent_old_id];
-        globals::registry.emplace<component::Parent>(
-            child_entity, component::Parent{parent_entity}
+    }
+};
+
+static void check(bool condition) {
+    if (!condition) throw std::runtime_error("World file is corrupted");
+}
+
+std::vector<unsigned char> to_binary(const WorldData &data) {
+    // string table in the order of the first use
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint32_t> string_idxs;
+    auto get_string_idx = [&](const std::string &str) {
+        auto [it, is_new] = string_idxs.try_emplace(str, strings.size());
+        if (is_new) strings.push_back(str);
+        return it->second;
+    };
+
+    for (const auto &t : data.tiles) {
+        get_string_idx(t.floor_key);
+        get_string_idx(t.wall_key);
+        get_string_idx(t.ceil_key);
+    }
+    for (const auto &[_, mesh] : data.meshes) {
+        get_string_idx(mesh.mesh_key);
+        get_string_idx(mesh.material_pbr_key);
+    }
+
+    Writer writer;
+
+    writer.begin_section(SectionType::STRINGS, strings.size());
+    for (const auto &str : strings) {
+        writer.write(static_cast<uint32_t>(str.size()));
+        for (char c : str) writer.write(c);
+    }
+    writer.end_section();
+
+    const auto &tiles = data.tiles;
+    writer.begin_section(SectionType::TILES, tiles.size());
+    writer.write_array(tiles, [](const auto &t) { return t.id; });
+    writer.write_array(tiles, [](const auto &t) { return static_cast<int32_t>(t.room_id); });
+    for (const auto &t : tiles) {
+        for (auto wall : t.walls) writer.write(static_cast<uint8_t>(wall));
+    }
+    writer.write_array(tiles, [](const auto &t) { return t.constant_color; });
+    writer.write_array(tiles, [&](const auto &t) { return get_string_idx(t.floor_key); });
+    writer.write_array(tiles, [&](const auto &t) { return get_string_idx(t.wall_key); });
+    writer.write_array(tiles, [&](const auto &t) { return get_string_idx(t.ceil_key); });
+    writer.end_section();
+
+    writer.begin_section(SectionType::ENTITIES, data.entities.size());
+    writer.write_array(data.entities, [](uint32_t id) { return id; });
+    writer.end_section();
+
+    writer.begin_section(SectionType::TRANSFORMS, data.transforms.size());
+    writer.write_array(data.transforms, [](const auto &r) {
+        return TransformRecord{r.entity, r.value.position, r.value.scale, r.value.rotation};
+    });
+    writer.end_section();
+
+    writer.begin_section(SectionType::MESHES, data.meshes.size());
+    writer.write_array(data.meshes, [&](const auto &r) {
+        return MeshRecord{
+            r.entity,
+            get_string_idx(r.value.mesh_key),
+            get_string_idx(r.value.material_pbr_key),
+            r.value.constant_color
+        };
+    });
+    writer.end_section();
+
+    writer.begin_section(SectionType::PARENTS, data.parents.size());
+    writer.write_array(data.parents, [](const auto &r) { return ParentRecord{r.entity, r.value}; });
+    writer.end_section();
+
+    writer.begin_section(SectionType::LIGHTS, data.lights.size());
+    writer.write_array(data.lights, [](const auto &r) {
+        const auto &light = r.value;
+        LightRecord record = {
+            r.entity,
+            static_cast<uint8_t>(light.light_type),
+            static_cast<uint8_t>(light.shadow_type),
+            light.is_on,
+            light.casts_shadows,
+            light.color,
+            light.intensity,
+            {0.0, 0.0, 0.0},
+            0.0,
+            0.0
+        };
+        if (const auto *p = std::get_if<component::PointParams>(&light.params)) {
+            record.attenuation = p->attenuation;
+        } else if (const auto *p = std::get_if<component::SpotParams>(&light.params)) {
+            record.attenuation = p->attenuation;
+            record.inner_cutoff = p->inner_cutoff;
+            record.outer_cutoff = p->outer_cutoff;
+        }
+        return record;
+    });
+    writer.end_section();
+
+    writer.begin_section(SectionType::PLAYERS, data.players.size());
+    writer.write_array(data.players, [](uint32_t id) { return id; });
+    writer.end_section();
+
+    writer.begin_section(SectionType::FLASHLIGHTS, data.flashlights.size());
+    writer.write_array(data.flashlights, [](uint32_t id) { return id; });
+    writer.end_section();
+
+    return writer.finish();
+}
+
+static component::Light to_light(const LightRecord &record) {
+    auto light_type = static_cast<component::LightType>(record.light_type);
+    auto shadow_type = static_cast<component::ShadowType>(record.shadow_type);
+    check(record.light_type < component::LIGHT_TYPES.size());
+    check(record.shadow_type < component::SHADOW_TYPES.size());
+
+    component::LightParams params = component::PointParams{record.attenuation};
+    switch (light_type) {
+        case component::LightType::SPOT: {
+            params = component::SpotParams{
+                record.attenuation, record.inner_cutoff, record.outer_cutoff
+            };
+        } break;
+        case component::LightType::DIRECTIONAL: params = component::DirectionalParams{}; break;
+        case component::LightType::AMBIENT: params = component::AmbientParams{}; break;
+        default: break;
+    }
+
+    component::Light light(light_type, record.color, record.intensity, params);
+    light.is_on = record.is_on;
+    light.casts_shadows = record.casts_shadows;
+    light.shadow_type = shadow_type;
+
+    return light;
+}
+
+WorldData from_binary(std::span<const unsigned char> bytes) {
+    Reader reader(bytes);
+
+    auto header = reader.read<WorldFileHeader>();
+    if (header.magic != WORLD_FILE_MAGIC) {
+        throw std::runtime_error("Not a world file");
+    }
+    if (header.version != WORLD_FILE_VERSION) {
+        throw std::runtime_error(
+            "Unsupported world file version " + std::to_string(header.version)
         );
     }
 
-    // ensure a player exists — corrupt or hand-edited saves may lack one
-    auto player_view = globals::registry.view<component::Player>();
-    if (player_view.empty()) {
-        TraceLog(LOG_WARNING, "Loaded world has no player, spawning default");
-        prefabs::spawn_player(world::ORIGIN);
+    WorldData data;
+    std::vector<std::string> strings;
+    auto get_string = [&](uint32_t idx) -> const std::string & {
+        check(idx < strings.size());
+        return strings[idx];
+    };
+
+    for (uint32_t i = 0; i < header.n_sections; ++i) {
+        auto section_header = reader.read<SectionHeader>();
+        Reader section = reader.read_reader(section_header.n_bytes);
+        size_t n = section.read<uint32_t>();
+
+        switch (static_cast<SectionType>(section_header.type)) {
+            case SectionType::STRINGS: {
+                for (size_t k = 0; k < n; ++k) {
+                    strings.push_back(section.read_str(section.read<uint32_t>()));
+                }
+            } break;
+            case SectionType::TILES: {
+                std::vector<uint32_t> ids;
+                std::vector<int32_t> room_ids;
+                std::vector<std::array<uint8_t, 4>> walls;
+                std::vector<Color> colors;
+                std::array<std::vector<uint32_t>, 3> materials;
+                section.read_array(ids, n);
+                section.read_array(room_ids, n);
+                section.read_array(walls, n);
+                section.read_array(colors, n);
+                for (auto &keys : materials) section.read_array(keys, n);
+
+                for (size_t k = 0; k < n; ++k) {
+                    check(ids[k] < (uint32_t)world::get_tiles_count() && room_ids[k] >= 0);
+
+                    auto &t = data.tiles.emplace_back();
+                    t.id = ids[k];
+                    t.room_id = room_ids[k];
+                    for (int w = 0; w < 4; ++w) {
+                        check(walls[k][w] <= static_cast<uint8_t>(tile::TileWall::SOLID));
+                        t.walls[w] = static_cast<tile::TileWall>(walls[k][w]);
+                    }
+                    t.constant_color = colors[k];
+                    t.floor_key = get_string(materials[0][k]);
+                    t.wall_key = get_string(materials[1][k]);
+                    t.ceil_key = get_string(materials[2][k]);
+                }
+            } break;
+            case SectionType::ENTITIES: {
+                section.read_array(data.entities, n);
+            } break;
+            case SectionType::TRANSFORMS: {
+                for (size_t k = 0; k < n; ++k) {
+                    // renormalized like in Transform::from_json, so both formats
+                    // load the same world
+                    auto r = section.read<TransformRecord>();
+                    Quaternion rotation = QuaternionNormalize(r.rotation);
+                    data.transforms.push_back(
+                        {r.entity, component::Transform(r.position, r.scale, rotation)}
+                    );
+                }
+            } break;
+            case SectionType::MESHES: {
+                for (size_t k = 0; k < n; ++k) {
+                    auto r = section.read<MeshRecord>();
+                    data.meshes.push_back(
+                        {r.entity,
+                         {get_string(r.mesh_key),
+                          get_string(r.material_pbr_key),
+                          r.constant_color}}
+                    );
+                }
+            } break;
+            case SectionType::PARENTS: {
+                for (size_t k = 0; k < n; ++k) {
+                    auto r = section.read<ParentRecord>();
+                    data.parents.push_back({r.entity, r.parent});
+                }
+            } break;
+            case SectionType::LIGHTS: {
+                for (size_t k = 0; k < n; ++k) {
+                    auto r = section.read<LightRecord>();
+                    data.lights.push_back({r.entity, to_light(r)});
+                }
+            } break;
+            case SectionType::PLAYERS: {
+                section.read_array(data.players, n);
+            } break;
+            case SectionType::FLASHLIGHTS: {
+                section.read_array(data.flashlights, n);
+            } break;
+            default: continue;
+        }
+
+        check(section.is_end());
+    }
+
+    check(reader.is_end());
+
+    // every id is unique and each component belongs to a known entity which
+    // has no other component of that type: otherwise the load would fail (or
+    // emplace twice) after the world is already cleared
+    std::unordered_set<uint32_t> tile_ids;
+    for (const auto &t : data.tiles) check(tile_ids.insert(t.id).second);
+
+    std::unordered_set<uint32_t> ids;
+    for (uint32_t id : data.entities) check(ids.insert(id).second);
+
+    auto check_ids = [&](const auto &records, auto get_id) {
+        std::unordered_set<uint32_t> component_ids;
+        for (const auto &r : records) {
+            uint32_t id = get_id(r);
+            check(ids.count(id) != 0 && component_ids.insert(id).second);
+        }
+    };
+    auto get_record_id = [](const auto &r) { return r.entity; };
+    auto get_tag_id = [](uint32_t id) { return id; };
+    check_ids(data.transforms, get_record_id);
+    check_ids(data.meshes, get_record_id);
+    check_ids(data.parents, get_record_id);
+    check_ids(data.lights, get_record_id);
+    check_ids(data.players, get_tag_id);
+    check_ids(data.flashlights, get_tag_id);
+
+    return data;
+}
+
+// -----------------------------------------------------------------------
+// files
+
+static bool is_binary(const std::string &file_path) {
+    return std::filesystem::path(file_path).extension() == BINARY_EXTENSION;
+}
+
+static WorldData read_file(const std::string &file_path) {
+    auto file = pack::load_file(file_path);
+    if (!file.is_loaded()) {
+        throw std::runtime_error("Failed to open file: " + file_path);
     }
+
+    if (is_binary(file_path)) return from_binary(file.get_data());
+    return from_json(nlohmann::json::parse(file.get_str()));
+}
+
+static void write_file(const std::string &file_path, const WorldData &data) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file for writing: " + file_path);
+    }
+
+    if (is_binary(file_path)) {
+        auto bytes = to_binary(data);
+        file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    } else {
+        file << to_json(data).dump(4);
+    }
+
+    if (file.fail()) {
+        throw std::runtime_error("Failed to write to file: " + file_path);
+    }
+
+    file.close();
+}
+
+void save(const std::string &file_path) {
+    write_file(file_path, capture());
+}
+
+void load(const std::string &file_path) {
+    apply(read_file(file_path));
+}
+
+void convert(const std::string &src_file_path, const std::string &dst_file_path) {
+    write_file(dst_file_path, read_file(src_file_path));
 }
 
 }  // namespace soft_tissues::world_serializer
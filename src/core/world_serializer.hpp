@@ -1,10 +1,87 @@
 #pragma once
 
+#include "component/light.hpp"
+#include "component/transform.hpp"
+#include "tile.hpp"
+#include "nlohmann/json.hpp"
+#include "raylib/raylib.h"
+#include <array>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace soft_tissues::world_serializer {
 
+// Worlds are saved either as JSON, the interchange format which is edited and
+// diffed by hand, or in the compact binary format, chosen by the file extension
+inline const std::string BINARY_EXTENSION = ".world";
+
+// -----------------------------------------------------------------------
+// world data
+// The serialized world: the tiles and the serializable components keyed by
+// the saved entity ids. It holds only the keys, nothing is resolved, so the
+// formats are converted without the resources and without touching the world.
+
+struct TileData {
+    uint32_t id;
+    int room_id;
+    std::array<tile::TileWall, 4> walls;
+    Color constant_color;
+    std::string floor_key;
+    std::string wall_key;
+    std::string ceil_key;
+};
+
+struct MeshData {
+    std::string mesh_key;
+    std::string material_pbr_key;
+    Color constant_color;
+};
+
+// Component of the entity with the saved id
+template <typename T> struct Record {
+    uint32_t entity;
+    T value;
+};
+
+struct WorldData {
+    std::vector<TileData> tiles;
+
+    // saved ids in the creation order, the components follow the same order
+    std::vector<uint32_t> entities;
+    std::vector<Record<component::Transform>> transforms;
+    std::vector<Record<MeshData>> meshes;
+    // saved id of the parent
+    std::vector<Record<uint32_t>> parents;
+    std::vector<Record<component::Light>> lights;
+    std::vector<uint32_t> players;
+    std::vector<uint32_t> flashlights;
+};
+
+WorldData capture();
+// Replaces the current world. Throws before the world is cleared if a tile is
+// out of the grid, a key is unknown or a component has no entity. A parent
+// missing from the data is skipped with a warning, a world without a player
+// gets the default one
+void apply(const WorldData &data);
+
+nlohmann::json to_json(const WorldData &data);
+WorldData from_json(const nlohmann::json &json);
+
+// Throws if the data is truncated, corrupted or of another version
+std::vector<unsigned char> to_binary(const WorldData &data);
+WorldData from_binary(std::span<const unsigned char> bytes);
+
+// -----------------------------------------------------------------------
+// files
+// The format is chosen by the extension, the file is parsed completely before
+// the current world is replaced, so a failed load doesn't wipe it
 void save(const std::string &file_path);
 void load(const std::string &file_path);
 
+// Converts between the formats (by the extensions) without loading the world.
+// The conversion is lossless: the converted file loads into the same world
+void convert(const std::string &src_file_path, const std::string &dst_file_path);
+
 }  // namespace soft_tissues::world_serializer
@@ -1,14 +1,21 @@
 #include "editor.hpp"
 
 #include "system/camera.hpp"
+#include "system/lighting.hpp"
 #include "system/scene.hpp"
+#include "system/simulation.hpp"
+#include "system/spatial.hpp"
 #include "component/component.hpp"
 #include "globals.hpp"
+#include "core/alloc_probe.hpp"
+#include "core/frame_arena.hpp"
+#include "core/pbr.hpp"
 #include "core/prefabs.hpp"
 #include "core/resources.hpp"
 #include "system/transform.hpp"
 #include "core/world.hpp"
 #include "core/world_serializer.hpp"
+#include "core/vram.hpp"
 #include "GLFW/glfw3.h"
 #include "ImGuiFileDialog.h"
 #include "imgui/imgui.h"
@@ -28,6 +35,11 @@ static const int PICKING_FBO_SIZE = 1024;
 static unsigned int PICKING_FBO;
 static unsigned int PICKING_TEXTURE;
 static unsigned int PICKING_DEPTH;
+static int PICKING_VRAM_ID = vram::INVALID_ID;
+
+static const std::string VRAM_DUMP_FILE_PATH = "vram.json";
+// JSON and the binary world format
+static const char *WORLD_FILE_FILTERS = ".json,.world";
 
 class Tab {
 public:
@@ -100,6 +112,14 @@ void load() {
         TraceLog(LOG_ERROR, "EDITOR: Picking fbo is not complete");
         exit(1);
     }
+
+    PICKING_VRAM_ID = vram::add(
+        vram::Category::EDITOR,
+        "picking_fbo",
+        vram::get_texture_n_bytes(
+            PICKING_FBO_SIZE, PICKING_FBO_SIZE, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1
+        ) + vram::get_depth_n_bytes(PICKING_FBO_SIZE, PICKING_FBO_SIZE)
+    );
 }
 
 void unload() {
@@ -114,6 +134,8 @@ void unload() {
     rlUnloadTexture(PICKING_DEPTH);
     rlUnloadTexture(PICKING_TEXTURE);
     rlUnloadFramebuffer(PICKING_FBO);
+    vram::remove(PICKING_VRAM_ID);
+    PICKING_VRAM_ID = vram::INVALID_ID;
 }
 
 static void update_and_draw_tabs() {
@@ -148,10 +170,78 @@ static void update_and_draw_globals() {
         "shadow_map_max_dist", &globals::RENDER_STATE.shadow_map_max_dist, 10.0, 1000.0
     );
 
+    // -------------------------------------------------------------------
+    // simulation and frame rate
+    ImGui::SeparatorText("Simulation");
+    float simulation_rate = system::simulation::get_rate();
+    if (ImGui::SliderFloat("simulation_rate", &simulation_rate, 10.0, 240.0)) {
+        system::simulation::set_rate(simulation_rate);
+    }
+    ImGui::Text(
+        "CPU: %.3f ms, %d steps, alpha %.2f",
+        system::simulation::get_cpu_ms(),
+        system::simulation::get_n_steps(),
+        system::simulation::get_alpha()
+    );
+
+    // rendering is throttled independently of the simulation, 0 is uncapped
+    static int target_fps = render_config::TARGET_FPS;
+    if (ImGui::SliderInt("target_fps", &target_fps, 0, 240)) SetTargetFPS(target_fps);
+    static bool is_vsync = true;
+    if (ImGui::Checkbox("is_vsync", &is_vsync)) {
+        if (is_vsync) SetWindowState(FLAG_VSYNC_HINT);
+        else ClearWindowState(FLAG_VSYNC_HINT);
+    }
+
+    // -------------------------------------------------------------------
+    // gpu timings
+    ImGui::SeparatorText("GPU");
+    ImGui::Text("Shadow maps: %.3f ms", globals::PASS_TIMINGS.shadow_maps_ms);
+    ImGui::Text("Scene: %.3f ms", globals::PASS_TIMINGS.scene_ms);
+    ImGui::Text(
+        "Lights: %d, %d patched",
+        system::lighting::get_n_lights(),
+        system::lighting::get_n_patched_lights()
+    );
+
+    // -------------------------------------------------------------------
+    // vram
+    ImGui::SeparatorText("VRAM");
+    static constexpr float mb = 1024.0 * 1024.0;
+    for (auto category : vram::CATEGORIES) {
+        ImGui::Text(
+            "%s: %.2f MB (%d)",
+            vram::category_to_str(category).c_str(),
+            vram::get_n_bytes(category) / mb,
+            vram::get_n_allocations(category)
+        );
+    }
+    ImGui::Text("Total: %.2f MB", vram::get_total_n_bytes() / mb);
+    if (gui::button("Dump VRAM")) vram::save_json(VRAM_DUMP_FILE_PATH);
+
+    // -------------------------------------------------------------------
+    // cpu memory
+    ImGui::SeparatorText("Memory");
+    ImGui::Text(
+        "Frame arena: %.2f / %.2f MB",
+        frame_arena::get_n_used_bytes() / mb,
+        frame_arena::get_capacity() / mb
+    );
+    if (alloc_probe::is_enabled()) {
+        ImGui::Text("Heap allocations: %d per frame", alloc_probe::get_n_frame_allocations());
+    } else {
+        ImGui::TextDisabled("Heap allocations: build with ALLOC_PROBE");
+    }
+
     // -------------------------------------------------------------------
     // world
     ImGui::SeparatorText("World");
     ImGui::Text("Rooms count: %d", world::get_rooms_count());
+    ImGui::Text(
+        "Indexed entities: %d, %d updated",
+        system::spatial::get_n_entities(),
+        system::spatial::get_n_updated_entities()
+    );
 
     // -------------------------------------------------------------------
     // save
@@ -162,7 +252,7 @@ static void update_and_draw_globals() {
         config.flags = ImGuiFileDialogFlags_ConfirmOverwrite | ImGuiFileDialogFlags_Modal;
 
         ImGuiFileDialog::Instance()->OpenDialog(
-            "SAVE_WORLD", "Choose File", ".json", config
+            "SAVE_WORLD", "Choose File", WORLD_FILE_FILTERS, config
         );
     }
 
@@ -186,7 +276,7 @@ static void update_and_draw_globals() {
         config.flags = ImGuiFileDialogFlags_Modal;
 
         ImGuiFileDialog::Instance()->OpenDialog(
-            "OPEN_WORLD", "Choose File", ".json", config
+            "OPEN_WORLD", "Choose File", WORLD_FILE_FILTERS, config
         );
     }
 
@@ -241,8 +331,7 @@ void update_and_draw() {
 void update_hovered_entity() {
     // -------------------------------------------------------------------
     // Draw entities into the PICKING_FBO
-    static std::vector<entt::entity> entities;
-    entities.clear();
+    frame_arena::Vector<entt::entity> entities;
     HOVERED_ENTITY = entt::null;
 
     unsigned char id = 1;
@@ -257,14 +346,17 @@ void update_hovered_entity() {
     rlDisableColorBlend();
     BeginMode3D(system::camera::CAMERA);
     {
-        // meshes
-        auto meshes = globals::registry.view<component::MyMesh>();
-        for (auto entity : meshes) {
+        // meshes, only those the cursor ray hits may be under the cursor
+        frame_arena::Vector<entt::entity> hit_entities;
+        Ray ray = GetScreenToWorldRay(GetMousePosition(), system::camera::CAMERA);
+        system::spatial::query_ray(ray, rlGetCullDistanceFar(), hit_entities);
+        for (auto entity : hit_entities) {
             if (id == 255) break;
+            if (!globals::registry.all_of<component::MyMesh>(entity)) continue;
 
             const auto &my_mesh = globals::registry.get<component::MyMesh>(entity);
 
-            const auto &mesh = resources::get_mesh(my_mesh.mesh_key);
+            const auto &mesh = resources::get_mesh(my_mesh.mesh);
             auto material = resources::get_material_color({id, 0, 0, 255});
             auto matrix = system::transform::get_world_matrix(entity);
 
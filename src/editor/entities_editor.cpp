@@ -26,7 +26,9 @@ static void update_and_draw_transformation() {
         float *v = reinterpret_cast<float *>(&tr.position);
 
         gui::push_id();
-        ImGui::DragFloat3("Position", v, SPEED);
+        if (ImGui::DragFloat3("Position", v, SPEED)) {
+            system::transform::mark_dirty(ENTITY);
+        }
         gui::pop_id();
     }
 
@@ -34,10 +36,15 @@ static void update_and_draw_transformation() {
         static const float SPEED = PI / 16.0;
         static const float MIN = -2.0 * PI;
         static const float MAX = 2.0 * PI;
-        float *v = reinterpret_cast<float *>(&tr.rotation);
+        // edited as the euler angles, converted back only on change
+        Vector3 euler = QuaternionToEuler(tr.rotation);
+        float *v = reinterpret_cast<float *>(&euler);
 
         gui::push_id();
-        ImGui::DragFloat3("Rotation", v, SPEED, MIN, MAX);
+        if (ImGui::DragFloat3("Rotation", v, SPEED, MIN, MAX)) {
+            tr.rotation = QuaternionFromEuler(euler.x, euler.y, euler.z);
+            system::transform::mark_dirty(ENTITY);
+        }
         gui::pop_id();
     }
 }
@@ -54,7 +61,7 @@ static void update_and_draw_mesh() {
             globals::registry.emplace<component::MyMesh>(ENTITY, my_mesh);
         }
     } else {
-        gui::material_picker(&mesh->material_pbr_key);
+        if (gui::material_picker(&mesh->material_pbr_key)) mesh->resolve();
     }
 
     gui::pop_id();
@@ -73,22 +80,26 @@ static void update_and_draw_light() {
             globals::registry.emplace<component::Light>(ENTITY, light);
         }
     } else {
+        // the light is written in place, it's patched at the end if changed
+        bool is_changed = false;
+
         // ---------------------------------------------------------------
         // common light params
 
-        ImGui::Checkbox("is on", &light->is_on);
-        ImGui::Checkbox("casts shadows", &light->casts_shadows);
+        is_changed |= ImGui::Checkbox("is on", &light->is_on);
+        is_changed |= ImGui::Checkbox("casts shadows", &light->casts_shadows);
 
         // color
         auto color = ColorNormalize(light->color);
         float *color_p = reinterpret_cast<float *>(&color);
         if (ImGui::ColorEdit3("Color", color_p)) {
             light->color = ColorFromNormalized(color);
+            is_changed = true;
         }
 
         // intensity
         float *v = &light->intensity;
-        ImGui::SliderFloat("Intensity", v, 0.0, 100.0);
+        is_changed |= ImGui::SliderFloat("Intensity", v, 0.0, 100.0);
 
         // ---------------------------------------------------------------
         // shadow type selection
@@ -116,6 +127,7 @@ static void update_and_draw_light() {
                 auto type_name = component::light_type_to_str(type);
                 if (ImGui::Selectable(type_name.c_str(), type == light->light_type)) {
                     light->light_type = type;
+                    is_changed = true;
 
                     // after selecting the light type, initialize it with some
                     // meaningful default light settings
@@ -168,15 +180,17 @@ static void update_and_draw_light() {
         // specific light type params
         switch (light->light_type) {
             case component::LightType::POINT: {
-                gui::point_light_params(light);
+                is_changed |= gui::point_light_params(light);
             } break;
 
             case component::LightType::SPOT: {
-                gui::spot_light_params(light);
+                is_changed |= gui::spot_light_params(light);
             } break;
 
             default: break;
         }
+
+        if (is_changed) globals::registry.patch<component::Light>(ENTITY);
     }
 
     gui::pop_id();
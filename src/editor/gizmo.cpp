@@ -2,6 +2,7 @@
 #include "component/component.hpp"
 #include "globals.hpp"
 #include "system/transform.hpp"
+#include "core/vram.hpp"
 #include "editor.hpp"
 #include "entt/entity/entity.hpp"
 #include "entt/entity/fwd.hpp"
@@ -113,6 +114,8 @@ static int SHADER_GIZMO_POSITION_LOC;
 
 static unsigned int PICKING_FBO;
 static unsigned int PICKING_TEXTURE;
+static unsigned int PICKING_DEPTH;
+static int PICKING_VRAM_ID = vram::INVALID_ID;
 
 static Update UPDATE;
 static bool IS_LOADED = false;
@@ -243,6 +246,9 @@ void unload(void) {
     UnloadShader(SHADER);
     rlUnloadFramebuffer(PICKING_FBO);
     rlUnloadTexture(PICKING_TEXTURE);
+    rlUnloadTexture(PICKING_DEPTH);
+    vram::remove(PICKING_VRAM_ID);
+    PICKING_VRAM_ID = vram::INVALID_ID;
 
     IS_LOADED = false;
     TraceLog(LOG_INFO, "RAYGIZMO: Gizmo unloaded");
@@ -280,7 +286,7 @@ void load() {
     PICKING_TEXTURE = rlLoadTexture(
         NULL, PICKING_FBO_SIZE, PICKING_FBO_SIZE, RL_PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1
     );
-    unsigned int picking_depth = rlLoadTextureDepth(PICKING_FBO_SIZE, PICKING_FBO_SIZE, false);
+    PICKING_DEPTH = rlLoadTextureDepth(PICKING_FBO_SIZE, PICKING_FBO_SIZE, false);
     rlActiveDrawBuffers(1);
     rlFramebufferAttach(
         PICKING_FBO,
@@ -291,7 +297,7 @@ void load() {
     );
     rlFramebufferAttach(
         PICKING_FBO,
-        picking_depth,
+        PICKING_DEPTH,
         RL_ATTACHMENT_DEPTH,
         RL_ATTACHMENT_TEXTURE2D,
         0
@@ -301,13 +307,19 @@ void load() {
         exit(1);
     }
 
+    PICKING_VRAM_ID = vram::add(
+        vram::Category::EDITOR,
+        "gizmo_picking_fbo",
+        vram::get_texture_n_bytes(
+            PICKING_FBO_SIZE, PICKING_FBO_SIZE, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, 1
+        ) + vram::get_depth_n_bytes(PICKING_FBO_SIZE, PICKING_FBO_SIZE)
+    );
+
     TraceLog(LOG_INFO, "RAYGIZMO: Gizmo loaded");
     IS_LOADED = true;
 }
 
 static void update() {
-    auto &tr = globals::registry.get<component::Transform>(ENTITY);
-
     // -------------------------------------------------------------------
     // Draw gizmo into the picking fbo for the mouse pixel-picking
     rlEnableFramebuffer(PICKING_FBO);
@@ -459,7 +471,7 @@ static void update() {
     // -------------------------------------------------------------------
     // update entity
     if (Vector3Length(UPDATE.translation) > EPSILON) {
-        tr.position = Vector3Add(tr.position, UPDATE.translation);
+        system::transform::step(ENTITY, UPDATE.translation);
     }
 
     if (std::abs(UPDATE.angle) > EPSILON) {
@@ -61,6 +61,12 @@ void image(unsigned int texture, float width, float height) {
 }
 
 void image(Texture texture, float width, float height) {
+    // not loaded yet (e.g. non-resident material preview), keep the layout stable
+    if (texture.id == 0) {
+        ImGui::Dummy({width, height > 0.0f ? height : width});
+        return;
+    }
+
     if (height <= 0.0) {
         float aspect = static_cast<float>(texture.width) / texture.height;
         height = width / aspect;
@@ -68,7 +74,8 @@ void image(Texture texture, float width, float height) {
     return image(texture.id, width, height);
 }
 
-void material_picker(std::string *material_pbr_key) {
+bool material_picker(std::string *material_pbr_key) {
+    bool is_changed = false;
     if (ImGui::BeginMenu(material_pbr_key->c_str())) {
         ImGui::Separator();
 
@@ -78,6 +85,7 @@ void material_picker(std::string *material_pbr_key) {
 
             if (ImGui::MenuItem(another_material_pbr_key.c_str(), NULL, is_selected)) {
                 *material_pbr_key = another_material_pbr_key;
+                is_changed = true;
             }
 
             const auto &another_material_pbr = resources::get_material_pbr(
@@ -91,29 +99,36 @@ void material_picker(std::string *material_pbr_key) {
 
     const auto &material_pbr = resources::get_material_pbr(*material_pbr_key);
     gui::image(material_pbr.get_texture(), 150.0);
+
+    return is_changed;
 }
 
 void tile_material_picker(
     std::string *target_material_pbr_key, tile::TileMaterials *tile_materials
 ) {
-    material_picker(target_material_pbr_key);
+    if (material_picker(target_material_pbr_key)) tile_materials->resolve();
     if (gui::button("[A]pply to all") || IsKeyPressed(KEY_A)) {
         *tile_materials = tile::TileMaterials(*target_material_pbr_key);
     }
 }
 
-void spot_light_params(component::Light *light) {
+bool spot_light_params(component::Light *light) {
     auto &p = std::get<component::SpotParams>(light->params);
     float *attenuation = reinterpret_cast<float *>(&p.attenuation);
-    ImGui::SliderFloat2("Attenuation", &attenuation[1], 0.0, 5.0);
-    ImGui::SliderFloat("Inner cutoff", &p.inner_cutoff, 0.0, 1.0);
-    ImGui::SliderFloat("Outer cutoff", &p.outer_cutoff, 0.0, 1.0);
+
+    bool is_changed = false;
+    is_changed |= ImGui::SliderFloat2("Attenuation", &attenuation[1], 0.0, 5.0);
+    is_changed |= ImGui::SliderFloat("Inner cutoff", &p.inner_cutoff, 0.0, 1.0);
+    is_changed |= ImGui::SliderFloat("Outer cutoff", &p.outer_cutoff, 0.0, 1.0);
+
+    return is_changed;
 }
 
-void point_light_params(component::Light *light) {
+bool point_light_params(component::Light *light) {
     auto &p = std::get<component::PointParams>(light->params);
     float *attenuation = reinterpret_cast<float *>(&p.attenuation);
-    ImGui::SliderFloat2("Attenuation", &attenuation[1], 0.0, 5.0);
+
+    return ImGui::SliderFloat2("Attenuation", &attenuation[1], 0.0, 5.0);
 }
 
 }  // namespace soft_tissues::editor::gui
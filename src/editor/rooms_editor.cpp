@@ -110,7 +110,9 @@ void update_and_draw() {
         } else if (start_tile != nullptr && IsMouseButtonDown(MOUSE_LEFT_BUTTON)) {
             if (tile_at_cursor != nullptr) end_tile = tile_at_cursor;
 
-            GHOST_TILES = world::get_tiles_between_corners(start_tile, end_tile);
+            // the ghost tiles outlive the frame, so they are copied out of the arena
+            auto tiles = world::get_tiles_between_corners(start_tile, end_tile);
+            GHOST_TILES.assign(tiles.begin(), tiles.end());
         } else if (start_tile != nullptr && IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
             for (auto tile : GHOST_TILES) {
                 int room_id = world::get_tile_room_id(tile);
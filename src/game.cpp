@@ -5,28 +5,53 @@
 #include "system/controller.hpp"
 #include "editor/editor.hpp"
 #include "globals.hpp"
+#include "core/alloc_probe.hpp"
+#include "core/frame_arena.hpp"
+#include "core/gl.hpp"
+#include "core/gpu_timer.hpp"
+#include "core/jobs.hpp"
+#include "core/pack.hpp"
+#include "core/pbr.hpp"
 #include "core/prefabs.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
 #include "raylib/rlgl.h"
 #include "core/resources.hpp"
+#include "system/frame.hpp"
 #include "system/lighting.hpp"
-#include "system/render.hpp"
 #include "system/scene.hpp"
+#include "system/simulation.hpp"
+#include "system/spatial.hpp"
+#include "system/transform.hpp"
 #include "core/world.hpp"
+#include <cstdlib>
 
 namespace soft_tissues::game {
 
+// grows on its own if a frame doesn't fit
+static constexpr size_t FRAME_ARENA_N_BYTES = 4 * 1024 * 1024;
+
+static gpu_timer::GPUTimer SHADOW_MAPS_TIMER;
+static gpu_timer::GPUTimer SCENE_TIMER;
+
 static void load_window() {
     SetConfigFlags(FLAG_MSAA_4X_HINT | FLAG_VSYNC_HINT);
 
     InitWindow(1920, 1080, "Soft Tissues");
+    gl::load();
 
     DisableCursor();
-    SetTargetFPS(60);
+    SetTargetFPS(render_config::TARGET_FPS);
     SetExitKey(KEY_NULL);
 }
 
+// SOFT_TISSUES_SINGLE_THREADED=1 runs all jobs inline in the submission
+// order, which makes the frame deterministic for debugging
+static void load_jobs() {
+    bool is_single_threaded = std::getenv("SOFT_TISSUES_SINGLE_THREADED") != nullptr;
+    jobs::load(is_single_threaded ? 0 : jobs::get_default_n_workers());
+}
+
 static void update_game_state() {
     if (IsKeyPressed(KEY_F1)) {
         if (globals::GAME_STATE == globals::GameState::PLAY) {
@@ -48,7 +73,9 @@ static bool update() {
         system::controller::update();
     }
 
+    system::simulation::update(globals::FRAME_DT);
     system::camera::update();
+    system::transform::update();
 
     return should_close;
 }
@@ -64,29 +91,31 @@ static void draw_cursor() {
 
 static void draw() {
     const auto &render_state = globals::RENDER_STATE;
-    auto &pbr_shader = resources::get_pbr_shader();
+
+    // -------------------------------------------------------------------
+    // draw lists of all passes, built on the worker threads
+    const auto &frame = system::frame::prepare(system::camera::CAMERA, render_state);
 
     // -------------------------------------------------------------------
     // shadow maps
-    auto jobs = system::lighting::prepare_shadow_passes();
-    for (auto &job : jobs) {
-        BeginTextureMode(*job.shadow_map);
+    SHADOW_MAPS_TIMER.begin();
+    for (const auto &pass : frame.shadow_passes) {
+        BeginTextureMode(*pass.shadow_map);
         ClearBackground(YELLOW);
-        BeginMode3D(job.camera);
+        BeginMode3D(pass.list.camera);
 
         Matrix vp_mat = MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection());
-
-        RenderState shadow_state = render_state;
-        shadow_state.is_shadow_map_pass = true;
-        system::render::begin_frame(pbr_shader, shadow_state);
-        system::scene::draw_tiles(shadow_state);
-        system::scene::draw_meshes(shadow_state);
+        system::frame::draw_list(pass.list);
 
         EndMode3D();
         EndTextureMode();
 
-        system::lighting::finalize_shadow_pass(job.entity, vp_mat);
+        system::lighting::finalize_shadow_pass(pass.entity, vp_mat);
     }
+    SHADOW_MAPS_TIMER.end();
+
+    // only the lights changed since the last frame are uploaded
+    system::lighting::update();
 
     // -------------------------------------------------------------------
     // entity picking
@@ -108,15 +137,15 @@ static void draw() {
             system::scene::draw_grid();
         }
 
-        if (render_state.is_light_enabled) {
-            system::lighting::set_light_uniforms(pbr_shader);
-        }
-        system::render::begin_frame(pbr_shader, render_state);
-        system::scene::draw_tiles(render_state);
-        system::scene::draw_meshes(render_state);
+        SCENE_TIMER.begin();
+        system::frame::draw_list(frame.main);
+        SCENE_TIMER.end();
     }
     EndMode3D();
 
+    globals::PASS_TIMINGS.shadow_maps_ms = SHADOW_MAPS_TIMER.get_ms();
+    globals::PASS_TIMINGS.scene_ms = SCENE_TIMER.get_ms();
+
     if (globals::GAME_STATE == globals::GameState::PLAY) {
         draw_cursor();
     }
@@ -140,11 +169,18 @@ static void on_shadow_data_destroyed(entt::registry &reg, entt::entity entity) {
 void run() {
     // load engine
     load_window();
+    load_jobs();
+    frame_arena::load(FRAME_ARENA_N_BYTES);
+    pack::mount(std::string(GetApplicationDirectory()) + "assets.pack");
     resources::load();
     editor::load();
 
     // register cleanup hooks
     globals::registry.on_destroy<component::ShadowData>().connect<&on_shadow_data_destroyed>();
+    system::transform::load();
+    system::spatial::load();
+    system::simulation::load();
+    system::lighting::load();
 
     // load initial scene
     globals::registry.clear();
@@ -155,13 +191,24 @@ void run() {
     // main loop
     while (true) {
         if (update()) break;
+        resources::update();
         draw();
+
+        // no job is running here, the frame's transient data is released
+        frame_arena::reset();
+        alloc_probe::end_frame();
     }
 
     // unload
     globals::registry.clear();
+    SHADOW_MAPS_TIMER.unload();
+    SCENE_TIMER.unload();
     editor::unload();
+    system::lighting::unload();
     resources::unload();
+    pack::unmount();
+    jobs::unload();
+    frame_arena::unload();
     CloseWindow();
 }
 
@@ -7,4 +7,10 @@ inline constexpr float PLAYER_SPEED = 3.0;
 inline constexpr float PLAYER_CAMERA_SENSITIVITY = 0.0015;
 inline constexpr float PLAYER_FOV = 70.0;
 
+// Fixed steps per second, independent of the render frame rate
+inline constexpr float SIMULATION_RATE = 60.0;
+// More steps than this per frame are dropped, the simulation slows down
+// instead of falling further behind
+inline constexpr int MAX_N_SIMULATION_STEPS = 8;
+
 }  // namespace soft_tissues::gameplay_config
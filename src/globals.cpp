@@ -8,6 +8,7 @@ entt::registry registry;
 RenderState RENDER_STATE;
 
 float FRAME_DT = 0.0;
+PassTimings PASS_TIMINGS;
 GameState GAME_STATE = GameState::PLAY;
 
 bool update() {
@@ -13,7 +13,15 @@ enum class GameState {
 extern entt::registry registry;
 extern RenderState RENDER_STATE;
 
+// GPU time of the render passes in milliseconds, measured in game::draw
+struct PassTimings {
+    float shadow_maps_ms = 0.0;
+    float scene_ms = 0.0;
+};
+
+// Render frame time, the simulation consumes it in fixed steps
 extern float FRAME_DT;
+extern PassTimings PASS_TIMINGS;
 extern GameState GAME_STATE;
 
 // Returns true if the window should close.
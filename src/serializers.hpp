@@ -6,6 +6,17 @@
 
 namespace nlohmann {
 
+template <> struct adl_serializer<Vector2> {
+    static void to_json(json &j, const Vector2 &v) {
+        j = {v.x, v.y};
+    }
+
+    static void from_json(const json &j, Vector2 &v) {
+        v.x = j[0].get<float>();
+        v.y = j[1].get<float>();
+    }
+};
+
 template <> struct adl_serializer<Vector3> {
     static void to_json(json &j, const Vector3 &v) {
         j = {v.x, v.y, v.z};
@@ -18,6 +29,19 @@ template <> struct adl_serializer<Vector3> {
     }
 };
 
+template <> struct adl_serializer<Vector4> {
+    static void to_json(json &j, const Vector4 &v) {
+        j = {v.x, v.y, v.z, v.w};
+    }
+
+    static void from_json(const json &j, Vector4 &v) {
+        v.x = j[0].get<float>();
+        v.y = j[1].get<float>();
+        v.z = j[2].get<float>();
+        v.w = j[3].get<float>();
+    }
+};
+
 template <> struct adl_serializer<Color> {
     static void to_json(json &j, const Color &c) {
         j = {c.r, c.g, c.b, c.a};
@@ -6,10 +6,11 @@
 #include "system/transform.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
+#include <cmath>
 
 namespace soft_tissues::system::controller {
 
-static void update_translation() {
+void step(float dt) {
     // -------------------------------------------------------------------
     // moving
     Vector3 dir = Vector3Zero();
@@ -36,9 +37,10 @@ static void update_translation() {
     right = Vector3Scale(Vector3Normalize(right), dir.x);
     dir = Vector3Normalize(Vector3Add(forward, right));
 
-    Vector3 delta = Vector3Scale(dir, globals::FRAME_DT * gameplay_config::PLAYER_SPEED);
+    Vector3 delta = Vector3Scale(dir, dt * gameplay_config::PLAYER_SPEED);
 
-    transform::step(player, delta);
+    auto &sp = globals::registry.get<component::SimulatedPosition>(player);
+    sp.position = Vector3Add(sp.position, delta);
 }
 
 static void update_rotation() {
@@ -58,26 +60,34 @@ static void update_rotation() {
     auto player = view.front();
     auto &tr = globals::registry.get<component::Transform>(player);
 
-    float pitch = tr.rotation.x + pitch_delta;
-    pitch = Clamp(pitch, -0.5 * PI + 0.025, 0.5 * PI - 0.025);
-    float yaw = tr.rotation.y + yaw_delta;
-
-    tr.rotation.x = pitch;
-    tr.rotation.y = yaw;
+    // the rotation is yaw around the world up followed by the local pitch, so
+    // the pitch is the elevation of the forward vector
+    Vector3 forward = Vector3RotateByQuaternion({0.0, 0.0, -1.0}, tr.rotation);
+    float pitch = std::asin(Clamp(forward.y, -1.0, 1.0));
+    float new_pitch = Clamp(pitch + pitch_delta, -0.5 * PI + 0.025, 0.5 * PI - 0.025);
+
+    Quaternion yaw_q = QuaternionFromAxisAngle({0.0, 1.0, 0.0}, yaw_delta);
+    Quaternion pitch_q = QuaternionFromAxisAngle({1.0, 0.0, 0.0}, new_pitch - pitch);
+    tr.rotation = QuaternionNormalize(
+        QuaternionMultiply(yaw_q, QuaternionMultiply(tr.rotation, pitch_q))
+    );
+    transform::mark_dirty(player);
 }
 
 static void update_flashlight() {
     auto view = globals::registry.view<component::Flashlight>();
     if (view.empty()) return;
     auto flashlight = view.front();
-    auto &light = globals::registry.get<component::Light>(flashlight);
 
-    // toggle
-    light.is_on ^= IsKeyPressed(KEY_L);
+    // toggle, patched so the light buffer picks the change up
+    if (IsKeyPressed(KEY_L)) {
+        globals::registry.patch<component::Light>(flashlight, [](auto &light) {
+            light.is_on = !light.is_on;
+        });
+    }
 }
 
 void update() {
-    update_translation();
     update_rotation();
     update_flashlight();
 }
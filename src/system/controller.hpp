@@ -2,6 +2,9 @@
 
 namespace soft_tissues::system::controller {
 
+// Per frame input: looking around and toggles
 void update();
+// Fixed step of the player movement, moves its simulated position
+void step(float dt);
 
 }  // namespace soft_tissues::system::controller
@@ -0,0 +1,356 @@
+#include "frame.hpp"
+
+#include "component/component.hpp"
+#include "globals.hpp"
+#include "core/frame_arena.hpp"
+#include "core/jobs.hpp"
+#include "core/world.hpp"
+#include "system/lighting.hpp"
+#include "system/render.hpp"
+#include "system/spatial.hpp"
+#include "system/transform.hpp"
+#include "raylib/raymath.h"
+#include "raylib/rlgl.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace soft_tissues::system::frame {
+
+static constexpr int TILES_GRAIN_SIZE = 64;
+static constexpr int MESHES_GRAIN_SIZE = 256;
+
+// tile half diagonal, walls are requested from the tile center as well
+static const float TILE_RADIUS = 0.5 * std::sqrt(2.0);
+static const float WALL_RADIUS = 0.5 * Vector2Length({1.0, (float)world::HEIGHT});
+static constexpr float MESH_MIP_RADIUS = 0.5;
+
+static Frame FRAME;
+// collected on the main thread, so the workers don't iterate the registry.
+// The main pass goes over all of them, it marks the material uses before the
+// culling; the shadow passes take theirs from the spatial index
+static std::vector<entt::entity> MESH_ENTITIES;
+
+// -----------------------------------------------------------------------
+// pass view
+
+using spatial::Frustum;
+
+struct PassView {
+    Frustum frustum;
+    Vector3 camera_pos;
+    // world size of a pixel at the unit distance from the camera
+    float pixel_size;
+    bool is_shadow_map_pass;
+};
+
+// The same view projection BeginMode3D sets up
+static Matrix get_view_projection(Camera3D camera, float aspect) {
+    double near = rlGetCullDistanceNear();
+    double far = rlGetCullDistanceFar();
+
+    Matrix projection;
+    if (camera.projection == CAMERA_PERSPECTIVE) {
+        projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, near, far);
+    } else {
+        double top = 0.5 * camera.fovy;
+        double right = top * aspect;
+        projection = MatrixOrtho(-right, right, -top, top, near, far);
+    }
+
+    return MatrixMultiply(GetCameraMatrix(camera), projection);
+}
+
+static PassView get_pass_view(const DrawList &list) {
+    PassView view;
+    view.frustum = spatial::get_frustum(get_view_projection(list.camera, list.aspect));
+    view.camera_pos = list.camera.position;
+    view.pixel_size = 2.0 * std::tan(0.5 * list.camera.fovy * DEG2RAD) / GetRenderHeight();
+    view.is_shadow_map_pass = list.render_state.is_shadow_map_pass;
+
+    return view;
+}
+
+// Bounding sphere of the mesh bounds placed by the rigid transform
+static std::pair<Vector3, float> get_bounding_sphere(BoundingBox bounds, Matrix matrix) {
+    Vector3 center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5);
+    float radius = 0.5 * Vector3Distance(bounds.min, bounds.max);
+
+    return {Vector3Transform(center, matrix), radius};
+}
+
+// Texel density assumes a unit of the texture coordinates per world unit
+static int get_mip_level(
+    const pbr::MaterialPBR &material_pbr, Vector3 position, float radius, const PassView &view
+) {
+    Vector2 tiling = material_pbr.get_tiling();
+    float texel_size = 1.0 / (std::max(tiling.x, tiling.y) * render_config::MATERIAL_MAP_SIZE);
+
+    float dist = std::max(Vector3Distance(view.camera_pos, position) - radius, 0.01f);
+    float pixel_size = dist * view.pixel_size;
+
+    // each level doubles the texel size, the finest one with a texel per pixel
+    return std::max(0, (int)std::floor(std::log2(pixel_size / texel_size)));
+}
+
+// Shader variant first (the program switches are the most expensive), then
+// the material layer, then the depth front to back for the early depth test
+static uint64_t get_sort_key(const pbr::MaterialPBR &material_pbr, float depth) {
+    uint64_t has_displacement = material_pbr.get_displacement_scale() != 0.0;
+    uint64_t layer = static_cast<uint16_t>(material_pbr.get_layer());
+
+    // the bits of a non-negative float are ordered as its value
+    uint32_t depth_bits;
+    std::memcpy(&depth_bits, &depth, sizeof(depth_bits));
+
+    return (has_displacement << 48) | (layer << 32) | depth_bits;
+}
+
+// -----------------------------------------------------------------------
+// draw list building
+// The chunks are built in parallel into their own lists, which are merged in
+// the chunk order, so the result doesn't depend on the scheduling.
+
+// Draw data of a chunk, lives in the frame arena until the merge
+struct Chunk {
+    std::array<frame_arena::Vector<Matrix>, 2> tile_instances;
+    frame_arena::Vector<DrawItem> items;
+    frame_arena::Vector<MaterialUse> material_uses;
+};
+
+static void add_material_use(
+    Chunk &chunk, resources::MaterialHandle material, Vector3 position, float radius,
+    const PassView &view
+) {
+    // shadow maps don't sample the material maps (except the coarse height)
+    if (view.is_shadow_map_pass) return;
+
+    const auto &material_pbr = resources::peek_material_pbr(material);
+    chunk.material_uses.push_back({material, get_mip_level(material_pbr, position, radius, view)});
+}
+
+static void add_item(
+    Chunk &chunk, const Mesh &mesh, const pbr::MaterialPBR &material_pbr,
+    Color constant_color, Matrix matrix, Vector3 center, const PassView &view
+) {
+    float depth = Vector3Distance(view.camera_pos, center);
+    chunk.items.push_back(
+        {get_sort_key(material_pbr, depth), &mesh, &material_pbr, constant_color, matrix}
+    );
+}
+
+static void build_tiles(Chunk &chunk, const Mesh &plane, int begin, int end, const PassView &view) {
+    auto tiles = world::get_tiles();
+
+    for (int i = begin; i < end; ++i) {
+        tile::Tile &tile = tiles[i];
+
+        // don't draw tile which doesn't belong to any room
+        if (world::get_tile_room_id(&tile) == -1) continue;
+
+        // the materials are used before the culling, so turning the camera
+        // doesn't stream them out
+        Vector2 pos = tile.get_floor_position();
+        Vector3 floor_pos = {pos.x, 0.0, pos.y};
+        Vector3 ceil_pos = {pos.x, (float)world::HEIGHT, pos.y};
+        Vector3 wall_pos = {pos.x, 0.5f * world::HEIGHT, pos.y};
+        add_material_use(chunk, tile.materials.floor, floor_pos, TILE_RADIUS, view);
+        add_material_use(chunk, tile.materials.ceil, ceil_pos, TILE_RADIUS, view);
+        if (!tile.materials.wall_key.empty()) {
+            add_material_use(chunk, tile.materials.wall, wall_pos, WALL_RADIUS, view);
+        }
+
+        std::array<std::tuple<resources::MaterialHandle, Matrix, Vector3>, 2> surfaces = {{
+            {tile.materials.floor, tile.get_floor_matrix(), floor_pos},
+            {tile.materials.ceil, tile.get_ceil_matrix(), ceil_pos},
+        }};
+        for (const auto &[material, matrix, center] : surfaces) {
+            if (!spatial::is_sphere_visible(view.frustum, center, TILE_RADIUS)) continue;
+
+            // tiles without the constant color override go to the instanced batches
+            const auto &material_pbr = resources::peek_material_pbr(material);
+            if (tile.constant_color.a == 0) {
+                chunk.tile_instances[material_pbr.get_displacement_scale() != 0.0].push_back(
+                    render::get_instance_transform(matrix, material_pbr)
+                );
+            } else {
+                add_item(chunk, plane, material_pbr, tile.constant_color, matrix, center, view);
+            }
+        }
+    }
+}
+
+// One mesh per wall material
+static void build_walls(Chunk &chunk, const PassView &view) {
+    Matrix identity = MatrixIdentity();
+    Color no_color = {0, 0, 0, 0};
+
+    for (const auto &wall_mesh : resources::get_wall_meshes()) {
+        auto bounds = resources::get_mesh_bounds(wall_mesh.mesh);
+        auto [center, radius] = get_bounding_sphere(bounds, identity);
+        if (!spatial::is_sphere_visible(view.frustum, center, radius)) continue;
+
+        const auto &mesh = resources::get_mesh(wall_mesh.mesh);
+        const auto &material_pbr = resources::peek_material_pbr(wall_mesh.material);
+        add_item(chunk, mesh, material_pbr, no_color, identity, center, view);
+    }
+}
+
+static void build_meshes(
+    Chunk &chunk, std::span<const entt::entity> entities, int begin, int end, const PassView &view
+) {
+    const auto &reg = std::as_const(globals::registry);
+
+    for (int i = begin; i < end; ++i) {
+        entt::entity entity = entities[i];
+        const auto &my_mesh = reg.get<component::MyMesh>(entity);
+        Matrix matrix = transform::get_world_matrix(entity);
+
+        Vector3 position = {matrix.m12, matrix.m13, matrix.m14};
+        add_material_use(chunk, my_mesh.material_pbr, position, MESH_MIP_RADIUS, view);
+
+        auto bounds = resources::get_mesh_bounds(my_mesh.mesh);
+        auto [center, radius] = get_bounding_sphere(bounds, matrix);
+        if (!spatial::is_sphere_visible(view.frustum, center, radius)) continue;
+
+        const auto &mesh = resources::get_mesh(my_mesh.mesh);
+        const auto &material_pbr = resources::peek_material_pbr(my_mesh.material_pbr);
+        add_item(chunk, mesh, material_pbr, my_mesh.constant_color, matrix, center, view);
+    }
+}
+
+template <typename T> static void append(std::vector<T> &dst, const frame_arena::Vector<T> &src) {
+    dst.insert(dst.end(), src.begin(), src.end());
+}
+
+// Mesh entities of the shadow pass, which may be inside its frustum
+static frame_arena::Vector<entt::entity> query_shadow_mesh_entities(const PassView &view) {
+    const auto &reg = std::as_const(globals::registry);
+
+    frame_arena::Vector<entt::entity> entities;
+    spatial::query_frustum(view.frustum, entities);
+    std::erase_if(entities, [&](entt::entity entity) {
+        return !reg.all_of<component::MyMesh>(entity);
+    });
+
+    return entities;
+}
+
+static void build_list(DrawList &list, const Mesh &plane) {
+    PassView view = get_pass_view(list);
+
+    frame_arena::Vector<entt::entity> shadow_mesh_entities;
+    if (view.is_shadow_map_pass) shadow_mesh_entities = query_shadow_mesh_entities(view);
+    std::span<const entt::entity> mesh_entities = view.is_shadow_map_pass
+                                                      ? std::span(shadow_mesh_entities)
+                                                      : std::span(MESH_ENTITIES);
+
+    int n_tiles = world::get_tiles_count();
+    int n_meshes = mesh_entities.size();
+    int n_tile_chunks = (n_tiles + TILES_GRAIN_SIZE - 1) / TILES_GRAIN_SIZE;
+    int n_mesh_chunks = (n_meshes + MESHES_GRAIN_SIZE - 1) / MESHES_GRAIN_SIZE;
+
+    // the walls are the first chunk
+    frame_arena::Vector<Chunk> chunks(1 + n_tile_chunks + n_mesh_chunks);
+    build_walls(chunks[0], view);
+    jobs::parallel_for(0, n_tiles, TILES_GRAIN_SIZE, [&](int begin, int end) {
+        build_tiles(chunks[1 + begin / TILES_GRAIN_SIZE], plane, begin, end, view);
+    });
+    jobs::parallel_for(0, n_meshes, MESHES_GRAIN_SIZE, [&](int begin, int end) {
+        auto &chunk = chunks[1 + n_tile_chunks + begin / MESHES_GRAIN_SIZE];
+        build_meshes(chunk, mesh_entities, begin, end, view);
+    });
+
+    for (auto &transforms : list.tile_instances) {
+        transforms.clear();
+    }
+    list.items.clear();
+    list.material_uses.clear();
+
+    for (const auto &chunk : chunks) {
+        for (int i = 0; i < 2; ++i) {
+            append(list.tile_instances[i], chunk.tile_instances[i]);
+        }
+        append(list.items, chunk.items);
+        append(list.material_uses, chunk.material_uses);
+    }
+
+    // not stable_sort, which allocates a temporary buffer: the merged order is
+    // deterministic, so the order of the items with equal keys is as well
+    std::sort(list.items.begin(), list.items.end(), [](const auto &a, const auto &b) {
+        return a.sort_key < b.sort_key;
+    });
+}
+
+// -----------------------------------------------------------------------
+// frame
+
+const Frame &prepare(Camera3D camera, const RenderState &render_state) {
+    // the world matrices and the spatial index are read-only from here on
+    transform::update();
+    spatial::update();
+
+    // shadow maps are assigned here, it touches the registry and the resources
+    auto shadow_jobs = lighting::prepare_shadow_passes();
+
+    auto view = globals::registry.view<component::MyMesh>();
+    MESH_ENTITIES.assign(view.begin(), view.end());
+
+    FRAME.main.camera = camera;
+    FRAME.main.aspect = (float)GetRenderWidth() / GetRenderHeight();
+    FRAME.main.render_state = render_state;
+
+    FRAME.shadow_passes.resize(shadow_jobs.size());
+    for (size_t i = 0; i < shadow_jobs.size(); ++i) {
+        auto &pass = FRAME.shadow_passes[i];
+        pass.entity = shadow_jobs[i].entity;
+        pass.shadow_map = shadow_jobs[i].shadow_map;
+        pass.list.camera = shadow_jobs[i].camera;
+        pass.list.aspect = (float)pass.shadow_map->texture.width / pass.shadow_map->texture.height;
+        pass.list.render_state = render_state;
+        pass.list.render_state.is_shadow_map_pass = true;
+    }
+
+    // a job per pass, each one splits its tiles and meshes further
+    const Mesh &plane = resources::get_mesh("plane");
+    int n_passes = 1 + FRAME.shadow_passes.size();
+    jobs::parallel_for(0, n_passes, 1, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+            build_list(i == 0 ? FRAME.main : FRAME.shadow_passes[i - 1].list, plane);
+        }
+    });
+
+    // marking the uses mutates the resources, so it's done serially
+    for (const auto &use : FRAME.main.material_uses) {
+        resources::use_material_pbr(use.material);
+        if (use.mip_level >= 0) {
+            resources::request_material_mip_level(use.material, use.mip_level);
+        }
+    }
+
+    return FRAME;
+}
+
+void draw_list(const DrawList &list) {
+    const Mesh &plane = resources::get_mesh("plane");
+    const auto &render_state = list.render_state;
+
+    render::begin_frame(render_state);
+
+    for (int has_displacement = 0; has_displacement < 2; ++has_displacement) {
+        render::draw_mesh_instanced(
+            plane, has_displacement, list.tile_instances[has_displacement], render_state
+        );
+    }
+
+    for (const auto &item : list.items) {
+        render::draw_mesh(
+            *item.mesh, *item.material_pbr, item.constant_color, item.matrix, render_state
+        );
+    }
+}
+
+}  // namespace soft_tissues::system::frame
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "core/pbr.hpp"
+#include "core/resources.hpp"
+#include "entt/entity/fwd.hpp"
+#include "render_state.hpp"
+#include "raylib/raylib.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace soft_tissues::system::frame {
+
+struct DrawItem {
+    uint64_t sort_key;
+    const Mesh *mesh;
+    const pbr::MaterialPBR *material_pbr;
+    Color constant_color;
+    Matrix matrix;
+};
+
+// Material drawn in the frame. The mip level is -1 for the passes which
+// don't sample the material maps
+struct MaterialUse {
+    resources::MaterialHandle material;
+    int mip_level;
+};
+
+// Everything a single pass draws. Built on the worker threads and immutable
+// afterwards, the pointers stay valid until the end of the frame
+struct DrawList {
+    Camera3D camera;
+    float aspect;
+    RenderState render_state;
+
+    // floor and ceil transforms of all materials (the material layer is
+    // packed into the transform), split by whether the material has displacement
+    std::array<std::vector<Matrix>, 2> tile_instances;
+    // sorted by the sort key
+    std::vector<DrawItem> items;
+    std::vector<MaterialUse> material_uses;
+};
+
+struct ShadowPass {
+    entt::entity entity;
+    RenderTexture2D *shadow_map;
+    DrawList list;
+};
+
+struct Frame {
+    DrawList main;
+    std::vector<ShadowPass> shadow_passes;
+};
+
+// Builds the draw lists of the main pass and all shadow passes in parallel:
+// culling, world matrices, material resolution and sort keys. The returned
+// frame is valid until the next call
+const Frame &prepare(Camera3D camera, const RenderState &render_state);
+
+// Must be called inside BeginMode3D with the list's camera
+void draw_list(const DrawList &list);
+
+}  // namespace soft_tissues::system::frame
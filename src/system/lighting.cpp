@@ -3,16 +3,24 @@
 #include "component/component.hpp"
 #include "globals.hpp"
 #include "core/pbr.hpp"
+#include "core/gl.hpp"
 #include "core/resources.hpp"
+#include "core/vram.hpp"
 #include "system/transform.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
 #include "raylib/rlgl.h"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
 
 namespace soft_tissues::system::lighting {
 
-std::vector<ShadowPassJob> prepare_shadow_passes() {
-    std::vector<ShadowPassJob> jobs;
+frame_arena::Vector<ShadowPassJob> prepare_shadow_passes() {
+    frame_arena::Vector<ShadowPassJob> jobs;
 
     for (auto entity : globals::registry.view<component::Light>()) {
         auto &light = globals::registry.get<component::Light>(entity);
@@ -75,6 +83,7 @@ std::vector<ShadowPassJob> prepare_shadow_passes() {
 
 void finalize_shadow_pass(entt::entity entity, Matrix vp_mat) {
     auto &sd = globals::registry.get<component::ShadowData>(entity);
+    if (std::memcmp(&sd.vp_mat, &vp_mat, sizeof(Matrix)) != 0) mark_dirty(entity);
     sd.vp_mat = vp_mat;
 
     auto &light = globals::registry.get<component::Light>(entity);
@@ -83,67 +92,224 @@ void finalize_shadow_pass(entt::entity entity, Matrix vp_mat) {
     }
 }
 
-void set_light_uniforms(pbr::PBRShader &pbr_shader) {
-    int light_idx = 0;
+// -----------------------------------------------------------------------
+// light buffer
+// GPU copy of the lights which are on, one slot per light. Only the changed
+// slots are patched: the Light changes come from the registry signals, the
+// moves from the world transform versions. A light switched on or off, added
+// or removed changes the slot layout, then all slots are rewritten.
 
-    for (auto entity : globals::registry.view<component::Light>()) {
-        if (light_idx >= render_config::MAX_N_LIGHTS) break;
+// std140 layout of the Light in common.glsl
+struct GPULight {
+    Vector3 position;
+    int type;
 
-        auto &light = globals::registry.get<component::Light>(entity);
-        if (!light.is_on) continue;
+    Vector3 direction;
+    int casts_shadows;
 
-        Shader shader = pbr_shader.get_shader();
-        const auto &locs = pbr_shader.get_light_locs(light_idx);
+    Vector3 color;
+    float intensity;
 
-        Vector3 direction = transform::get_forward(entity);
-        Vector4 color = ColorNormalize(light.color);
+    Vector3 attenuation;
+    float inner_cutoff;
 
-        // shadow map
-        auto *sd = globals::registry.try_get<component::ShadowData>(entity);
-        if (sd != nullptr && sd->shadow_map != nullptr) {
-            int slot = render_config::SHADOW_MAP_TEXTURE_SLOT_OFFSET + light_idx;
+    float outer_cutoff;
+    float padding[3];
 
-            rlActiveTextureSlot(slot);
-            rlEnableTexture(sd->shadow_map->texture.id);
-            SetShaderValue(shader, locs.shadow_map, &slot, SHADER_UNIFORM_INT);
-        }
+    float16 vp_mat;
+};
+static_assert(sizeof(GPULight) == 144, "GPULight doesn't match the std140 layout");
 
-        // common params
-        int casts_shadows = static_cast<int>(light.casts_shadows);
-        int light_type = static_cast<int>(light.light_type);
-        Matrix vp_mat = (sd != nullptr) ? sd->vp_mat : MatrixIdentity();
+// std140 layout of the Lights block in pbr.frag.glsl
+struct GPULights {
+    int n_lights;
+    int padding[3];
+    std::array<GPULight, render_config::MAX_N_LIGHTS> lights;
+};
 
-        Vector3 position = transform::get_world_position(entity);
-        SetShaderValue(shader, locs.position, &position, SHADER_UNIFORM_VEC3);
-        SetShaderValue(shader, locs.type, &light_type, SHADER_UNIFORM_INT);
-        SetShaderValue(shader, locs.color, &color, SHADER_UNIFORM_VEC3);
-        SetShaderValue(shader, locs.intensity, &light.intensity, SHADER_UNIFORM_FLOAT);
-        SetShaderValue(shader, locs.casts_shadows, &casts_shadows, SHADER_UNIFORM_INT);
-        SetShaderValueMatrix(shader, locs.vp_mat, vp_mat);
-
-        // type params
-        switch (light.light_type) {
-            case component::LightType::POINT: {
-                auto &p = std::get<component::PointParams>(light.params);
-                SetShaderValue(shader, locs.attenuation, &p.attenuation, SHADER_UNIFORM_VEC3);
-            } break;
-            case component::LightType::DIRECTIONAL: {
-                SetShaderValue(shader, locs.direction, &direction, SHADER_UNIFORM_VEC3);
-            } break;
-            case component::LightType::SPOT: {
-                auto &p = std::get<component::SpotParams>(light.params);
-                SetShaderValue(shader, locs.attenuation, &p.attenuation, SHADER_UNIFORM_VEC3);
-                SetShaderValue(shader, locs.direction, &direction, SHADER_UNIFORM_VEC3);
-                SetShaderValue(shader, locs.inner_cutoff, &p.inner_cutoff, SHADER_UNIFORM_FLOAT);
-                SetShaderValue(shader, locs.outer_cutoff, &p.outer_cutoff, SHADER_UNIFORM_FLOAT);
-            } break;
-            default: break;
-        }
+static GPULights LIGHTS;
+static gl::GLuint LIGHTS_BUFFER_ID = 0;
+static int LIGHTS_VRAM_ID = vram::INVALID_ID;
+
+// light entities of the slots, in the registry view order
+static std::array<entt::entity, render_config::MAX_N_LIGHTS> SLOT_ENTITIES;
+// world transform versions the slots were written with
+static std::array<uint64_t, render_config::MAX_N_LIGHTS> SLOT_TRANSFORM_VERSIONS;
+static std::array<bool, render_config::MAX_N_LIGHTS> DIRTY_SLOTS;
+
+static std::vector<entt::entity> DIRTY_ENTITIES;
+static bool IS_LAYOUT_DIRTY = true;
+static int N_PATCHED_LIGHTS = 0;
+
+static void on_light_updated(entt::registry &, entt::entity entity) {
+    mark_dirty(entity);
+}
+
+static void on_light_added_or_removed(entt::registry &, entt::entity) {
+    IS_LAYOUT_DIRTY = true;
+}
+
+void load() {
+    auto &reg = globals::registry;
+    reg.on_construct<component::Light>().connect<&on_light_added_or_removed>();
+    reg.on_update<component::Light>().connect<&on_light_updated>();
+    reg.on_destroy<component::Light>().connect<&on_light_added_or_removed>();
+
+    gl::GenBuffers(1, &LIGHTS_BUFFER_ID);
+    gl::BindBuffer(gl::UNIFORM_BUFFER, LIGHTS_BUFFER_ID);
+    gl::BufferData(gl::UNIFORM_BUFFER, sizeof(LIGHTS), nullptr, gl::DYNAMIC_DRAW);
+    gl::BindBuffer(gl::UNIFORM_BUFFER, 0);
+
+    // no other code uses the uniform buffers, so the binding stays
+    gl::BindBufferBase(
+        gl::UNIFORM_BUFFER, render_config::LIGHTS_BUFFER_BINDING, LIGHTS_BUFFER_ID
+    );
+
+    LIGHTS_VRAM_ID = vram::add(vram::Category::BUFFERS, "lights", sizeof(LIGHTS));
+    IS_LAYOUT_DIRTY = true;
+}
+
+void unload() {
+    gl::DeleteBuffers(1, &LIGHTS_BUFFER_ID);
+    LIGHTS_BUFFER_ID = 0;
+
+    vram::remove(LIGHTS_VRAM_ID);
+    LIGHTS_VRAM_ID = vram::INVALID_ID;
+}
+
+void mark_dirty(entt::entity entity) {
+    DIRTY_ENTITIES.push_back(entity);
+}
+
+static int get_slot(entt::entity entity) {
+    for (int slot = 0; slot < LIGHTS.n_lights; ++slot) {
+        if (SLOT_ENTITIES[slot] == entity) return slot;
+    }
+
+    return -1;
+}
 
-        light_idx++;
+// Assigns the slots in the view order, the lights beyond MAX_N_LIGHTS are
+// ignored
+static void rebuild_layout() {
+    const auto &reg = globals::registry;
+
+    int n_lights = 0;
+    for (auto entity : reg.view<component::Light>()) {
+        if (n_lights == render_config::MAX_N_LIGHTS) break;
+        if (!reg.get<component::Light>(entity).is_on) continue;
+
+        SLOT_ENTITIES[n_lights] = entity;
+        DIRTY_SLOTS[n_lights] = true;
+        n_lights += 1;
+    }
+
+    LIGHTS.n_lights = n_lights;
+    IS_LAYOUT_DIRTY = false;
+}
+
+static void write_slot(int slot) {
+    const auto &reg = globals::registry;
+    entt::entity entity = SLOT_ENTITIES[slot];
+    const auto &light = reg.get<component::Light>(entity);
+    auto *sd = reg.try_get<component::ShadowData>(entity);
+
+    GPULight &gpu_light = LIGHTS.lights[slot];
+    Vector4 color = ColorNormalize(light.color);
+
+    gpu_light = {};
+    gpu_light.position = transform::get_world_position(entity);
+    gpu_light.type = static_cast<int>(light.light_type);
+    gpu_light.direction = transform::get_forward(entity);
+    gpu_light.casts_shadows = static_cast<int>(light.casts_shadows);
+    gpu_light.color = {color.x, color.y, color.z};
+    gpu_light.intensity = light.intensity;
+    gpu_light.vp_mat = MatrixToFloatV(sd != nullptr ? sd->vp_mat : MatrixIdentity());
+
+    switch (light.light_type) {
+        case component::LightType::POINT: {
+            auto &p = std::get<component::PointParams>(light.params);
+            gpu_light.attenuation = p.attenuation;
+        } break;
+        case component::LightType::SPOT: {
+            auto &p = std::get<component::SpotParams>(light.params);
+            gpu_light.attenuation = p.attenuation;
+            gpu_light.inner_cutoff = p.inner_cutoff;
+            gpu_light.outer_cutoff = p.outer_cutoff;
+        } break;
+        default: break;
+    }
+
+    SLOT_TRANSFORM_VERSIONS[slot] = transform::get_world_version(entity);
+}
+
+void update() {
+    const auto &reg = globals::registry;
+
+    // the removed lights have already marked the layout dirty
+    for (auto entity : DIRTY_ENTITIES) {
+        if (!reg.valid(entity) || !reg.all_of<component::Light>(entity)) continue;
+
+        int slot = get_slot(entity);
+        bool is_on = reg.get<component::Light>(entity).is_on;
+        if (is_on != (slot != -1)) IS_LAYOUT_DIRTY = true;
+        else if (slot != -1) DIRTY_SLOTS[slot] = true;
     }
+    DIRTY_ENTITIES.clear();
+
+    bool is_layout_changed = IS_LAYOUT_DIRTY;
+    if (IS_LAYOUT_DIRTY) rebuild_layout();
+
+    // the moved lights (or the moved parents of them)
+    for (int slot = 0; slot < LIGHTS.n_lights; ++slot) {
+        uint64_t version = transform::get_world_version(SLOT_ENTITIES[slot]);
+        if (version != SLOT_TRANSFORM_VERSIONS[slot]) DIRTY_SLOTS[slot] = true;
+    }
+
+    int first_slot = LIGHTS.n_lights;
+    int end_slot = 0;
+    N_PATCHED_LIGHTS = 0;
+    for (int slot = 0; slot < LIGHTS.n_lights; ++slot) {
+        if (!DIRTY_SLOTS[slot]) continue;
+
+        write_slot(slot);
+        DIRTY_SLOTS[slot] = false;
+        first_slot = std::min(first_slot, slot);
+        end_slot = slot + 1;
+        N_PATCHED_LIGHTS += 1;
+    }
+
+    // a single upload of the changed range, the header only with the layout
+    size_t offset = offsetof(GPULights, lights) + first_slot * sizeof(GPULight);
+    size_t end = offsetof(GPULights, lights) + end_slot * sizeof(GPULight);
+    if (is_layout_changed) offset = 0;
+    if (offset >= end) return;
+
+    gl::BindBuffer(gl::UNIFORM_BUFFER, LIGHTS_BUFFER_ID);
+    gl::BufferSubData(
+        gl::UNIFORM_BUFFER, offset, end - offset, reinterpret_cast<char *>(&LIGHTS) + offset
+    );
+    gl::BindBuffer(gl::UNIFORM_BUFFER, 0);
+}
+
+void bind_shadow_maps() {
+    const auto &reg = globals::registry;
+
+    for (int slot = 0; slot < LIGHTS.n_lights; ++slot) {
+        auto *sd = reg.try_get<component::ShadowData>(SLOT_ENTITIES[slot]);
+        if (sd == nullptr || sd->shadow_map == nullptr) continue;
+
+        rlActiveTextureSlot(render_config::SHADOW_MAP_TEXTURE_SLOT_OFFSET + slot);
+        rlEnableTexture(sd->shadow_map->texture.id);
+    }
+}
+
+int get_n_lights() {
+    return LIGHTS.n_lights;
+}
 
-    pbr_shader.set_n_lights(light_idx);
+int get_n_patched_lights() {
+    return N_PATCHED_LIGHTS;
 }
 
 }  // namespace soft_tissues::system::lighting
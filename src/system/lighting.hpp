@@ -1,9 +1,8 @@
 #pragma once
 
-#include "core/pbr.hpp"
+#include "core/frame_arena.hpp"
 #include "entt/entity/fwd.hpp"
 #include "raylib/raylib.h"
-#include <vector>
 
 namespace soft_tissues::system::lighting {
 
@@ -13,9 +12,24 @@ struct ShadowPassJob {
     RenderTexture2D *shadow_map;
 };
 
-std::vector<ShadowPassJob> prepare_shadow_passes();
+frame_arena::Vector<ShadowPassJob> prepare_shadow_passes();
 void finalize_shadow_pass(entt::entity entity, Matrix vp_mat);
 
-void set_light_uniforms(pbr::PBRShader &pbr_shader);
+// Registers the Light change hooks and creates the light buffer
+void load();
+void unload();
+
+// Must be called after the Light is written directly, patching it through
+// the registry marks it on its own
+void mark_dirty(entt::entity entity);
+// Patches the changed lights into the light buffer, once per frame after the
+// shadow passes (their view projections are a part of the lights)
+void update();
+// Binds the shadow maps of the lights to their slots
+void bind_shadow_maps();
+
+int get_n_lights();
+// Lights uploaded by the last update
+int get_n_patched_lights();
 
 }  // namespace soft_tissues::system::lighting
@@ -1,37 +1,103 @@
 #include "render.hpp"
 
 #include "core/pbr.hpp"
+#include "core/resources.hpp"
+#include "system/lighting.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
 #include "raylib/rlgl.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
 
 namespace soft_tissues::system::render {
 
-void begin_frame(pbr::PBRShader &pbr_shader, const RenderState &render_state) {
-    pbr_shader.set_shadow_map_pass(render_state.is_shadow_map_pass);
+static RenderState PASS_RENDER_STATE;
+static Vector3 PASS_CAMERA_POS;
+static int PASS_ID = 0;
 
+// variant key -> id of the last pass its per-pass uniforms were uploaded in
+static std::array<int, pbr::ShaderVariant::N_KEYS> VARIANT_PASS_IDS;
+
+void begin_frame(const RenderState &render_state) {
     Matrix mat = MatrixInvert(rlGetMatrixModelview());
-    pbr_shader.set_camera_pos({mat.m12, mat.m13, mat.m14});
 
-    if (!render_state.is_shadow_map_pass) {
-        pbr_shader.set_light_enabled(render_state.is_light_enabled);
-        pbr_shader.set_shadow_map_bias(render_state.shadow_map_bias);
-        pbr_shader.set_shadow_map_max_dist(render_state.shadow_map_max_dist);
+    PASS_RENDER_STATE = render_state;
+    PASS_CAMERA_POS = {mat.m12, mat.m13, mat.m14};
+    PASS_ID += 1;
+
+    resources::get_material_array().bind();
+    if (render_state.is_shadow_map_pass) return;
+
+    // the lights themselves are in the light buffer, only their maps are bound
+    lighting::bind_shadow_maps();
+}
+
+// Picks the cheapest shader variant for the draw. Per-pass uniforms are
+// uploaded lazily, once per pass for each variant which is actually used.
+static pbr::PBRShader &use_variant(
+    bool has_displacement, bool is_instanced, const RenderState &render_state
+) {
+    pbr::ShaderVariant variant;
+    variant.is_shadow_map_pass = render_state.is_shadow_map_pass;
+    variant.is_light_enabled = render_state.is_light_enabled;
+    variant.has_displacement = has_displacement;
+    variant.is_instanced = is_instanced;
+
+    pbr::PBRShader &pbr_shader = resources::get_pbr_shader(variant);
+
+    int &pass_id = VARIANT_PASS_IDS[variant.get_key()];
+    if (pass_id != PASS_ID) {
+        pbr_shader.set_camera_pos(PASS_CAMERA_POS);
+        pbr_shader.set_shadow_map_max_dist(PASS_RENDER_STATE.shadow_map_max_dist);
+        pbr_shader.set_material_params(resources::get_material_array().get_params());
+
+        if (variant.is_lit()) {
+            pbr_shader.set_shadow_map_bias(PASS_RENDER_STATE.shadow_map_bias);
+        }
+
+        pass_id = PASS_ID;
     }
+
+    return pbr_shader;
 }
 
 void draw_mesh(const Mesh &mesh, const pbr::MaterialPBR &material_pbr, Color constant_color, Matrix matrix, const RenderState &render_state) {
-    Material material = material_pbr.get_material();
-    pbr::PBRShader &pbr_shader = material_pbr.get_pbr_shader();
-
-    pbr_shader.set_tiling(material_pbr.get_tiling());
-    pbr_shader.set_displacement_scale(material_pbr.get_displacement_scale());
+    bool has_displacement = material_pbr.get_displacement_scale() != 0.0;
+    pbr::PBRShader &pbr_shader = use_variant(has_displacement, false, render_state);
+    pbr_shader.set_material_layer(material_pbr.get_layer());
 
     if (!render_state.is_shadow_map_pass) {
         pbr_shader.set_constant_color(constant_color);
     }
 
+    // NOTE: The material maps are bound by begin_frame, DrawMesh needs
+    // the raylib's material only to carry the shader
+    Material material = resources::get_material_color(WHITE);
+    material.shader = pbr_shader.get_shader();
+
     DrawMesh(mesh, material, matrix);
 }
 
+Matrix get_instance_transform(Matrix matrix, const pbr::MaterialPBR &material_pbr) {
+    matrix.m3 = material_pbr.get_layer();
+    return matrix;
+}
+
+void draw_mesh_instanced(const Mesh &mesh, bool has_displacement, const std::vector<Matrix> &transforms, const RenderState &render_state) {
+    if (transforms.empty()) return;
+
+    pbr::PBRShader &pbr_shader = use_variant(has_displacement, true, render_state);
+
+    if (!render_state.is_shadow_map_pass) {
+        pbr_shader.set_constant_color(BLANK);
+    }
+
+    Material material = resources::get_material_color(WHITE);
+    material.shader = pbr_shader.get_shader();
+
+    DrawMeshInstanced(mesh, material, transforms.data(), transforms.size());
+}
+
 }  // namespace soft_tissues::system::render
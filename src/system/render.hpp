@@ -1,12 +1,20 @@
 #pragma once
 
 #include "core/pbr.hpp"
+#include "core/resources.hpp"
 #include "render_state.hpp"
 #include "raylib/raylib.h"
+#include <vector>
 
 namespace soft_tissues::system::render {
 
-void begin_frame(pbr::PBRShader &pbr_shader, const RenderState &render_state);
+// Must be called inside BeginMode3D, after the camera for the pass is set
+void begin_frame(const RenderState &render_state);
 void draw_mesh(const Mesh &mesh, const pbr::MaterialPBR &material_pbr, Color constant_color, Matrix matrix, const RenderState &render_state);
+// Packs the material layer into the instance transform (see pbr.vert.glsl)
+Matrix get_instance_transform(Matrix matrix, const pbr::MaterialPBR &material_pbr);
+// Transforms must be built with get_instance_transform, so the instances may use
+// different materials. has_displacement selects the displacement shader variant
+void draw_mesh_instanced(const Mesh &mesh, bool has_displacement, const std::vector<Matrix> &transforms, const RenderState &render_state);
 
 }  // namespace soft_tissues::system::render
@@ -2,16 +2,18 @@
 
 #include "component/component.hpp"
 #include "globals.hpp"
+#include "core/jobs.hpp"
 #include "core/resources.hpp"
 #include "core/world.hpp"
-#include "system/render.hpp"
 #include "system/transform.hpp"
 #include "utils.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
+#include <cmath>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace soft_tissues::system::scene {
 
@@ -204,12 +206,17 @@ static void emit_corner_fill(
     // Top and bottom caps omitted — occluded by floor/ceiling tiles.
 }
 
-void rebuild_wall_meshes() {
-    resources::unload_wall_meshes();
+// Tiles and vertex rows are split into chunks emitted in parallel, each chunk
+// into its own builders. Merging them in the chunk order gives the same
+// meshes as the serial emission.
+using MeshBuilders = std::unordered_map<std::string, MeshBuilder>;
+
+static constexpr int WALL_TILES_GRAIN_SIZE = 32;
+static constexpr int FILL_ROWS_GRAIN_SIZE = 4;
 
-    std::unordered_map<std::string, MeshBuilder> builders;
-    tile::Tile *tiles = world::get_tiles();
-    int n_tiles = world::get_tiles_count();
+void rebuild_wall_meshes() {
+    auto tiles = world::get_tiles();
+    int n_tiles = tiles.size();
 
     // Precompute fill grid: which vertices have perpendicular walls meeting.
     static constexpr int VR = world::N_ROWS + 1;
@@ -238,57 +245,79 @@ void rebuild_wall_meshes() {
     }
 
     // Emit wall segments. Suppress end caps at vertices where a fill exists.
-    for (int i = 0; i < n_tiles; ++i) {
-        tile::Tile &tile = tiles[i];
-        if (world::get_tile_room_id(&tile) == -1) continue;
-        if (tile.materials.wall_key.empty()) continue;
-
-        Vector2 pos = tile.get_floor_position();
-        auto [tile_row, tile_col] = world::get_tile_row_col(&tile);
-
-        for (int d = 0; d < 4; ++d) {
-            Direction dir = static_cast<Direction>(d);
-            if (!tile.has_solid_wall(dir)) continue;
-
-            // Grid vertices at each end of this wall segment.
-            struct EndVerts { int ar, ac, br, bc; };
-            static constexpr EndVerts WALL_VERTS[] = {
-                {0, 0, 0, 1},  // NORTH
-                {1, 1, 1, 0},  // SOUTH
-                {1, 0, 0, 0},  // WEST
-                {0, 1, 1, 1},  // EAST
-            };
-            auto &wv = WALL_VERTS[d];
-            int va_r = tile_row + wv.ar, va_c = tile_col + wv.ac;
-            int vb_r = tile_row + wv.br, vb_c = tile_col + wv.bc;
-
-            bool fill_a = fill_grid[va_r][va_c];
-            bool fill_b = fill_grid[vb_r][vb_c];
-
-            const std::string &key = tile.materials.wall_key;
-            emit_inner_wall_segment(
-                builders[key], pos, dir, !fill_a, !fill_b, fill_a, fill_b
-            );
+    int n_wall_chunks = (n_tiles + WALL_TILES_GRAIN_SIZE - 1) / WALL_TILES_GRAIN_SIZE;
+    std::vector<MeshBuilders> wall_chunks(n_wall_chunks);
+    jobs::parallel_for(0, n_tiles, WALL_TILES_GRAIN_SIZE, [&](int begin, int end) {
+        MeshBuilders &builders = wall_chunks[begin / WALL_TILES_GRAIN_SIZE];
+
+        for (int i = begin; i < end; ++i) {
+            tile::Tile &tile = tiles[i];
+            if (world::get_tile_room_id(&tile) == -1) continue;
+            if (tile.materials.wall_key.empty()) continue;
+
+            Vector2 pos = tile.get_floor_position();
+            auto [tile_row, tile_col] = world::get_tile_row_col(&tile);
+
+            for (int d = 0; d < 4; ++d) {
+                Direction dir = static_cast<Direction>(d);
+                if (!tile.has_solid_wall(dir)) continue;
+
+                // Grid vertices at each end of this wall segment.
+                struct EndVerts { int ar, ac, br, bc; };
+                static constexpr EndVerts WALL_VERTS[] = {
+                    {0, 0, 0, 1},  // NORTH
+                    {1, 1, 1, 0},  // SOUTH
+                    {1, 0, 0, 0},  // WEST
+                    {0, 1, 1, 1},  // EAST
+                };
+                auto &wv = WALL_VERTS[d];
+                int va_r = tile_row + wv.ar, va_c = tile_col + wv.ac;
+                int vb_r = tile_row + wv.br, vb_c = tile_col + wv.bc;
+
+                bool fill_a = fill_grid[va_r][va_c];
+                bool fill_b = fill_grid[vb_r][vb_c];
+
+                const std::string &key = tile.materials.wall_key;
+                emit_inner_wall_segment(
+                    builders[key], pos, dir, !fill_a, !fill_b, fill_a, fill_b
+                );
+            }
         }
-    }
+    });
 
     // Emit corner fills at vertices where perpendicular walls meet.
-    for (int row = 0; row < VR; ++row) {
-        for (int col = 0; col < VC; ++col) {
-            if (!fill_grid[row][col]) continue;
-
-            float vx = static_cast<float>(col) - world::N_COLS * 0.5f + world::ORIGIN.x;
-            float vz = static_cast<float>(row) - world::N_ROWS * 0.5f + world::ORIGIN.y;
-
-            for (auto &ch : VERTEX_CHECKS) {
-                tile::Tile *t = world::get_tile_at_row_col(row + ch.r, col + ch.c);
-                if (!t || world::get_tile_room_id(t) == -1) continue;
-                if (t->materials.wall_key.empty()) continue;
-
-                emit_corner_fill(
-                    builders[t->materials.wall_key], vx, vz, ch.dx, ch.dz,
-                    ch.ns_dir, ch.ew_dir
-                );
+    int n_fill_chunks = (VR + FILL_ROWS_GRAIN_SIZE - 1) / FILL_ROWS_GRAIN_SIZE;
+    std::vector<MeshBuilders> fill_chunks(n_fill_chunks);
+    jobs::parallel_for(0, VR, FILL_ROWS_GRAIN_SIZE, [&](int begin, int end) {
+        MeshBuilders &builders = fill_chunks[begin / FILL_ROWS_GRAIN_SIZE];
+
+        for (int row = begin; row < end; ++row) {
+            for (int col = 0; col < VC; ++col) {
+                if (!fill_grid[row][col]) continue;
+
+                float vx = static_cast<float>(col) - world::N_COLS * 0.5f + world::ORIGIN.x;
+                float vz = static_cast<float>(row) - world::N_ROWS * 0.5f + world::ORIGIN.y;
+
+                for (auto &ch : VERTEX_CHECKS) {
+                    tile::Tile *t = world::get_tile_at_row_col(row + ch.r, col + ch.c);
+                    if (!t || world::get_tile_room_id(t) == -1) continue;
+                    if (t->materials.wall_key.empty()) continue;
+
+                    emit_corner_fill(
+                        builders[t->materials.wall_key], vx, vz, ch.dx, ch.dz,
+                        ch.ns_dir, ch.ew_dir
+                    );
+                }
+            }
+        }
+    });
+
+    // Merge chunks: all wall segments first, then all fills
+    MeshBuilders builders;
+    for (auto *chunks : {&wall_chunks, &fill_chunks}) {
+        for (auto &chunk : *chunks) {
+            for (auto &[key, mb] : chunk) {
+                builders[key].append(mb);
             }
         }
     }
@@ -340,56 +369,6 @@ void draw_grid() {
     DrawLine3D(bot_left, top_left, RED);
 }
 
-void draw_tiles(const RenderState &render_state) {
-    const Mesh &mesh = resources::get_mesh("plane");
-    tile::Tile *tiles = world::get_tiles();
-    int n_tiles = world::get_tiles_count();
-
-    for (int i = 0; i < n_tiles; ++i) {
-        tile::Tile &tile = tiles[i];
-
-        // don't draw tile which doesn't belong to any room
-        if (world::get_tile_room_id(&tile) == -1) continue;
-
-        // draw floor
-        const auto &floor_material_pbr = resources::get_material_pbr(tile.materials.floor_key);
-        render::draw_mesh(
-            mesh, floor_material_pbr, tile.constant_color,
-            tile.get_floor_matrix(), render_state
-        );
-
-        // draw ceil
-        const auto &ceil_material_pbr = resources::get_material_pbr(tile.materials.ceil_key);
-        render::draw_mesh(
-            mesh, ceil_material_pbr, tile.constant_color,
-            tile.get_ceil_matrix(), render_state
-        );
-    }
-
-    // draw wall meshes (one mesh per wall material)
-    const auto &wall_meshes = resources::get_wall_meshes();
-    Matrix identity = MatrixIdentity();
-    Color no_color = {0, 0, 0, 0};
-    for (const auto &[wall_key, wall_mesh] : wall_meshes) {
-        const auto &wall_material_pbr = resources::get_material_pbr(wall_key);
-        render::draw_mesh(wall_mesh, wall_material_pbr, no_color, identity, render_state);
-    }
-}
-
-void draw_meshes(const RenderState &render_state) {
-    auto view = globals::registry.view<component::MyMesh>();
-
-    for (auto entity : view) {
-        const auto &my_mesh = globals::registry.get<component::MyMesh>(entity);
-        Matrix matrix = transform::get_world_matrix(entity);
-
-        const auto &mesh = resources::get_mesh(my_mesh.mesh_key);
-        const auto &material_pbr = resources::get_material_pbr(my_mesh.material_pbr_key);
-
-        render::draw_mesh(mesh, material_pbr, my_mesh.constant_color, matrix, render_state);
-    }
-}
-
 void draw_player() {
     auto view = globals::registry.view<component::Player>();
     if (view.empty()) return;
@@ -5,8 +5,6 @@
 namespace soft_tissues::system::scene {
 
 void draw_grid();
-void draw_tiles(const RenderState &render_state);
-void draw_meshes(const RenderState &render_state);
 void draw_player();
 void draw_light_shells();
 
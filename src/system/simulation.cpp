@@ -0,0 +1,107 @@
+#include "simulation.hpp"
+
+#include "component/component.hpp"
+#include "gameplay_config.hpp"
+#include "globals.hpp"
+#include "system/controller.hpp"
+#include "system/transform.hpp"
+#include "raylib/raymath.h"
+#include <chrono>
+#include <cmath>
+
+namespace soft_tissues::system::simulation {
+
+static float RATE = gameplay_config::SIMULATION_RATE;
+static double ACCUMULATOR = 0.0;
+static float ALPHA = 0.0;
+static int N_STEPS = 0;
+static float CPU_MS = 0.0;
+
+static void on_player_constructed(entt::registry &reg, entt::entity entity) {
+    reg.emplace_or_replace<component::SimulatedPosition>(entity);
+}
+
+void load() {
+    globals::registry.on_construct<component::Player>().connect<&on_player_constructed>();
+}
+
+// Adopts the positions set outside of the simulation, without interpolating
+// towards them
+static void sync_positions() {
+    auto view = globals::registry.view<component::Transform, component::SimulatedPosition>();
+    for (auto [entity, tr, sp] : view.each()) {
+        if (Vector3Equals(tr.position, sp.rendered_position)) continue;
+
+        sp.prev_position = tr.position;
+        sp.position = tr.position;
+        sp.rendered_position = tr.position;
+    }
+}
+
+static void step(float dt) {
+    for (auto [entity, sp] : globals::registry.view<component::SimulatedPosition>().each()) {
+        sp.prev_position = sp.position;
+    }
+
+    if (globals::GAME_STATE == globals::GameState::PLAY) {
+        controller::step(dt);
+    }
+}
+
+static void interpolate(float alpha) {
+    auto view = globals::registry.view<component::Transform, component::SimulatedPosition>();
+    for (auto [entity, tr, sp] : view.each()) {
+        Vector3 position = Vector3Lerp(sp.prev_position, sp.position, alpha);
+        sp.rendered_position = position;
+        if (Vector3Equals(tr.position, position)) continue;
+
+        tr.position = position;
+        transform::mark_dirty(entity);
+    }
+}
+
+void update(float frame_dt) {
+    auto start_time = std::chrono::steady_clock::now();
+
+    sync_positions();
+
+    float dt = 1.0 / RATE;
+    ACCUMULATOR += frame_dt;
+    N_STEPS = 0;
+    while (ACCUMULATOR >= dt && N_STEPS < gameplay_config::MAX_N_SIMULATION_STEPS) {
+        step(dt);
+        ACCUMULATOR -= dt;
+        N_STEPS += 1;
+    }
+
+    // the simulation can't keep up, the backlog is dropped
+    if (ACCUMULATOR >= dt) ACCUMULATOR = std::fmod(ACCUMULATOR, dt);
+
+    ALPHA = ACCUMULATOR / dt;
+    interpolate(ALPHA);
+
+    std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start_time;
+    CPU_MS = 0.9 * CPU_MS + 0.1 * elapsed.count();
+}
+
+float get_rate() {
+    return RATE;
+}
+
+void set_rate(float rate) {
+    RATE = rate;
+}
+
+float get_alpha() {
+    return ALPHA;
+}
+
+int get_n_steps() {
+    return N_STEPS;
+}
+
+float get_cpu_ms() {
+    return CPU_MS;
+}
+
+}  // namespace soft_tissues::system::simulation
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace soft_tissues::system::simulation {
+
+// Registers the hook which makes the players simulated
+void load();
+// Runs the fixed steps covered by the accumulated frame time, then
+// interpolates the simulated positions between the last two steps
+void update(float frame_dt);
+
+float get_rate();
+void set_rate(float rate);
+
+// Interpolation factor between the last two steps, in [0, 1)
+float get_alpha();
+// Steps run by the last update()
+int get_n_steps();
+// CPU time of update(), smoothed over the frames
+float get_cpu_ms();
+
+}  // namespace soft_tissues::system::simulation
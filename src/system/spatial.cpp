@@ -0,0 +1,457 @@
+#include "spatial.hpp"
+
+#include "component/component.hpp"
+#include "globals.hpp"
+#include "core/resources.hpp"
+#include "core/world.hpp"
+#include "system/transform.hpp"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace soft_tissues::system::spatial {
+
+// -----------------------------------------------------------------------
+// loose grid
+// A cell per tile. An entity is linked only into the cell of its bounds
+// center, the queries widen their cell ranges by the largest half extent
+// instead. The entities too large for that (and the meshes without the finite
+// bounds) are linked into the extra list, which every query checks.
+
+struct Item {
+    entt::entity entity;
+    BoundingBox bounds;
+    int cell;
+    // links of the cell list, -1 at its ends
+    int prev;
+    int next;
+};
+
+static constexpr int N_CELLS = world::N_ROWS * world::N_COLS;
+static constexpr int OVERSIZED_CELL = N_CELLS;
+// in the cells, larger entities go to the oversized list
+static constexpr float MAX_LOOSE_HALF_EXTENT = 4.0;
+
+// dense, the last item takes the place of the removed one
+static std::vector<Item> ITEMS;
+// by the entity index, -1 when the entity is not indexed
+static std::vector<int> ITEM_IDXS;
+static std::array<int, N_CELLS + 1> CELL_HEADS;
+
+// bounds of the entities in the grid cells, they only grow
+static float MAX_HALF_EXTENT = 0.0;
+static float MIN_Y = FLT_MAX;
+static float MAX_Y = -FLT_MAX;
+
+// moved or remeshed since the last update, may repeat
+static std::vector<entt::entity> CHANGED_ENTITIES;
+static int N_UPDATED_ENTITIES = 0;
+
+struct CellRange {
+    int row_min;
+    int row_max;
+    int col_min;
+    int col_max;
+};
+
+// Grid space: the tile grid corner at the origin, a unit per cell
+static Vector2 to_grid(float x, float z) {
+    Rectangle rect = world::get_bound_rect();
+    return {x - rect.x, z - rect.y};
+}
+
+static int get_row(float grid_z) {
+    return std::floor(Clamp(grid_z, 0.0, world::N_ROWS - 1));
+}
+
+static int get_col(float grid_x) {
+    return std::floor(Clamp(grid_x, 0.0, world::N_COLS - 1));
+}
+
+// Cells whose entities may overlap the box
+static CellRange get_cell_range(BoundingBox box) {
+    if (box.max.y < MIN_Y || box.min.y > MAX_Y) return {0, -1, 0, -1};
+
+    Vector2 min = to_grid(box.min.x - MAX_HALF_EXTENT, box.min.z - MAX_HALF_EXTENT);
+    Vector2 max = to_grid(box.max.x + MAX_HALF_EXTENT, box.max.z + MAX_HALF_EXTENT);
+
+    return {get_row(min.y), get_row(max.y), get_col(min.x), get_col(max.x)};
+}
+
+// Bounds of the entities the cell may hold, the border cells hold the
+// entities beyond the grid as well
+static BoundingBox get_loose_cell_bounds(int row, int col) {
+    Rectangle rect = world::get_bound_rect();
+    float x = rect.x + col;
+    float z = rect.y + row;
+
+    BoundingBox bounds = {
+        {x - MAX_HALF_EXTENT, MIN_Y, z - MAX_HALF_EXTENT},
+        {x + 1.0f + MAX_HALF_EXTENT, MAX_Y, z + 1.0f + MAX_HALF_EXTENT},
+    };
+    if (col == 0) bounds.min.x = -FLT_MAX;
+    if (col == world::N_COLS - 1) bounds.max.x = FLT_MAX;
+    if (row == 0) bounds.min.z = -FLT_MAX;
+    if (row == world::N_ROWS - 1) bounds.max.z = FLT_MAX;
+
+    return bounds;
+}
+
+template <typename F> static void for_each_in_cell(int cell, F &&f) {
+    for (int idx = CELL_HEADS[cell]; idx != -1; idx = ITEMS[idx].next) {
+        f(ITEMS[idx]);
+    }
+}
+
+template <typename F> static void for_each_in_range(CellRange range, F &&f) {
+    for (int row = range.row_min; row <= range.row_max; ++row) {
+        for (int col = range.col_min; col <= range.col_max; ++col) {
+            for_each_in_cell(row * world::N_COLS + col, f);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+// items
+
+static int get_item_idx(entt::entity entity) {
+    size_t k = entt::to_entity(entity);
+    if (k >= ITEM_IDXS.size() || ITEM_IDXS[k] == -1) return -1;
+
+    int idx = ITEM_IDXS[k];
+    return ITEMS[idx].entity == entity ? idx : -1;
+}
+
+static void link(int idx, int cell) {
+    Item &item = ITEMS[idx];
+    item.cell = cell;
+    item.prev = -1;
+    item.next = CELL_HEADS[cell];
+
+    if (item.next != -1) ITEMS[item.next].prev = idx;
+    CELL_HEADS[cell] = idx;
+}
+
+static void unlink(int idx) {
+    Item &item = ITEMS[idx];
+
+    if (item.prev != -1) ITEMS[item.prev].next = item.next;
+    else CELL_HEADS[item.cell] = item.next;
+    if (item.next != -1) ITEMS[item.next].prev = item.prev;
+
+    item.cell = -1;
+}
+
+static bool is_finite(BoundingBox bounds) {
+    return bounds.min.x > -FLT_MAX && bounds.min.y > -FLT_MAX && bounds.min.z > -FLT_MAX
+           && bounds.max.x < FLT_MAX && bounds.max.y < FLT_MAX && bounds.max.z < FLT_MAX;
+}
+
+// The box around the mesh bounds placed by the rigid transform
+static BoundingBox get_world_bounds(entt::entity entity) {
+    const auto &reg = std::as_const(globals::registry);
+
+    Matrix m = transform::get_world_matrix(entity);
+    Vector3 position = {m.m12, m.m13, m.m14};
+
+    const auto *my_mesh = reg.try_get<component::MyMesh>(entity);
+    if (my_mesh == nullptr) return {position, position};
+
+    BoundingBox bounds = resources::get_mesh_bounds(my_mesh->mesh);
+    if (!is_finite(bounds)) return bounds;
+
+    Vector3 center = Vector3Scale(Vector3Add(bounds.min, bounds.max), 0.5);
+    Vector3 e = Vector3Scale(Vector3Subtract(bounds.max, bounds.min), 0.5);
+
+    center = Vector3Transform(center, m);
+    e = {
+        std::abs(m.m0) * e.x + std::abs(m.m4) * e.y + std::abs(m.m8) * e.z,
+        std::abs(m.m1) * e.x + std::abs(m.m5) * e.y + std::abs(m.m9) * e.z,
+        std::abs(m.m2) * e.x + std::abs(m.m6) * e.y + std::abs(m.m10) * e.z,
+    };
+
+    return {Vector3Subtract(center, e), Vector3Add(center, e)};
+}
+
+static int get_cell(BoundingBox bounds) {
+    if (!is_finite(bounds)) return OVERSIZED_CELL;
+
+    float half_extent = 0.5 * std::max(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z);
+    if (half_extent > MAX_LOOSE_HALF_EXTENT) return OVERSIZED_CELL;
+
+    Vector2 center = to_grid(
+        0.5 * (bounds.min.x + bounds.max.x), 0.5 * (bounds.min.z + bounds.max.z)
+    );
+    return get_row(center.y) * world::N_COLS + get_col(center.x);
+}
+
+// Inserts the entity or moves it to its current cell
+static void place(entt::entity entity) {
+    BoundingBox bounds = get_world_bounds(entity);
+    int cell = get_cell(bounds);
+
+    int idx = get_item_idx(entity);
+    if (idx == -1) {
+        idx = ITEMS.size();
+        ITEMS.push_back({entity, bounds, -1, -1, -1});
+
+        size_t k = entt::to_entity(entity);
+        if (k >= ITEM_IDXS.size()) ITEM_IDXS.resize(k + 1, -1);
+        ITEM_IDXS[k] = idx;
+    }
+
+    Item &item = ITEMS[idx];
+    item.bounds = bounds;
+    if (item.cell != cell) {
+        if (item.cell != -1) unlink(idx);
+        link(idx, cell);
+    }
+
+    if (cell != OVERSIZED_CELL) {
+        float half_extent = 0.5
+                            * std::max(bounds.max.x - bounds.min.x, bounds.max.z - bounds.min.z);
+        MAX_HALF_EXTENT = std::max(MAX_HALF_EXTENT, half_extent);
+        MIN_Y = std::min(MIN_Y, bounds.min.y);
+        MAX_Y = std::max(MAX_Y, bounds.max.y);
+    }
+}
+
+static void remove(entt::entity entity) {
+    int idx = get_item_idx(entity);
+    if (idx == -1) return;
+
+    unlink(idx);
+    ITEM_IDXS[entt::to_entity(entity)] = -1;
+
+    // nothing links to the removed item anymore, only the moved one is relinked
+    int last_idx = ITEMS.size() - 1;
+    if (idx != last_idx) {
+        Item moved = ITEMS[last_idx];
+
+        if (moved.prev != -1) ITEMS[moved.prev].next = idx;
+        else CELL_HEADS[moved.cell] = idx;
+        if (moved.next != -1) ITEMS[moved.next].prev = idx;
+
+        ITEMS[idx] = moved;
+        ITEM_IDXS[entt::to_entity(moved.entity)] = idx;
+    }
+    ITEMS.pop_back();
+}
+
+// -----------------------------------------------------------------------
+// frustum
+
+Frustum get_frustum(Matrix view_projection) {
+    const Matrix &vp = view_projection;
+    Vector4 x = {vp.m0, vp.m4, vp.m8, vp.m12};
+    Vector4 y = {vp.m1, vp.m5, vp.m9, vp.m13};
+    Vector4 z = {vp.m2, vp.m6, vp.m10, vp.m14};
+    Vector4 w = {vp.m3, vp.m7, vp.m11, vp.m15};
+
+    Frustum frustum = {
+        Vector4Add(w, x),
+        Vector4Subtract(w, x),
+        Vector4Add(w, y),
+        Vector4Subtract(w, y),
+        Vector4Add(w, z),
+        Vector4Subtract(w, z),
+    };
+
+    for (auto &plane : frustum) {
+        plane = Vector4Scale(plane, 1.0 / Vector3Length({plane.x, plane.y, plane.z}));
+    }
+
+    return frustum;
+}
+
+// The box corner farthest along the plane normal is tested, so the infinite
+// bounds never produce a nan
+bool is_box_visible(const Frustum &frustum, const BoundingBox &box) {
+    for (const auto &plane : frustum) {
+        float x = plane.x >= 0.0 ? box.max.x : box.min.x;
+        float y = plane.y >= 0.0 ? box.max.y : box.min.y;
+        float z = plane.z >= 0.0 ? box.max.z : box.min.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0) return false;
+    }
+
+    return true;
+}
+
+bool is_sphere_visible(const Frustum &frustum, Vector3 center, float radius) {
+    for (const auto &plane : frustum) {
+        float dist = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        if (dist < -radius) return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// index
+
+// New entities and the moved ones are reported by the transform system
+static void on_transform_destroyed(entt::registry &, entt::entity entity) {
+    remove(entity);
+}
+
+static void on_mesh_changed(entt::registry &, entt::entity entity) {
+    CHANGED_ENTITIES.push_back(entity);
+}
+
+void load() {
+    CELL_HEADS.fill(-1);
+
+    auto &reg = globals::registry;
+    reg.on_destroy<component::Transform>().connect<&on_transform_destroyed>();
+    reg.on_construct<component::MyMesh>().connect<&on_mesh_changed>();
+    reg.on_update<component::MyMesh>().connect<&on_mesh_changed>();
+    reg.on_destroy<component::MyMesh>().connect<&on_mesh_changed>();
+}
+
+void update() {
+    const auto &reg = std::as_const(globals::registry);
+
+    transform::consume_changed_entities(CHANGED_ENTITIES);
+
+    N_UPDATED_ENTITIES = 0;
+    for (auto entity : CHANGED_ENTITIES) {
+        // destroyed after the change, already removed
+        if (!reg.valid(entity) || !reg.all_of<component::Transform>(entity)) continue;
+
+        place(entity);
+        N_UPDATED_ENTITIES += 1;
+    }
+    CHANGED_ENTITIES.clear();
+}
+
+int get_n_entities() {
+    return ITEMS.size();
+}
+
+int get_n_updated_entities() {
+    return N_UPDATED_ENTITIES;
+}
+
+// -----------------------------------------------------------------------
+// queries
+
+void query_aabb(BoundingBox box, frame_arena::Vector<entt::entity> &entities) {
+    auto test = [&](const Item &item) {
+        if (CheckCollisionBoxes(item.bounds, box)) entities.push_back(item.entity);
+    };
+
+    for_each_in_cell(OVERSIZED_CELL, test);
+    for_each_in_range(get_cell_range(box), test);
+}
+
+void query_sphere(Vector3 center, float radius, frame_arena::Vector<entt::entity> &entities) {
+    auto test = [&](const Item &item) {
+        if (CheckCollisionBoxSphere(item.bounds, center, radius)) {
+            entities.push_back(item.entity);
+        }
+    };
+
+    Vector3 extent = {radius, radius, radius};
+    BoundingBox box = {Vector3Subtract(center, extent), Vector3Add(center, extent)};
+
+    for_each_in_cell(OVERSIZED_CELL, test);
+    for_each_in_range(get_cell_range(box), test);
+}
+
+void query_frustum(const Frustum &frustum, frame_arena::Vector<entt::entity> &entities) {
+    auto test = [&](const Item &item) {
+        if (is_box_visible(frustum, item.bounds)) entities.push_back(item.entity);
+    };
+
+    for_each_in_cell(OVERSIZED_CELL, test);
+    for (int row = 0; row < world::N_ROWS; ++row) {
+        for (int col = 0; col < world::N_COLS; ++col) {
+            int cell = row * world::N_COLS + col;
+            if (CELL_HEADS[cell] == -1) continue;
+            if (!is_box_visible(frustum, get_loose_cell_bounds(row, col))) continue;
+
+            for_each_in_cell(cell, test);
+        }
+    }
+}
+
+// Clips the segment's [t0, t1] to the [0, size] slab of an axis
+static bool clip_to_slab(float origin, float direction, float size, float &t0, float &t1) {
+    if (direction == 0.0) return origin >= 0.0 && origin <= size;
+
+    float ta = -origin / direction;
+    float tb = (size - origin) / direction;
+    if (ta > tb) std::swap(ta, tb);
+
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    return t0 <= t1;
+}
+
+void query_ray(Ray ray, float max_dist, frame_arena::Vector<entt::entity> &entities) {
+    auto test = [&](const Item &item) {
+        auto collision = GetRayCollisionBox(ray, item.bounds);
+        if (collision.hit && collision.distance <= max_dist) entities.push_back(item.entity);
+    };
+
+    for_each_in_cell(OVERSIZED_CELL, test);
+
+    // the t is the distance along the ray, the segment is clipped only by the
+    // height of the grid entities: the parts of the ray beyond the grid are
+    // followed over the border cells, which hold the entities beyond it
+    float t0 = 0.0;
+    float t1 = max_dist;
+    if (!clip_to_slab(ray.position.y - MIN_Y, ray.direction.y, MAX_Y - MIN_Y, t0, t1)) return;
+
+    Vector2 origin = to_grid(ray.position.x, ray.position.z);
+    Vector2 direction = {ray.direction.x, ray.direction.z};
+
+    // cols crossed by the segment clamped to the grid in each row, the
+    // clamping keeps the segment monotone, so they are contiguous
+    frame_arena::Vector<std::pair<int, int>> path_cols(world::N_ROWS, {INT_MAX, INT_MIN});
+    auto add_path = [&](int row, float ta, float tb) {
+        int col_a = get_col(origin.x + direction.x * ta);
+        int col_b = get_col(origin.x + direction.x * tb);
+        path_cols[row].first = std::min({path_cols[row].first, col_a, col_b});
+        path_cols[row].second = std::max({path_cols[row].second, col_a, col_b});
+    };
+
+    if (direction.y == 0.0) {
+        add_path(get_row(origin.y), t0, t1);
+    } else {
+        int row_a = get_row(origin.y + direction.y * t0);
+        int row_b = get_row(origin.y + direction.y * t1);
+        for (int row = std::min(row_a, row_b); row <= std::max(row_a, row_b); ++row) {
+            // the border rows extend beyond the grid
+            float z_min = row == 0 ? -FLT_MAX : row;
+            float z_max = row == world::N_ROWS - 1 ? FLT_MAX : row + 1.0f;
+            float ta = (z_min - origin.y) / direction.y;
+            float tb = (z_max - origin.y) / direction.y;
+            if (ta > tb) std::swap(ta, tb);
+
+            add_path(row, std::max(t0, ta), std::min(t1, tb));
+        }
+    }
+
+    // the path widened by the largest half extent, each cell is visited once
+    int pad = std::ceil(MAX_HALF_EXTENT);
+    for (int row = 0; row < world::N_ROWS; ++row) {
+        int col_min = INT_MAX;
+        int col_max = INT_MIN;
+        for (int r = std::max(0, row - pad); r <= std::min(world::N_ROWS - 1, row + pad); ++r) {
+            col_min = std::min(col_min, path_cols[r].first);
+            col_max = std::max(col_max, path_cols[r].second);
+        }
+        if (col_min > col_max) continue;
+
+        col_min = std::max(0, col_min - pad);
+        col_max = std::min(world::N_COLS - 1, col_max + pad);
+        for_each_in_range({row, row, col_min, col_max}, test);
+    }
+}
+
+}  // namespace soft_tissues::system::spatial
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "core/frame_arena.hpp"
+#include "entt/entity/fwd.hpp"
+#include "raylib/raylib.h"
+#include <array>
+
+namespace soft_tissues::system::spatial {
+
+// Frustum planes (normal, distance) pointing inward
+using Frustum = std::array<Vector4, 6>;
+
+// Planes of the clip space box, moved back to the world space and normalized
+Frustum get_frustum(Matrix view_projection);
+// Conservative: a shape may be reported visible while it's only near a corner
+bool is_box_visible(const Frustum &frustum, const BoundingBox &box);
+bool is_sphere_visible(const Frustum &frustum, Vector3 center, float radius);
+
+// Registers the hooks which keep the index of the entities with a Transform.
+// The bounds are the world box of the MyMesh, a point for the other entities
+void load();
+// Re-bins the entities moved or remeshed since the last call. Once per frame
+// after the transform update, until the next change the queries are read-only,
+// so the worker threads may call them
+void update();
+
+int get_n_entities();
+// Entities re-binned by the last update
+int get_n_updated_entities();
+
+// The queries append the entities whose bounds overlap the shape, each one
+// once, in no particular order. Entities beyond the tile grid are kept in
+// its border cells
+void query_aabb(BoundingBox box, frame_arena::Vector<entt::entity> &entities);
+void query_sphere(Vector3 center, float radius, frame_arena::Vector<entt::entity> &entities);
+void query_frustum(const Frustum &frustum, frame_arena::Vector<entt::entity> &entities);
+// Ray direction must be normalized, the distance finite
+void query_ray(Ray ray, float max_dist, frame_arena::Vector<entt::entity> &entities);
+
+}  // namespace soft_tissues::system::spatial
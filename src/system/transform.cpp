@@ -1,44 +1,282 @@
 #include "transform.hpp"
 
 #include "component/component.hpp"
+#include "core/jobs.hpp"
 #include "globals.hpp"
 #include "raylib/raymath.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 namespace soft_tissues::system::transform {
 
-Quaternion get_world_quaternion(entt::entity entity) {
-    auto &tr = globals::registry.get<component::Transform>(entity);
+// -----------------------------------------------------------------------
+// world transform cache
+// Entities are kept in the depth-first order: parents precede their children
+// and the descendants of an entity follow it contiguously. The world transforms
+// are stored in the same order, so the update is a single linear pass which
+// reads the already updated parent by its index.
+static std::vector<entt::entity> ENTITIES;
+// -1 for the roots
+static std::vector<int> PARENT_IDXS;
+// number of the descendants including the entity itself
+static std::vector<int> SUBTREE_SIZES;
+// the roots split the entities into independent subtrees
+static std::vector<int> ROOT_IDXS;
+static std::vector<uint8_t> DIRTY_FLAGS;
+static bool HAS_DIRTY = false;
+// subtrees (idx, size) marked dirty since the changes were last consumed,
+// collapsed into the single range of all entities once it doesn't pay off
+static std::vector<std::pair<int, int>> CHANGED_RANGES;
+// set when an entity or a parent link is added or removed
+static bool IS_ORDER_DIRTY = true;
+
+static std::vector<Vector3> WORLD_POSITIONS;
+static std::vector<Quaternion> WORLD_ROTATIONS;
+static std::vector<Matrix> WORLD_MATRICES;
+// the N_UPDATES value of the last recomputation
+static std::vector<uint64_t> WORLD_VERSIONS;
+// counts the recomputations (the update passes and the single entity ones),
+// so the versions never repeat
+static uint64_t N_UPDATES = 0;
 
-    Quaternion parent_q = QuaternionIdentity();
-    auto *parent = globals::registry.try_get<component::Parent>(entity);
-    if (parent != nullptr) {
-        parent_q = get_world_quaternion(parent->entity);
+static constexpr int ROOTS_GRAIN_SIZE = 256;
+static constexpr int MATRICES_GRAIN_SIZE = 2048;
+
+static void on_transform_constructed(entt::registry &reg, entt::entity entity) {
+    reg.emplace_or_replace<component::HierarchyNode>(entity);
+    IS_ORDER_DIRTY = true;
+}
+
+static void on_transform_changed(entt::registry &, entt::entity entity) {
+    mark_dirty(entity);
+}
+
+static void on_hierarchy_changed(entt::registry &, entt::entity) {
+    IS_ORDER_DIRTY = true;
+}
+
+void load() {
+    auto &reg = globals::registry;
+    reg.on_construct<component::Transform>().connect<&on_transform_constructed>();
+    reg.on_update<component::Transform>().connect<&on_transform_changed>();
+    reg.on_destroy<component::Transform>().connect<&on_hierarchy_changed>();
+    reg.on_construct<component::Parent>().connect<&on_hierarchy_changed>();
+    reg.on_update<component::Parent>().connect<&on_hierarchy_changed>();
+    reg.on_destroy<component::Parent>().connect<&on_hierarchy_changed>();
+}
+
+// Sorts the entities in the depth-first order and marks all of them dirty
+static void rebuild_order() {
+    static std::vector<entt::entity> entities;
+    static std::vector<int> parent_ks;
+    static std::vector<int> child_offsets;
+    static std::vector<int> children;
+    static std::vector<std::pair<int, int>> stack;
+
+    auto &reg = globals::registry;
+    auto view = reg.view<component::Transform>();
+    entities.assign(view.begin(), view.end());
+    int n = entities.size();
+
+    // the node idx temporarily holds the position in the entities
+    for (int k = 0; k < n; ++k) {
+        reg.get<component::HierarchyNode>(entities[k]).idx = k;
     }
 
-    auto my_q = tr.get_local_quaternion();
-    return QuaternionMultiply(parent_q, my_q);
+    // children lists, packed into a single array
+    parent_ks.assign(n, -1);
+    child_offsets.assign(n + 1, 0);
+    for (int k = 0; k < n; ++k) {
+        auto *parent = reg.try_get<component::Parent>(entities[k]);
+        if (parent == nullptr || !reg.all_of<component::Transform>(parent->entity)) continue;
+
+        parent_ks[k] = reg.get<component::HierarchyNode>(parent->entity).idx;
+        child_offsets[parent_ks[k] + 1] += 1;
+    }
+    for (int k = 0; k < n; ++k) {
+        child_offsets[k + 1] += child_offsets[k];
+    }
+    children.resize(n);
+    for (int k = 0; k < n; ++k) {
+        if (parent_ks[k] != -1) children[child_offsets[parent_ks[k]]++] = k;
+    }
+    // the fill advanced the offsets to the ends of the lists
+    for (int k = n; k > 0; --k) {
+        child_offsets[k] = child_offsets[k - 1];
+    }
+    child_offsets[0] = 0;
+
+    // depth-first traversal from the roots: (k, parent idx)
+    ENTITIES.clear();
+    PARENT_IDXS.clear();
+    for (int k = n - 1; k >= 0; --k) {
+        if (parent_ks[k] == -1) stack.push_back({k, -1});
+    }
+    while (!stack.empty()) {
+        auto [k, parent_idx] = stack.back();
+        stack.pop_back();
+
+        int idx = ENTITIES.size();
+        ENTITIES.push_back(entities[k]);
+        PARENT_IDXS.push_back(parent_idx);
+        reg.get<component::HierarchyNode>(entities[k]).idx = idx;
+
+        for (int c = child_offsets[k + 1] - 1; c >= child_offsets[k]; --c) {
+            stack.push_back({children[c], idx});
+        }
+    }
+
+    if ((int)ENTITIES.size() != n) {
+        throw std::runtime_error("Transform hierarchy has a cycle");
+    }
+
+    SUBTREE_SIZES.assign(n, 1);
+    ROOT_IDXS.clear();
+    for (int idx = n - 1; idx >= 0; --idx) {
+        int parent_idx = PARENT_IDXS[idx];
+        if (parent_idx != -1) SUBTREE_SIZES[parent_idx] += SUBTREE_SIZES[idx];
+        else ROOT_IDXS.push_back(idx);
+    }
+    std::reverse(ROOT_IDXS.begin(), ROOT_IDXS.end());
+
+    WORLD_POSITIONS.resize(n);
+    WORLD_ROTATIONS.resize(n);
+    WORLD_MATRICES.resize(n);
+    WORLD_VERSIONS.resize(n);
+    DIRTY_FLAGS.assign(n, 1);
+    HAS_DIRTY = n > 0;
+    IS_ORDER_DIRTY = false;
+
+    // the old ranges refer to the old order
+    CHANGED_RANGES.assign(1, {0, n});
 }
 
-Vector3 get_world_position(entt::entity entity) {
-    auto &tr = globals::registry.get<component::Transform>(entity);
+void mark_dirty(entt::entity entity) {
+    // the rebuild marks everything anyway
+    if (IS_ORDER_DIRTY) return;
+
+    int idx = globals::registry.get<component::HierarchyNode>(entity).idx;
+    // a dirty entity has all its descendants dirty already
+    if (DIRTY_FLAGS[idx]) return;
 
-    Vector3 parent_pos = Vector3Zero();
-    auto *parent = globals::registry.try_get<component::Parent>(entity);
-    if (parent != nullptr) {
-        parent_pos = get_world_position(parent->entity);
+    std::fill_n(DIRTY_FLAGS.begin() + idx, SUBTREE_SIZES[idx], 1);
+    HAS_DIRTY = true;
+
+    if (CHANGED_RANGES.size() < ENTITIES.size()) {
+        CHANGED_RANGES.push_back({idx, SUBTREE_SIZES[idx]});
+    } else {
+        CHANGED_RANGES.assign(1, {0, (int)ENTITIES.size()});
     }
+}
+
+void consume_changed_entities(std::vector<entt::entity> &entities) {
+    if (IS_ORDER_DIRTY) rebuild_order();
 
-    return Vector3Add(parent_pos, tr.position);
+    for (auto [idx, size] : CHANGED_RANGES) {
+        entities.insert(entities.end(), ENTITIES.begin() + idx, ENTITIES.begin() + idx + size);
+    }
+    CHANGED_RANGES.clear();
 }
 
-Matrix get_world_matrix(entt::entity entity) {
-    Vector3 pos = get_world_position(entity);
-    Quaternion q = get_world_quaternion(entity);
+// Composes the local transform with the parent one, the parent must be clean.
+// Called from the worker threads, so the registry is accessed as const
+static void update_world_transform(int idx) {
+    const auto &reg = std::as_const(globals::registry);
+    const auto &tr = reg.get<component::Transform>(ENTITIES[idx]);
+
+    int parent_idx = PARENT_IDXS[idx];
+    if (parent_idx == -1) {
+        WORLD_POSITIONS[idx] = tr.position;
+        WORLD_ROTATIONS[idx] = tr.rotation;
+    } else {
+        WORLD_POSITIONS[idx] = Vector3Add(WORLD_POSITIONS[parent_idx], tr.position);
+        WORLD_ROTATIONS[idx] = QuaternionMultiply(WORLD_ROTATIONS[parent_idx], tr.rotation);
+    }
+
+    WORLD_VERSIONS[idx] = N_UPDATES;
+}
+
+// Rotation followed by the translation
+static void update_world_matrix(int idx) {
+    Vector3 pos = WORLD_POSITIONS[idx];
+    Matrix matrix = QuaternionToMatrix(WORLD_ROTATIONS[idx]);
+    matrix.m12 = pos.x;
+    matrix.m13 = pos.y;
+    matrix.m14 = pos.z;
+    WORLD_MATRICES[idx] = matrix;
+}
+
+// Brings a single entity up to date, together with its dirty ancestors
+static int get_updated_idx(entt::entity entity) {
+    static std::vector<int> idxs;
+
+    if (IS_ORDER_DIRTY) rebuild_order();
+
+    int idx = globals::registry.get<component::HierarchyNode>(entity).idx;
+    if (!DIRTY_FLAGS[idx]) return idx;
+
+    // the dirty ancestors form a chain ending at a clean one or at the root
+    N_UPDATES += 1;
+    idxs.clear();
+    for (int i = idx; i != -1 && DIRTY_FLAGS[i]; i = PARENT_IDXS[i]) {
+        idxs.push_back(i);
+    }
+    for (auto it = idxs.rbegin(); it != idxs.rend(); ++it) {
+        update_world_transform(*it);
+        update_world_matrix(*it);
+        DIRTY_FLAGS[*it] = 0;
+    }
 
-    Matrix t = MatrixTranslate(pos.x, pos.y, pos.z);
-    Matrix r = QuaternionToMatrix(q);
+    return idx;
+}
+
+void update() {
+    if (IS_ORDER_DIRTY) rebuild_order();
+    if (!HAS_DIRTY) return;
+
+    N_UPDATES += 1;
+
+    // the subtrees are independent, so the chunks of roots are updated in
+    // parallel; within a subtree parents precede their children
+    int n_roots = ROOT_IDXS.size();
+    jobs::parallel_for(0, n_roots, ROOTS_GRAIN_SIZE, [](int begin, int end) {
+        int last_root_idx = ROOT_IDXS[end - 1];
+        int end_idx = last_root_idx + SUBTREE_SIZES[last_root_idx];
+        for (int idx = ROOT_IDXS[begin]; idx < end_idx; ++idx) {
+            if (DIRTY_FLAGS[idx]) update_world_transform(idx);
+        }
+    });
+
+    int n = ENTITIES.size();
+    jobs::parallel_for(0, n, MATRICES_GRAIN_SIZE, [](int begin, int end) {
+        for (int idx = begin; idx < end; ++idx) {
+            if (DIRTY_FLAGS[idx]) update_world_matrix(idx);
+            DIRTY_FLAGS[idx] = 0;
+        }
+    });
+
+    HAS_DIRTY = false;
+}
+
+// -----------------------------------------------------------------------
+// getters
+Quaternion get_world_quaternion(entt::entity entity) {
+    return WORLD_ROTATIONS[get_updated_idx(entity)];
+}
+
+Vector3 get_world_position(entt::entity entity) {
+    return WORLD_POSITIONS[get_updated_idx(entity)];
+}
+
+Matrix get_world_matrix(entt::entity entity) {
+    return WORLD_MATRICES[get_updated_idx(entity)];
+}
 
-    return MatrixMultiply(r, t);
+uint64_t get_world_version(entt::entity entity) {
+    return WORLD_VERSIONS[get_updated_idx(entity)];
 }
 
 Vector3 get_forward(entt::entity entity) {
@@ -49,26 +287,28 @@ Vector3 get_right(entt::entity entity) {
     return Vector3RotateByQuaternion({1.0, 0.0, 0.0}, get_world_quaternion(entity));
 }
 
+// -----------------------------------------------------------------------
+// setters
 void set_forward(entt::entity entity, Vector3 forward) {
     Vector3 old_forward = get_forward(entity);
     auto &tr = globals::registry.get<component::Transform>(entity);
     auto new_q = QuaternionFromVector3ToVector3(old_forward, forward);
-    auto my_q = tr.get_local_quaternion();
-    auto q = QuaternionMultiply(new_q, my_q);
-    tr.rotation = QuaternionToEuler(q);
+    // renormalized, so the repeated edits don't accumulate the error
+    tr.rotation = QuaternionNormalize(QuaternionMultiply(new_q, tr.rotation));
+    mark_dirty(entity);
 }
 
 void step(entt::entity entity, Vector3 delta) {
     auto &tr = globals::registry.get<component::Transform>(entity);
     tr.position = Vector3Add(tr.position, delta);
+    mark_dirty(entity);
 }
 
 void rotate_by_axis_angle(entt::entity entity, Vector3 axis, float angle) {
     auto &tr = globals::registry.get<component::Transform>(entity);
     auto new_q = QuaternionFromAxisAngle(axis, angle);
-    auto my_q = tr.get_local_quaternion();
-    auto q = QuaternionMultiply(new_q, my_q);
-    tr.rotation = QuaternionToEuler(q);
+    tr.rotation = QuaternionNormalize(QuaternionMultiply(new_q, tr.rotation));
+    mark_dirty(entity);
 }
 
 }  // namespace soft_tissues::system::transform
@@ -3,12 +3,35 @@
 #include "entt/entity/fwd.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
+#include <cstdint>
+#include <vector>
 
 namespace soft_tissues::system::transform {
 
+// Registers the hooks which keep the world transforms of the registry entities
+void load();
+// Recomputes the dirty world transforms in a single pass over the entities
+// sorted parents first. Getters bring the dirty entities up to date on their
+// own, so this only moves the bulk of the work into a single place of the frame.
+// Until the next change the getters are read-only, so the worker threads may
+// call them
+void update();
+
+// Must be called after the Transform is written directly (the functions below
+// call it themselves)
+void mark_dirty(entt::entity entity);
+
+// Appends the entities whose world transform changed since the previous call.
+// An entity may repeat, all of them are reported after a hierarchy change.
+// The changes are consumed, so there is a single caller: the spatial index
+void consume_changed_entities(std::vector<entt::entity> &entities);
+
 Quaternion get_world_quaternion(entt::entity entity);
 Vector3 get_world_position(entt::entity entity);
 Matrix get_world_matrix(entt::entity entity);
+// Grows whenever the world transform of the entity is recomputed, so the
+// systems deriving data from it can tell whether their copy is stale
+uint64_t get_world_version(entt::entity entity);
 Vector3 get_forward(entt::entity entity);
 Vector3 get_right(entt::entity entity);
 
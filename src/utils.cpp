@@ -1,13 +1,13 @@
 #include "utils.hpp"
 
+#include "core/pack.hpp"
+#include "core/shader_cache.hpp"
 #include "raylib/raylib.h"
 #include "raylib/raymath.h"
 #include "raylib/rlgl.h"
 #include <cstdio>
 #include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 
@@ -26,6 +26,25 @@ Direction flip_direction(Direction direction) {
     return NORTH;
 }
 
+// -----------------------------------------------------------------------
+// hash
+uint64_t hash_fnv1a(const void *data, size_t size, uint64_t seed) {
+    static constexpr uint64_t prime = 1099511628211ull;
+
+    auto bytes = static_cast<const unsigned char *>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= prime;
+    }
+
+    return hash;
+}
+
+uint64_t hash_fnv1a(const std::string &data, uint64_t seed) {
+    return hash_fnv1a(data.data(), data.size(), seed);
+}
+
 // -----------------------------------------------------------------------
 // texture
 Texture load_texture(const std::string &dir_path, const std::string &file_name) {
@@ -59,27 +78,35 @@ std::string get_shader_file_path(const std::string &file_name) {
     return file_path;
 }
 
-std::string load_shader_src(const std::string &file_name) {
+std::string load_shader_src(
+    const std::string &file_name, const std::vector<std::string> &defines
+) {
     const std::string version_src = "#version 460 core";
-    std::ifstream common_file(get_shader_file_path("common.glsl"));
-    std::ifstream shader_file(get_shader_file_path(file_name));
+    auto common_file = pack::load_file(get_shader_file_path("common.glsl"));
+    auto shader_file = pack::load_file(get_shader_file_path(file_name));
 
-    std::stringstream common_stream, shader_stream;
-    common_stream << common_file.rdbuf();
-    shader_stream << shader_file.rdbuf();
+    std::string common_src(common_file.get_str());
+    std::string shader_src(shader_file.get_str());
 
-    std::string common_src = common_stream.str();
-    std::string shader_src = shader_stream.str();
+    std::string defines_src;
+    for (const auto &define : defines) {
+        defines_src += "#define " + define + "\n";
+    }
 
-    std::string full_src = version_src + "\n" + common_src + "\n" + shader_src;
+    std::string full_src = version_src + "\n" + defines_src + common_src + "\n"
+                           + shader_src;
 
     return full_src;
 }
 
-Shader load_shader(const std::string &vs_file_name, const std::string &fs_file_name) {
-    auto vs = load_shader_src(vs_file_name);
-    auto fs = load_shader_src(fs_file_name);
-    Shader shader = LoadShaderFromMemory(vs.c_str(), fs.c_str());
+Shader load_shader(
+    const std::string &vs_file_name,
+    const std::string &fs_file_name,
+    const std::vector<std::string> &defines
+) {
+    auto vs = load_shader_src(vs_file_name, defines);
+    auto fs = load_shader_src(fs_file_name, defines);
+    Shader shader = shader_cache::load_shader(vs, fs);
 
     if (!IsShaderReady(shader)) {
         throw std::runtime_error(
@@ -314,6 +341,18 @@ void MeshBuilder::push_quad(
     indices.insert(indices.end(), idx, idx + 6);
 }
 
+void MeshBuilder::append(const MeshBuilder &other) {
+    auto base = static_cast<unsigned short>(vertices.size() / 3);
+
+    vertices.insert(vertices.end(), other.vertices.begin(), other.vertices.end());
+    normals.insert(normals.end(), other.normals.begin(), other.normals.end());
+    texcoords.insert(texcoords.end(), other.texcoords.begin(), other.texcoords.end());
+
+    for (unsigned short idx : other.indices) {
+        indices.push_back(static_cast<unsigned short>(base + idx));
+    }
+}
+
 Mesh MeshBuilder::build() {
     int vert_count = static_cast<int>(vertices.size() / 3);
     int tri_count = static_cast<int>(indices.size() / 3);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "raylib/raylib.h"
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -18,6 +19,14 @@ enum Direction : uint8_t {
 
 Direction flip_direction(Direction direction);
 
+// -----------------------------------------------------------------------
+// hash
+constexpr uint64_t FNV1A_OFFSET_BASIS = 14695981039346656037ull;
+
+// 64-bit FNV-1a, pass the previous hash as a seed to hash several chunks
+uint64_t hash_fnv1a(const void *data, size_t size, uint64_t seed = FNV1A_OFFSET_BASIS);
+uint64_t hash_fnv1a(const std::string &data, uint64_t seed = FNV1A_OFFSET_BASIS);
+
 // -----------------------------------------------------------------------
 // texture
 Texture load_texture(const std::string &dir_path, const std::string &file_name);
@@ -25,8 +34,15 @@ Texture load_texture(const std::string &dir_path, const std::string &file_name);
 // -----------------------------------------------------------------------
 // shader
 std::string get_shader_file_path(const std::string &file_name);
-std::string load_shader_src(const std::string &file_name);
-Shader load_shader(const std::string &vs_file_name, const std::string &fs_file_name);
+// Assembles "#version", "#define <define>" lines, common.glsl and the shader file
+std::string load_shader_src(
+    const std::string &file_name, const std::vector<std::string> &defines = {}
+);
+Shader load_shader(
+    const std::string &vs_file_name,
+    const std::string &fs_file_name,
+    const std::vector<std::string> &defines = {}
+);
 
 // -----------------------------------------------------------------------
 // shader attributes and uniforms
@@ -58,6 +74,9 @@ struct MeshBuilder {
         float u0, float v_0, float u1, float v_1
     );
 
+    // Appends the other builder's geometry after this one's
+    void append(const MeshBuilder &other);
+
     Mesh build();
 };
 
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the windowless tests in this directory, each file is
+// its own binary run by "make test". A failed check is reported and counted,
+// the test goes on, so a single run shows all the failures.
+
+inline int N_FAILED_CHECKS = 0;
+
+#define CHECK(condition)                                                                \
+    do {                                                                                \
+        if (!(condition)) {                                                             \
+            std::fprintf(stderr, "%s:%d: failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++N_FAILED_CHECKS;                                                          \
+        }                                                                               \
+    } while (0)
+
+// Exit code of the test's main
+inline int report_checks(const char *name) {
+    if (N_FAILED_CHECKS > 0) {
+        std::fprintf(stderr, "%s: %d checks failed\n", name, N_FAILED_CHECKS);
+        return 1;
+    }
+
+    std::printf("%s: all checks passed\n", name);
+    return 0;
+}
@@ -0,0 +1,93 @@
+// File watcher checks, built and run by "make test" from the repository root.
+// Files are written in place and moved over the watched ones in a temporary
+// directory, the way the editors save them. Doesn't open a window, so it
+// works headless.
+
+#include "check.hpp"
+#include "core/file_watcher.hpp"
+#include "raylib/raylib.h"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace soft_tissues;
+
+namespace fs = std::filesystem;
+
+static void write_file(const fs::path &path, const std::string &text) {
+    std::ofstream f(path);
+    f << text;
+}
+
+static bool is_equal(std::vector<std::string> paths, std::vector<fs::path> expected_paths) {
+    std::vector<std::string> expected;
+    for (const auto &path : expected_paths) expected.push_back(path.string());
+
+    std::sort(paths.begin(), paths.end());
+    std::sort(expected.begin(), expected.end());
+    return paths == expected;
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+static void check_watcher(const fs::path &root_path) {
+    fs::path watched_path = root_path / "watched";
+    fs::path other_path = root_path / "other";
+    fs::create_directory(watched_path);
+    fs::create_directory(other_path);
+
+    fs::path shader_path = watched_path / "pbr.frag.glsl";
+    fs::path map_path = watched_path / "diffuse.png";
+    write_file(shader_path, "0");
+    write_file(map_path, "0");
+
+    file_watcher::FileWatcher watcher;
+    CHECK(!watcher.watch_dir((root_path / "missing").string()));
+    CHECK(watcher.watch_dir(watched_path.string()));
+    CHECK(watcher.poll().empty());
+
+    // written in place twice, reported once
+    write_file(shader_path, "1");
+    write_file(shader_path, "2");
+    CHECK(is_equal(watcher.poll(), {shader_path}));
+    CHECK(watcher.poll().empty());
+
+    // a new file moved over the watched one, the unwatched source is ignored
+    fs::path new_map_path = other_path / "diffuse.png";
+    write_file(new_map_path, "1");
+    fs::rename(new_map_path, map_path);
+    CHECK(is_equal(watcher.poll(), {map_path}));
+
+    // both kinds in the same poll
+    write_file(shader_path, "3");
+    write_file(new_map_path, "2");
+    fs::rename(new_map_path, map_path);
+    CHECK(is_equal(watcher.poll(), {shader_path, map_path}));
+
+    // the files outside the watched directory are never reported
+    write_file(other_path / "normal.png", "0");
+    CHECK(watcher.poll().empty());
+
+    watcher.unload();
+    write_file(shader_path, "4");
+    CHECK(watcher.poll().empty());
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::string root_path = (fs::temp_directory_path() / "file_watcher_XXXXXX").string();
+    if (mkdtemp(root_path.data()) == nullptr) {
+        std::fprintf(stderr, "file_watcher: can't create a temporary directory\n");
+        return 1;
+    }
+
+    check_watcher(root_path);
+    fs::remove_all(root_path);
+
+    return report_checks("file_watcher");
+}
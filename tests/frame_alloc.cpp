@@ -0,0 +1,198 @@
+// Steady-state heap allocation checks, built and run by "make test" from the
+// repository root. Runs the windowless part of the frame over a world of
+// rooms and a moving entity hierarchy: the transform and spatial updates, the
+// spatial and room queries, and the parallel chunked list building of
+// frame::prepare on the frame arena. After the warm-up frames, which grow the
+// arena and the retained buffers, no frame may allocate. The tests are built
+// with the allocation probe, see core/alloc_probe.hpp.
+
+#include "check.hpp"
+#include "component/component.hpp"
+#include "core/alloc_probe.hpp"
+#include "core/frame_arena.hpp"
+#include "core/jobs.hpp"
+#include "core/world.hpp"
+#include "globals.hpp"
+#include "system/spatial.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace soft_tissues;
+
+static constexpr int N_WORKERS = 4;
+static constexpr int N_WARM_UP_FRAMES = 10;
+static constexpr int N_FRAMES = 100;
+static constexpr int CHUNK_SIZE = 64;
+// small on purpose, so the warm-up frames overflow it and grow it
+static constexpr size_t ARENA_N_BYTES = 1024;
+
+static std::vector<entt::entity> ROOTS;
+// retained across the frames like frame::Frame, the capacity is reused
+static std::vector<Matrix> MATRICES;
+
+// -----------------------------------------------------------------------
+// world
+
+static void load_world() {
+    world::reset();
+
+    // four rooms of 4x4 tiles in the grid corners
+    std::array<std::pair<int, int>, 4> corners = {{{0, 0}, {0, 12}, {12, 0}, {12, 12}}};
+    for (int room_id = 0; room_id < (int)corners.size(); ++room_id) {
+        auto [row_0, col_0] = corners[room_id];
+        for (int row = row_0; row < row_0 + 4; ++row) {
+            for (int col = col_0; col < col_0 + 4; ++col) {
+                world::load_tile_to_room(tile::Tile(row * world::N_COLS + col), room_id);
+            }
+        }
+    }
+
+    auto &registry = globals::registry;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-8.0, 8.0);
+    for (int i = 0; i < 200; ++i) {
+        auto root = registry.create();
+        registry.emplace<component::Transform>(root, component::Transform({u(rng), 1.0, u(rng)}));
+        ROOTS.push_back(root);
+
+        auto parent = root;
+        for (int k = 0; k < 8; ++k) {
+            auto entity = registry.create();
+            registry.emplace<component::Transform>(entity, component::Transform({0.1, 0.0, 0.0}));
+            registry.emplace<component::Parent>(entity, component::Parent{parent});
+            if (k % 2 == 0) parent = entity;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+// frame
+
+// Planes of a perspective camera looking over the world
+static system::spatial::Frustum get_frustum(Vector3 position, Vector3 target) {
+    Camera3D camera = {position, target, {0.0, 1.0, 0.0}, 60.0, CAMERA_PERSPECTIVE};
+    Matrix projection = MatrixPerspective(60.0 * DEG2RAD, 16.0 / 9.0, 0.05, 100.0);
+
+    return system::spatial::get_frustum(MatrixMultiply(GetCameraMatrix(camera), projection));
+}
+
+// The windowless part of frame::prepare, returns a value depending on all of
+// the work, so none of it is optimized out
+static uint64_t run_frame(int frame_idx) {
+    for (auto root : ROOTS) system::transform::step(root, {0.01, 0.0, 0.0});
+    if (frame_idx % 4 == 0) {
+        system::transform::rotate_by_axis_angle(ROOTS[frame_idx % ROOTS.size()], {0, 1, 0}, 0.1);
+    }
+
+    system::transform::update();
+    system::spatial::update();
+
+    uint64_t n_found = 0;
+
+    // spatial queries
+    frame_arena::Vector<entt::entity> entities;
+    float angle = 0.1 * frame_idx;
+    Vector3 target = {8.0f * std::cos(angle), 0.0, 8.0f * std::sin(angle)};
+    system::spatial::query_frustum(get_frustum({0.0, 2.0, 0.0}, target), entities);
+    system::spatial::query_aabb({{-4.0, 0.0, -4.0}, {4.0, 2.0, 4.0}}, entities);
+    system::spatial::query_sphere(target, 2.0, entities);
+    system::spatial::query_ray({{0.0, 1.0, 0.0}, Vector3Normalize(target)}, 50.0, entities);
+    n_found += entities.size();
+
+    // room queries
+    for (int room_id : world::get_room_ids()) {
+        n_found += world::get_room_tiles(room_id).size();
+    }
+    for (auto *tile : world::get_all_rooms_tiles()) n_found += tile->id;
+    auto *corner_0 = world::get_tile_at_row_col(0, 0);
+    auto *corner_1 = world::get_tile_at_row_col(world::N_ROWS - 1, world::N_COLS - 1);
+    n_found += world::get_tiles_between_corners(corner_0, corner_1).size();
+
+    // chunks built in parallel on the arena, merged into the retained list
+    int n_chunks = (entities.size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    frame_arena::Vector<frame_arena::Vector<Matrix>> chunks(n_chunks);
+    jobs::parallel_for(0, entities.size(), CHUNK_SIZE, [&](int begin, int end) {
+        auto &chunk = chunks[begin / CHUNK_SIZE];
+        for (int i = begin; i < end; ++i) {
+            chunk.push_back(system::transform::get_world_matrix(entities[i]));
+        }
+    });
+
+    MATRICES.clear();
+    for (const auto &chunk : chunks) MATRICES.insert(MATRICES.end(), chunk.begin(), chunk.end());
+    std::sort(MATRICES.begin(), MATRICES.end(), [](const Matrix &a, const Matrix &b) {
+        return a.m12 < b.m12;
+    });
+    n_found += MATRICES.size();
+
+    frame_arena::reset();
+    return n_found;
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+static void check_probe() {
+    CHECK(alloc_probe::is_enabled());
+
+    // the retained vector escapes, so the allocation can't be elided
+    uint64_t n_allocations = alloc_probe::get_n_allocations();
+    MATRICES.reserve(16);
+    CHECK(alloc_probe::get_n_allocations() - n_allocations == 1);
+}
+
+static void check_arena() {
+    for (size_t alignment : {1, 4, 16, 64}) {
+        auto *p = frame_arena::allocate(3, alignment);
+        CHECK(reinterpret_cast<uintptr_t>(p) % alignment == 0);
+    }
+
+    // overflows to the heap, the next frame fits
+    size_t capacity = frame_arena::get_capacity();
+    frame_arena::allocate(2 * capacity, 16);
+    frame_arena::reset();
+    CHECK(frame_arena::get_capacity() > capacity);
+}
+
+static void check_steady_state_frames() {
+    uint64_t n_found = 0;
+    for (int i = 0; i < N_WARM_UP_FRAMES; ++i) n_found += run_frame(i);
+
+    uint64_t n_allocations = alloc_probe::get_n_allocations();
+    for (int i = 0; i < N_FRAMES; ++i) n_found += run_frame(N_WARM_UP_FRAMES + i);
+    n_allocations = alloc_probe::get_n_allocations() - n_allocations;
+
+    if (n_allocations != 0) {
+        std::fprintf(stderr, "%d heap allocations in %d frames\n", (int)n_allocations, N_FRAMES);
+    }
+    CHECK(n_allocations == 0);
+    CHECK(n_found > 0);
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+    check_probe();
+
+    frame_arena::load(ARENA_N_BYTES);
+    jobs::load(N_WORKERS);
+    system::transform::load();
+    system::spatial::load();
+    load_world();
+
+    check_arena();
+    check_steady_state_frames();
+
+    jobs::unload();
+    globals::registry.clear();
+    frame_arena::unload();
+
+    return report_checks("frame_alloc");
+}
@@ -0,0 +1,183 @@
+// Job system checks, built and run by "make test" from the repository root.
+// Every check runs inline (before jobs::load()), in the single-threaded mode
+// and with several workers. Doesn't open a window, so it works headless.
+
+#include "check.hpp"
+#include "core/jobs.hpp"
+#include "component/component.hpp"
+#include "globals.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace soft_tissues;
+
+static constexpr int N_WORKERS = 4;
+
+// -----------------------------------------------------------------------
+// checks
+
+static void check_parallel_for_sum() {
+    static constexpr int n = 1000000;
+
+    std::vector<int> values(n);
+    for (int i = 0; i < n; ++i) values[i] = i;
+
+    std::atomic<long long> sum = 0;
+    jobs::parallel_for(0, n, 1000, [&](int begin, int end) {
+        long long chunk_sum = 0;
+        for (int i = begin; i < end; ++i) chunk_sum += values[i];
+        sum.fetch_add(chunk_sum);
+    });
+
+    CHECK(sum.load() == (long long)n * (n - 1) / 2);
+}
+
+static void check_nested_fork_join() {
+    static constexpr int n = 64;
+
+    std::atomic<int> n_calls = 0;
+    jobs::parallel_for(0, n, 1, [&](int, int) {
+        jobs::parallel_for(0, n, 1, [&](int, int) { n_calls.fetch_add(1); });
+    });
+
+    CHECK(n_calls.load() == n * n);
+}
+
+static void check_exception_rethrow() {
+    bool is_thrown = false;
+    try {
+        jobs::parallel_for(0, 100, 1, [](int begin, int) {
+            if (begin == 37) throw std::runtime_error("job failed");
+        });
+    } catch (const std::runtime_error &e) {
+        is_thrown = std::string(e.what()) == "job failed";
+    }
+
+    CHECK(is_thrown);
+}
+
+// Without the workers the jobs run at the moment they are submitted
+static void check_single_threaded_order() {
+    std::vector<int> order;
+    jobs::Group group;
+    for (int i = 0; i < 10; ++i) {
+        jobs::run(group, [&order, i]() { order.push_back(i); });
+    }
+    jobs::wait(group);
+
+    CHECK(order.size() == 10);
+    for (int i = 0; i < (int)order.size(); ++i) CHECK(order[i] == i);
+}
+
+static void check_background_jobs() {
+    auto value = jobs::submit_background([]() { return 42; });
+    auto error = jobs::submit_background([]() -> int {
+        throw std::runtime_error("background job failed");
+    });
+
+    CHECK(value.get() == 42);
+
+    bool is_thrown = false;
+    try {
+        error.get();
+    } catch (const std::runtime_error &) {
+        is_thrown = true;
+    }
+    CHECK(is_thrown);
+}
+
+static void check_jobs() {
+    check_parallel_for_sum();
+    check_nested_fork_join();
+    check_exception_rethrow();
+    check_background_jobs();
+}
+
+// -----------------------------------------------------------------------
+// transforms
+// A random hierarchy moved over several updates, the world positions must be
+// exactly the same whichever way the update is split between the workers
+
+static std::vector<Vector3> get_moved_world_positions() {
+    auto &registry = globals::registry;
+    registry.clear();
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.0, 1.0);
+    auto get_transform = [&]() {
+        Vector3 position = {u(rng), u(rng), u(rng)};
+        Quaternion rotation = QuaternionFromEuler(u(rng), u(rng), u(rng));
+        return component::Transform(position, Vector3One(), rotation);
+    };
+
+    std::vector<entt::entity> entities;
+    std::vector<entt::entity> roots;
+    for (int i = 0; i < 500; ++i) {
+        auto root = registry.create();
+        registry.emplace<component::Transform>(root, get_transform());
+        roots.push_back(root);
+        entities.push_back(root);
+
+        auto parent = root;
+        for (int k = 0; k < 20; ++k) {
+            auto entity = registry.create();
+            registry.emplace<component::Transform>(entity, get_transform());
+            registry.emplace<component::Parent>(entity, component::Parent{parent});
+            entities.push_back(entity);
+            if (k % 3 == 0) parent = entity;
+        }
+    }
+
+    system::transform::update();
+    for (int i = 0; i < 10; ++i) {
+        for (auto root : roots) system::transform::step(root, {0.001, 0.0, 0.0});
+        system::transform::update();
+    }
+
+    std::vector<Vector3> positions;
+    for (auto entity : entities) {
+        Matrix matrix = system::transform::get_world_matrix(entity);
+        positions.push_back({matrix.m12, matrix.m13, matrix.m14});
+    }
+
+    registry.clear();
+    return positions;
+}
+
+static bool is_equal(const std::vector<Vector3> &a, const std::vector<Vector3> &b) {
+    if (a.size() != b.size()) return false;
+
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z) return false;
+    }
+
+    return true;
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+    system::transform::load();
+
+    check_jobs();
+    check_single_threaded_order();
+    auto inline_positions = get_moved_world_positions();
+
+    jobs::load(0);
+    check_jobs();
+    check_single_threaded_order();
+    CHECK(is_equal(get_moved_world_positions(), inline_positions));
+    jobs::unload();
+
+    jobs::load(N_WORKERS);
+    for (int i = 0; i < 20; ++i) check_jobs();
+    CHECK(is_equal(get_moved_world_positions(), inline_positions));
+    jobs::unload();
+
+    return report_checks("jobs");
+}
@@ -0,0 +1,227 @@
+// Light buffer checks, built and run by "make test" from the repository root.
+// The GL buffer entry points are replaced by stubs which copy the uploads
+// into a CPU mirror of the buffer. After each change the mirror must hold the
+// lights which are on, and only the changed slots may be uploaded: all of
+// them at first and after a layout change, none on the idle frames, just the
+// patched or moved ones otherwise. Doesn't open a window, so it works headless.
+
+#include "check.hpp"
+#include "component/component.hpp"
+#include "core/gl.hpp"
+#include "globals.hpp"
+#include "system/lighting.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <cstring>
+#include <vector>
+
+using namespace soft_tissues;
+
+// std140 layout of the Lights block in pbr.frag.glsl
+static constexpr long LIGHTS_OFFSET = 16;
+static constexpr long LIGHT_SIZE = 144;
+static constexpr long COLOR_OFFSET = 32;
+
+// -----------------------------------------------------------------------
+// gl stubs
+
+struct Upload {
+    long offset;
+    long size;
+};
+
+static std::vector<char> GPU_BUFFER;
+static std::vector<Upload> UPLOADS;
+
+static void gen_buffers(gl::GLsizei n, gl::GLuint *buffers) {
+    for (int i = 0; i < n; ++i) buffers[i] = i + 1;
+}
+
+static void delete_buffers(gl::GLsizei, const gl::GLuint *) {}
+
+static void bind_buffer(gl::GLenum, gl::GLuint) {}
+
+static void bind_buffer_base(gl::GLenum, gl::GLuint, gl::GLuint) {}
+
+static void buffer_data(gl::GLenum, gl::GLsizeiptr size, const void *, gl::GLenum) {
+    GPU_BUFFER.assign(size, 0);
+}
+
+static void buffer_sub_data(
+    gl::GLenum, gl::GLintptr offset, gl::GLsizeiptr size, const void *data
+) {
+    CHECK(offset >= 0 && offset + size <= (long)GPU_BUFFER.size());
+    std::memcpy(GPU_BUFFER.data() + offset, data, size);
+    UPLOADS.push_back({offset, size});
+}
+
+static void load_gl_stubs() {
+    gl::GenBuffers = &gen_buffers;
+    gl::DeleteBuffers = &delete_buffers;
+    gl::BindBuffer = &bind_buffer;
+    gl::BindBufferBase = &bind_buffer_base;
+    gl::BufferData = &buffer_data;
+    gl::BufferSubData = &buffer_sub_data;
+}
+
+// -----------------------------------------------------------------------
+// lights
+
+static entt::entity create_light(Vector3 position, component::LightType type, Color color) {
+    auto &registry = globals::registry;
+
+    component::LightParams params = component::PointParams{{1.0, 0.1, 0.01}};
+    if (type == component::LightType::SPOT) {
+        params = component::SpotParams{{1.0, 0.1, 0.01}, 0.9, 0.8};
+    }
+
+    auto entity = registry.create();
+    registry.emplace<component::Transform>(entity, component::Transform(position));
+    registry.emplace<component::Light>(entity, type, color, 1.0, params);
+
+    return entity;
+}
+
+// Returns the uploads of the frame's light update
+static const std::vector<Upload> &update() {
+    UPLOADS.clear();
+    system::transform::update();
+    system::lighting::update();
+
+    return UPLOADS;
+}
+
+static bool is_close(Vector3 a, Vector3 b) {
+    return Vector3Distance(a, b) <= 1e-5;
+}
+
+static Vector3 read_vector3(long offset) {
+    Vector3 v;
+    std::memcpy(&v, GPU_BUFFER.data() + offset, sizeof(v));
+    return v;
+}
+
+// The mirror must hold exactly the lights which are on, in any slot order
+static bool is_mirror_up_to_date() {
+    const auto &registry = globals::registry;
+
+    int n_lights;
+    std::memcpy(&n_lights, GPU_BUFFER.data(), sizeof(n_lights));
+
+    int n_expected_lights = 0;
+    for (auto entity : registry.view<component::Light>()) {
+        const auto &light = registry.get<component::Light>(entity);
+        if (!light.is_on) continue;
+        n_expected_lights += 1;
+
+        Vector4 color = ColorNormalize(light.color);
+        Vector3 rgb = {color.x, color.y, color.z};
+        Vector3 position = system::transform::get_world_position(entity);
+
+        bool is_found = false;
+        for (int slot = 0; slot < n_lights; ++slot) {
+            long offset = LIGHTS_OFFSET + slot * LIGHT_SIZE;
+            if (is_close(read_vector3(offset), position)
+                && is_close(read_vector3(offset + COLOR_OFFSET), rgb)) {
+                is_found = true;
+            }
+        }
+        if (!is_found) return false;
+    }
+
+    return n_lights == n_expected_lights && n_lights == system::lighting::get_n_lights();
+}
+
+// A single upload of the slots only
+static bool is_slots_upload(const std::vector<Upload> &uploads, int n_slots) {
+    return uploads.size() == 1 && uploads[0].offset >= LIGHTS_OFFSET
+           && uploads[0].size == n_slots * LIGHT_SIZE;
+}
+
+// A single upload of the header and all the slots
+static bool is_layout_upload(const std::vector<Upload> &uploads, int n_lights) {
+    return uploads.size() == 1 && uploads[0].offset == 0
+           && uploads[0].size == LIGHTS_OFFSET + n_lights * LIGHT_SIZE;
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+static void check_patching() {
+    auto &registry = globals::registry;
+
+    auto point = create_light({1.0, 2.0, 3.0}, component::LightType::POINT, RED);
+    auto spot = create_light({-4.0, 2.0, 0.0}, component::LightType::SPOT, GREEN);
+
+    // the flashlight on the player, moved by its parent
+    auto player = registry.create();
+    registry.emplace<component::Transform>(player, component::Transform({0.0, 1.0, 0.0}));
+    auto flashlight = create_light({0.0, 0.5, 0.0}, component::LightType::SPOT, WHITE);
+    registry.emplace<component::Parent>(flashlight, component::Parent{player});
+
+    // the first upload covers all lights
+    CHECK(is_layout_upload(update(), 3));
+    CHECK(system::lighting::get_n_patched_lights() == 3);
+    CHECK(is_mirror_up_to_date());
+
+    // idle frames upload nothing
+    for (int i = 0; i < 3; ++i) {
+        CHECK(update().empty());
+        CHECK(system::lighting::get_n_patched_lights() == 0);
+    }
+
+    // a move uploads just that slot
+    system::transform::step(point, {0.5, 0.0, 0.0});
+    CHECK(is_slots_upload(update(), 1));
+    CHECK(is_mirror_up_to_date());
+
+    // so does the move of a parent
+    system::transform::step(player, {0.0, 0.0, 2.0});
+    CHECK(is_slots_upload(update(), 1));
+    CHECK(system::lighting::get_n_patched_lights() == 1);
+    CHECK(is_mirror_up_to_date());
+
+    // and a light patched through the registry
+    registry.patch<component::Light>(spot, [](auto &light) { light.color = BLUE; });
+    CHECK(is_slots_upload(update(), 1));
+    CHECK(is_mirror_up_to_date());
+
+    // changes of several slots go in a single upload
+    system::transform::step(point, {0.0, 0.5, 0.0});
+    system::transform::step(player, {0.0, 0.0, 1.0});
+    const auto &uploads = update();
+    CHECK(uploads.size() == 1);
+    CHECK(system::lighting::get_n_patched_lights() == 2);
+    CHECK(is_mirror_up_to_date());
+    CHECK(update().empty());
+
+    // a light switched off or destroyed repacks the layout
+    registry.patch<component::Light>(point, [](auto &light) { light.is_on = false; });
+    CHECK(is_layout_upload(update(), 2));
+    CHECK(is_mirror_up_to_date());
+
+    registry.destroy(spot);
+    CHECK(is_layout_upload(update(), 1));
+    CHECK(is_mirror_up_to_date());
+
+    registry.patch<component::Light>(point, [](auto &light) { light.is_on = true; });
+    CHECK(is_layout_upload(update(), 2));
+    CHECK(is_mirror_up_to_date());
+    CHECK(update().empty());
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+    load_gl_stubs();
+
+    system::transform::load();
+    system::lighting::load();
+
+    check_patching();
+
+    globals::registry.clear();
+    system::lighting::unload();
+
+    return report_checks("lighting");
+}
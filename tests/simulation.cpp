@@ -0,0 +1,139 @@
+// Fixed step simulation checks, built and run by "make test" from the
+// repository root. Covers the step count and the interpolation factor, the
+// dropped backlog after a stall, the interpolated Transform and the adoption
+// of a Transform moved outside of the simulation. Runs in the editor state,
+// so the steps don't read the keyboard, and the moves of a step are written
+// into the SimulatedPosition directly. Doesn't open a window, so it works
+// headless.
+
+#include "check.hpp"
+#include "component/component.hpp"
+#include "gameplay_config.hpp"
+#include "globals.hpp"
+#include "system/simulation.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <cmath>
+
+using namespace soft_tissues;
+
+// a power of two, so the sums of the frame times below are exact
+static constexpr float RATE = 64.0;
+static constexpr float DT = 1.0 / RATE;
+
+static bool is_close(float a, float b) {
+    return std::abs(a - b) <= 1e-5;
+}
+
+static bool is_close(Vector3 a, Vector3 b) {
+    return Vector3Distance(a, b) <= 1e-5;
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+static void check_steps() {
+    system::simulation::update(0.25 * DT);
+    CHECK(system::simulation::get_n_steps() == 0);
+    CHECK(is_close(system::simulation::get_alpha(), 0.25));
+
+    system::simulation::update(0.5 * DT);
+    CHECK(system::simulation::get_n_steps() == 0);
+    CHECK(is_close(system::simulation::get_alpha(), 0.75));
+
+    // the leftover carries over to the next frame
+    system::simulation::update(2.5 * DT);
+    CHECK(system::simulation::get_n_steps() == 3);
+    CHECK(is_close(system::simulation::get_alpha(), 0.25));
+
+    system::simulation::update(0.75 * DT);
+    CHECK(system::simulation::get_n_steps() == 1);
+    CHECK(is_close(system::simulation::get_alpha(), 0.0));
+}
+
+static void check_dropped_backlog() {
+    // a stall: only the maximum number of steps run, the rest is dropped
+    // except for the fraction of a step
+    system::simulation::update(100.25 * DT);
+    CHECK(system::simulation::get_n_steps() == gameplay_config::MAX_N_SIMULATION_STEPS);
+    CHECK(is_close(system::simulation::get_alpha(), 0.25));
+
+    system::simulation::update(0.5 * DT);
+    CHECK(system::simulation::get_n_steps() == 0);
+    CHECK(is_close(system::simulation::get_alpha(), 0.75));
+
+    system::simulation::update(0.25 * DT);
+    CHECK(system::simulation::get_n_steps() == 1);
+}
+
+static void check_interpolation(entt::entity player) {
+    auto &registry = globals::registry;
+
+    // the last step moved the player from a to b
+    Vector3 a = {1.0, 0.0, 0.0};
+    Vector3 b = {2.0, 0.0, 4.0};
+    auto &sp = registry.get<component::SimulatedPosition>(player);
+    sp.prev_position = a;
+    sp.position = b;
+
+    system::simulation::update(0.25 * DT);
+    CHECK(system::simulation::get_n_steps() == 0);
+    CHECK(is_close(registry.get<component::Transform>(player).position, Vector3Lerp(a, b, 0.25)));
+    CHECK(is_close(system::transform::get_world_position(player), Vector3Lerp(a, b, 0.25)));
+
+    system::simulation::update(0.5 * DT);
+    CHECK(is_close(registry.get<component::Transform>(player).position, Vector3Lerp(a, b, 0.75)));
+
+    // the next step starts from b, the player doesn't move without input
+    system::simulation::update(0.25 * DT);
+    CHECK(system::simulation::get_n_steps() == 1);
+    CHECK(is_close(registry.get<component::Transform>(player).position, b));
+    CHECK(is_close(sp.prev_position, b));
+}
+
+static void check_teleport_adoption(entt::entity player) {
+    auto &registry = globals::registry;
+
+    // moved by the editor gizmo while the simulation is between a and b
+    auto &sp = registry.get<component::SimulatedPosition>(player);
+    sp.prev_position = {0.0, 0.0, 0.0};
+    sp.position = {1.0, 0.0, 0.0};
+    system::simulation::update(0.5 * DT);
+
+    Vector3 teleport = {-5.0, 1.0, 3.0};
+    registry.patch<component::Transform>(player, [&](auto &tr) { tr.position = teleport; });
+    system::transform::mark_dirty(player);
+
+    // adopted at once, without interpolating towards it
+    system::simulation::update(0.25 * DT);
+    CHECK(system::simulation::get_n_steps() == 0);
+    CHECK(is_close(registry.get<component::Transform>(player).position, teleport));
+    CHECK(is_close(sp.prev_position, teleport));
+    CHECK(is_close(sp.position, teleport));
+    CHECK(is_close(sp.rendered_position, teleport));
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+    globals::GAME_STATE = globals::GameState::EDITOR;
+
+    system::transform::load();
+    system::simulation::load();
+    system::simulation::set_rate(RATE);
+
+    auto &registry = globals::registry;
+    auto player = registry.create();
+    registry.emplace<component::Transform>(player, component::Transform(Vector3Zero()));
+    registry.emplace<component::Player>(player);
+    CHECK(registry.all_of<component::SimulatedPosition>(player));
+
+    check_steps();
+    check_dropped_backlog();
+    check_interpolation(player);
+    check_teleport_adoption(player);
+
+    registry.clear();
+
+    return report_checks("simulation");
+}
@@ -0,0 +1,217 @@
+// Spatial index checks, built and run by "make test" from the repository root.
+// Random entities are moved, destroyed and created over many updates, and
+// after each update the aabb, sphere, frustum and ray queries must find
+// exactly the entities a brute-force test of every entity finds. Half of the
+// entities and of the query shapes lie beyond the tile grid. The entities
+// have no MyMesh, which needs the GPU resources, so their bounds are points.
+// The sphere culling of the draw lists is checked against sampled points.
+// Doesn't open a window, so it works headless.
+
+#include "check.hpp"
+#include "component/component.hpp"
+#include "core/frame_arena.hpp"
+#include "core/world.hpp"
+#include "globals.hpp"
+#include "system/spatial.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace soft_tissues;
+
+static constexpr int N_ENTITIES = 1500;
+static constexpr int N_UPDATES = 200;
+static constexpr int N_QUERIES_PER_UPDATE = 10;
+// the grid spans [-8, 8], the entities and the queries go 3 times as far
+static constexpr float SPAN = 24.0;
+
+static std::mt19937 RNG(0);
+
+static float get_random(float min, float max) {
+    return std::uniform_real_distribution<float>(min, max)(RNG);
+}
+
+static Vector3 get_random_position() {
+    return {get_random(-SPAN, SPAN), get_random(-1.0, 4.0), get_random(-SPAN, SPAN)};
+}
+
+// -----------------------------------------------------------------------
+// entities
+
+static std::vector<entt::entity> ENTITIES;
+
+static void create_entity() {
+    auto &registry = globals::registry;
+
+    auto entity = registry.create();
+    registry.emplace<component::Transform>(entity, component::Transform(get_random_position()));
+    ENTITIES.push_back(entity);
+}
+
+static void change_entities() {
+    auto &registry = globals::registry;
+
+    for (int i = 0; i < 30; ++i) {
+        auto entity = ENTITIES[RNG() % ENTITIES.size()];
+        Vector3 position = system::transform::get_world_position(entity);
+        system::transform::step(entity, Vector3Subtract(get_random_position(), position));
+    }
+
+    for (int i = 0; i < 10; ++i) {
+        int idx = RNG() % ENTITIES.size();
+        registry.destroy(ENTITIES[idx]);
+        ENTITIES[idx] = ENTITIES.back();
+        ENTITIES.pop_back();
+    }
+
+    for (int i = 0; i < 10; ++i) create_entity();
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+using Predicate = std::function<bool(BoundingBox)>;
+
+// The found entities must be the ones whose bounds pass the predicate, once
+static bool is_brute_force_equal(
+    frame_arena::Vector<entt::entity> &found, const Predicate &predicate
+) {
+    std::vector<entt::entity> expected;
+    for (auto entity : ENTITIES) {
+        Vector3 position = system::transform::get_world_position(entity);
+        if (predicate({position, position})) expected.push_back(entity);
+    }
+
+    std::sort(found.begin(), found.end());
+    std::sort(expected.begin(), expected.end());
+    bool is_equal = std::equal(found.begin(), found.end(), expected.begin(), expected.end());
+
+    found.clear();
+    return is_equal;
+}
+
+// View projection of a perspective or an orthographic camera
+static Matrix get_view_projection(Vector3 position, Vector3 target, bool is_perspective) {
+    Camera3D camera = {position, target, {0.0, 1.0, 0.0}, 60.0, CAMERA_PERSPECTIVE};
+    Matrix projection = is_perspective ? MatrixPerspective(60.0 * DEG2RAD, 1.0, 0.05, 20.0)
+                                       : MatrixOrtho(-8.0, 8.0, -8.0, 8.0, 0.05, 20.0);
+
+    return MatrixMultiply(GetCameraMatrix(camera), projection);
+}
+
+// Whether the point is inside the clip space box of the view projection
+static bool is_point_visible(Matrix vp, Vector3 p) {
+    float x = vp.m0 * p.x + vp.m4 * p.y + vp.m8 * p.z + vp.m12;
+    float y = vp.m1 * p.x + vp.m5 * p.y + vp.m9 * p.z + vp.m13;
+    float z = vp.m2 * p.x + vp.m6 * p.y + vp.m10 * p.z + vp.m14;
+    float w = vp.m3 * p.x + vp.m7 * p.y + vp.m11 * p.z + vp.m15;
+
+    return std::abs(x) <= w && std::abs(y) <= w && std::abs(z) <= w;
+}
+
+static void check_queries() {
+    frame_arena::Vector<entt::entity> found;
+    Vector3 center = get_random_position();
+
+    Vector3 extent = {get_random(0.0, 6.0), get_random(0.0, 3.0), get_random(0.0, 6.0)};
+    BoundingBox box = {Vector3Subtract(center, extent), Vector3Add(center, extent)};
+    system::spatial::query_aabb(box, found);
+    CHECK(is_brute_force_equal(found, [&](BoundingBox bounds) {
+        return CheckCollisionBoxes(bounds, box);
+    }));
+
+    float radius = get_random(0.0, 6.0);
+    system::spatial::query_sphere(center, radius, found);
+    CHECK(is_brute_force_equal(found, [&](BoundingBox bounds) {
+        return CheckCollisionBoxSphere(bounds, center, radius);
+    }));
+
+    Matrix vp = get_view_projection(center, get_random_position(), RNG() % 2 == 0);
+    auto frustum = system::spatial::get_frustum(vp);
+    system::spatial::query_frustum(frustum, found);
+    CHECK(is_brute_force_equal(found, [&](BoundingBox bounds) {
+        return system::spatial::is_box_visible(frustum, bounds);
+    }));
+
+    // aimed at an entity, so the points are hit now and then, from anywhere
+    // in the world, in any direction, up to beyond the entity or short of it
+    Vector3 target = system::transform::get_world_position(ENTITIES[RNG() % ENTITIES.size()]);
+    Vector3 to_target = Vector3Subtract(target, center);
+    Ray ray = {center, Vector3Normalize(to_target)};
+    float max_dist = Vector3Length(to_target) * get_random(0.5, 2.0);
+    system::spatial::query_ray(ray, max_dist, found);
+    CHECK(is_brute_force_equal(found, [&](BoundingBox bounds) {
+        auto collision = GetRayCollisionBox(ray, bounds);
+        return collision.hit && collision.distance <= max_dist;
+    }));
+}
+
+static void check_random_updates() {
+    for (int i = 0; i < N_ENTITIES; ++i) create_entity();
+
+    for (int i = 0; i < N_UPDATES; ++i) {
+        change_entities();
+        system::transform::update();
+        system::spatial::update();
+
+        CHECK(system::spatial::get_n_entities() == (int)ENTITIES.size());
+        for (int k = 0; k < N_QUERIES_PER_UPDATE; ++k) check_queries();
+        frame_arena::reset();
+    }
+}
+
+// The draw lists cull the bounding spheres: a sphere with any of its points
+// inside the clip space box is never culled, and the one entirely behind the
+// camera always is
+static void check_sphere_culling() {
+    int n_visible = 0;
+    for (int i = 0; i < 2000; ++i) {
+        Vector3 camera_pos = get_random_position();
+        Vector3 target = get_random_position();
+        Matrix vp = get_view_projection(camera_pos, target, i % 2 == 0);
+        auto frustum = system::spatial::get_frustum(vp);
+
+        Vector3 center = Vector3Add(camera_pos, Vector3Scale(get_random_position(), 0.5));
+        float radius = get_random(0.0, 3.0);
+        bool is_visible = system::spatial::is_sphere_visible(frustum, center, radius);
+
+        bool is_any_point_visible = false;
+        for (int k = 0; k < 200; ++k) {
+            Vector3 direction = Vector3Normalize(get_random_position());
+            float dist = radius * get_random(0.0, 1.0);
+            Vector3 point = k == 0 ? center : Vector3Add(center, Vector3Scale(direction, dist));
+            is_any_point_visible = is_any_point_visible || is_point_visible(vp, point);
+        }
+        CHECK(is_visible || !is_any_point_visible);
+        n_visible += is_visible;
+
+        Vector3 forward = Vector3Normalize(Vector3Subtract(target, camera_pos));
+        Vector3 behind = Vector3Subtract(camera_pos, Vector3Scale(forward, radius + 0.01f));
+        CHECK(!system::spatial::is_sphere_visible(frustum, behind, radius));
+    }
+
+    // neither outcome is vacuous
+    CHECK(n_visible > 0 && n_visible < 2000);
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+
+    frame_arena::load(1 << 20);
+    world::reset();
+    system::transform::load();
+    system::spatial::load();
+
+    check_random_updates();
+    check_sphere_culling();
+
+    globals::registry.clear();
+    frame_arena::unload();
+
+    return report_checks("spatial");
+}
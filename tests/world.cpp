@@ -0,0 +1,150 @@
+// Room query checks, built and run by "make test" from the repository root.
+// Rooms are built, edited and removed, and after each change the room views
+// must match the tiles added to the rooms. The queries are views over the
+// world storage, so walking them must not allocate. The tests are built with
+// the allocation probe, see core/alloc_probe.hpp.
+
+#include "check.hpp"
+#include "core/alloc_probe.hpp"
+#include "core/world.hpp"
+#include "raylib/raylib.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+using namespace soft_tissues;
+
+using ExpectedRooms = std::map<int, std::vector<tile::Tile *>>;
+
+static ExpectedRooms EXPECTED_ROOMS;
+
+// Adds the rectangle of tiles to a new room
+static int add_room(int row_0, int col_0, int n_rows, int n_cols) {
+    int room_id = world::add_room();
+    auto &tiles = EXPECTED_ROOMS[room_id];
+
+    for (int row = row_0; row < row_0 + n_rows; ++row) {
+        for (int col = col_0; col < col_0 + n_cols; ++col) {
+            auto *tile = world::get_tile_at_row_col(row, col);
+            world::add_tile_to_room(tile, room_id);
+            tiles.push_back(tile);
+        }
+    }
+
+    return room_id;
+}
+
+static std::vector<tile::Tile *> get_sorted(std::vector<tile::Tile *> tiles) {
+    std::sort(tiles.begin(), tiles.end());
+    return tiles;
+}
+
+// -----------------------------------------------------------------------
+// checks
+
+// The views must hold exactly the expected rooms and tiles, in any order
+static void check_rooms() {
+    std::vector<int> room_ids;
+    for (int room_id : world::get_room_ids()) room_ids.push_back(room_id);
+    std::sort(room_ids.begin(), room_ids.end());
+
+    std::vector<int> expected_room_ids;
+    std::vector<tile::Tile *> expected_all_tiles;
+    for (const auto &[room_id, tiles] : EXPECTED_ROOMS) {
+        expected_room_ids.push_back(room_id);
+        expected_all_tiles.insert(expected_all_tiles.end(), tiles.begin(), tiles.end());
+
+        auto room_tiles = world::get_room_tiles(room_id);
+        std::vector<tile::Tile *> found(room_tiles.begin(), room_tiles.end());
+        CHECK(get_sorted(found) == get_sorted(tiles));
+
+        for (auto *tile : tiles) CHECK(world::get_tile_room_id(tile) == room_id);
+    }
+    CHECK(room_ids == expected_room_ids);
+
+    std::vector<tile::Tile *> all_tiles;
+    for (auto *tile : world::get_all_rooms_tiles()) all_tiles.push_back(tile);
+    CHECK(get_sorted(all_tiles) == get_sorted(expected_all_tiles));
+
+    const auto &tile_room_ids = world::get_tiles_with_room_ids();
+    CHECK(tile_room_ids.size() == expected_all_tiles.size());
+    for (const auto &[tile, room_id] : tile_room_ids) {
+        CHECK(EXPECTED_ROOMS.count(room_id) == 1);
+        const auto &tiles = EXPECTED_ROOMS[room_id];
+        CHECK(std::find(tiles.begin(), tiles.end(), tile) != tiles.end());
+    }
+
+    CHECK(world::get_room_tiles(-1).empty());
+    CHECK(world::get_room_tiles(1000).empty());
+}
+
+// Walks every view, returns a value depending on all of them, so none of the
+// walks is optimized out
+static uint64_t walk_rooms() {
+    uint64_t sum = 0;
+
+    for (auto &tile : world::get_tiles()) sum += tile.id;
+    for (int room_id : world::get_room_ids()) {
+        for (auto *tile : world::get_room_tiles(room_id)) sum += tile->id + room_id;
+    }
+    for (auto *tile : world::get_all_rooms_tiles()) sum += tile->id;
+    for (const auto &[tile, room_id] : world::get_tiles_with_room_ids()) sum += room_id;
+    sum += world::get_room_tiles(1000).size();
+
+    return sum;
+}
+
+static void check_no_allocations() {
+    CHECK(alloc_probe::is_enabled());
+
+    uint64_t n_allocations = alloc_probe::get_n_allocations();
+    uint64_t sum = 0;
+    for (int i = 0; i < 100; ++i) sum += walk_rooms();
+    n_allocations = alloc_probe::get_n_allocations() - n_allocations;
+
+    CHECK(n_allocations == 0);
+    CHECK(sum > 0);
+}
+
+static void check_edits() {
+    world::reset();
+    EXPECTED_ROOMS.clear();
+    check_rooms();
+
+    int room_0 = add_room(0, 0, 3, 4);
+    int room_1 = add_room(5, 5, 2, 2);
+    int room_2 = add_room(10, 0, 1, 6);
+    check_rooms();
+    check_no_allocations();
+
+    // a cleared tile leaves its room, the room stays
+    auto *tile = world::get_tile_at_row_col(1, 1);
+    world::clear_tile(tile);
+    auto &tiles = EXPECTED_ROOMS[room_0];
+    tiles.erase(std::find(tiles.begin(), tiles.end(), tile));
+    check_rooms();
+    CHECK(world::get_tile_room_id(tile) == -1);
+
+    world::remove_room(room_1);
+    EXPECTED_ROOMS.erase(room_1);
+    check_rooms();
+
+    add_room(14, 14, 2, 2);
+    check_rooms();
+    check_no_allocations();
+
+    world::remove_room(room_2);
+    EXPECTED_ROOMS.erase(room_2);
+    check_rooms();
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+
+    check_edits();
+
+    world::reset();
+
+    return report_checks("world");
+}
@@ -0,0 +1,181 @@
+// Offline asset cooker, built and run by "make cook" from the repository root.
+// Cooks the materials listed in the manifest into the cache directory used by
+// the game, skipping the ones which sources didn't change since the last run.
+// With "--pack <file>" ("make pack") it also packs the cooked materials, shaders
+// and worlds into a single asset pack. Doesn't open a window, so it works headless.
+
+#include "core/cook.hpp"
+#include "core/jobs.hpp"
+#include "core/pack.hpp"
+#include "core/pbr.hpp"
+#include "core/world_serializer.hpp"
+#include "raylib/raylib.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace soft_tissues;
+
+static const std::string MATERIAL_MANIFEST_FILE_PATH = "resources/pbr/manifest.json";
+
+struct CookResult {
+    std::string key;
+    cook::CookedMaterial cooked;
+    bool is_cooked;
+    bool is_ok;
+};
+
+static CookResult cook_material(const pbr::MaterialDesc &desc) {
+    uint64_t hash = cook::get_material_hash(desc);
+    auto file_path = cook::get_material_file_path(hash);
+
+    if (std::filesystem::exists(file_path)) {
+        return {desc.key, {file_path, hash}, false, true};
+    }
+
+    pbr::MaterialImages images = pbr::load_material_images(desc);
+    bool is_ok = cook::save_material_images(file_path, images);
+    images.unload();
+
+    return {desc.key, {file_path, hash}, true, is_ok};
+}
+
+// Removes the cooked files which are not referenced by the index anymore
+static void remove_stale_files(const std::unordered_map<std::string, cook::CookedMaterial> &index) {
+    std::unordered_set<std::string> file_paths;
+    for (const auto &[_, cooked] : index) {
+        file_paths.insert(std::filesystem::path(cooked.file_path).lexically_normal().string());
+    }
+
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator(cook::CACHE_DIR_PATH, ec)) {
+        auto file_path = entry.path().lexically_normal().string();
+        if (entry.path().extension() != ".bin" || file_paths.count(file_path) != 0) {
+            continue;
+        }
+
+        std::filesystem::remove(entry.path(), ec);
+        std::printf("removed: %s\n", file_path.c_str());
+    }
+}
+
+static void add_dir_files(
+    std::vector<std::string> &paths, const std::string &dir_path, const std::string &extension
+) {
+    std::vector<std::string> dir_paths;
+    for (const auto &entry : std::filesystem::directory_iterator(dir_path)) {
+        if (entry.path().extension() == extension) {
+            dir_paths.push_back(entry.path().generic_string());
+        }
+    }
+
+    // sorted, so the same assets give the same pack
+    std::sort(dir_paths.begin(), dir_paths.end());
+    paths.insert(paths.end(), dir_paths.begin(), dir_paths.end());
+}
+
+static void write_pack(
+    const std::string &file_path, const std::unordered_map<std::string, cook::CookedMaterial> &index
+) {
+    std::vector<std::string> paths = {MATERIAL_MANIFEST_FILE_PATH, cook::INDEX_FILE_PATH};
+
+    std::vector<std::string> material_paths;
+    for (const auto &[_, cooked] : index) material_paths.push_back(cooked.file_path);
+    std::sort(material_paths.begin(), material_paths.end());
+    paths.insert(paths.end(), material_paths.begin(), material_paths.end());
+
+    add_dir_files(paths, "resources/shaders", ".glsl");
+    add_dir_files(paths, "resources/worlds", ".json");
+    add_dir_files(paths, "resources/worlds", world_serializer::BINARY_EXTENSION);
+
+    pack::write(file_path, paths);
+
+    // read the pack back, the way the game does
+    pack::mount(file_path);
+    int n_corrupted = pack::verify();
+    pack::unmount();
+    if (n_corrupted != 0) {
+        throw std::runtime_error("Written pack is corrupted: " + file_path);
+    }
+
+    std::printf(
+        "packed %zu files (%.2f MB): %s\n",
+        paths.size(),
+        std::filesystem::file_size(file_path) / (1024.0 * 1024.0),
+        file_path.c_str()
+    );
+}
+
+int main(int argc, char *argv[]) {
+    SetTraceLogLevel(LOG_WARNING);
+
+    std::string pack_file_path;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--pack" && i + 1 < argc) {
+            pack_file_path = argv[++i];
+        } else {
+            std::fprintf(stderr, "usage: %s [--pack <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        auto start_time = std::chrono::steady_clock::now();
+        auto descs = pbr::load_material_manifest(MATERIAL_MANIFEST_FILE_PATH);
+
+        jobs::load(jobs::get_default_n_workers());
+        std::vector<CookResult> results(descs.size());
+        jobs::parallel_for(0, (int)descs.size(), 1, [&](int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                results[i] = cook_material(descs[i]);
+            }
+        });
+        jobs::unload();
+
+        std::unordered_map<std::string, cook::CookedMaterial> index;
+        int n_cooked = 0;
+        int n_failed = 0;
+        for (const auto &result : results) {
+            if (!result.is_ok) {
+                std::printf("failed: %s\n", result.key.c_str());
+                n_failed += 1;
+                continue;
+            }
+
+            index[result.key] = result.cooked;
+            if (result.is_cooked) {
+                std::printf(
+                    "cooked: %s -> %s\n", result.key.c_str(), result.cooked.file_path.c_str()
+                );
+                n_cooked += 1;
+            }
+        }
+
+        cook::save_index(index);
+        remove_stale_files(index);
+        if (!pack_file_path.empty() && n_failed == 0) write_pack(pack_file_path, index);
+
+        std::printf(
+            "%d materials cooked, %d up to date, %d failed in %.2f s\n",
+            n_cooked,
+            (int)index.size() - n_cooked,
+            n_failed,
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count()
+        );
+
+        return n_failed == 0 ? 0 : 1;
+    } catch (const std::exception &e) {
+        jobs::unload();
+        std::fprintf(stderr, "cook: %s\n", e.what());
+        return 1;
+    }
+}
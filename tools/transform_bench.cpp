@@ -0,0 +1,188 @@
+// Transform update benchmark, built and run by "make bench" from the
+// repository root. Times the sorted linear update of system::transform against
+// the recursive getters it replaced (each entity walks up its parents) on the
+// wide, deep and mixed hierarchies, with all roots moved before each update.
+// The update is timed single-threaded and with the default worker pool, the
+// updated world matrices must match the recursive definition.
+// Doesn't open a window, so it works headless.
+
+#include "component/component.hpp"
+#include "core/jobs.hpp"
+#include "globals.hpp"
+#include "system/transform.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace soft_tissues;
+
+static constexpr int N_BENCH_REPEATS = 20;
+static constexpr float MAX_ERROR = 1e-4;
+
+struct Hierarchy {
+    const char *name;
+    int n_roots;
+    // chain of descendants under each root
+    int depth;
+    // direct children of each root
+    int n_children;
+};
+
+static const Hierarchy HIERARCHIES[] = {
+    {"wide", 20000, 0, 1},
+    {"deep", 20, 999, 0},
+    {"mixed", 1000, 10, 10},
+};
+
+// -----------------------------------------------------------------------
+// recursive reference
+// The world transform getters before the sorted update
+
+static Vector3 get_reference_position(entt::entity entity) {
+    const auto &reg = globals::registry;
+    const auto &tr = reg.get<component::Transform>(entity);
+    const auto *parent = reg.try_get<component::Parent>(entity);
+    if (parent == nullptr) return tr.position;
+
+    return Vector3Add(get_reference_position(parent->entity), tr.position);
+}
+
+static Quaternion get_reference_quaternion(entt::entity entity) {
+    const auto &reg = globals::registry;
+    const auto &tr = reg.get<component::Transform>(entity);
+    const auto *parent = reg.try_get<component::Parent>(entity);
+    if (parent == nullptr) return tr.rotation;
+
+    return QuaternionMultiply(get_reference_quaternion(parent->entity), tr.rotation);
+}
+
+static Matrix get_reference_matrix(entt::entity entity) {
+    Vector3 pos = get_reference_position(entity);
+    Matrix t = MatrixTranslate(pos.x, pos.y, pos.z);
+    Matrix r = QuaternionToMatrix(get_reference_quaternion(entity));
+
+    return MatrixMultiply(r, t);
+}
+
+// -----------------------------------------------------------------------
+// bench
+
+template <typename F> static double get_ms(F &&f) {
+    auto start_time = std::chrono::steady_clock::now();
+    f();
+    auto end_time = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end_time - start_time).count();
+}
+
+static float get_max_error(Matrix a, Matrix b) {
+    float16 fa = MatrixToFloatV(a);
+    float16 fb = MatrixToFloatV(b);
+
+    float error = 0.0;
+    for (int i = 0; i < 16; ++i) error = std::max(error, std::abs(fa.v[i] - fb.v[i]));
+
+    return error;
+}
+
+// Best time of an update after all roots are moved
+static double get_update_ms(const std::vector<entt::entity> &roots) {
+    double best_ms = 0.0;
+    for (int i = 0; i < N_BENCH_REPEATS; ++i) {
+        for (auto root : roots) system::transform::step(root, {0.001, 0.0, 0.0});
+
+        double ms = get_ms([]() { system::transform::update(); });
+        if (i == 0 || ms < best_ms) best_ms = ms;
+    }
+
+    return best_ms;
+}
+
+// Returns false if the updated matrices differ from the reference ones
+static bool bench(const Hierarchy &hierarchy) {
+    auto &reg = globals::registry;
+    reg.clear();
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.0, 1.0);
+    std::vector<entt::entity> roots;
+    std::vector<entt::entity> entities;
+    auto create = [&](entt::entity parent) {
+        auto entity = reg.create();
+        Vector3 position = {u(rng), u(rng), u(rng)};
+        Quaternion rotation = QuaternionFromEuler(u(rng), u(rng), u(rng));
+        reg.emplace<component::Transform>(
+            entity, component::Transform(position, Vector3One(), rotation)
+        );
+        if (parent != entt::null) {
+            reg.emplace<component::Parent>(entity, component::Parent{parent});
+        }
+        entities.push_back(entity);
+
+        return entity;
+    };
+
+    for (int i = 0; i < hierarchy.n_roots; ++i) {
+        auto root = create(entt::null);
+        roots.push_back(root);
+
+        auto parent = root;
+        for (int k = 0; k < hierarchy.depth; ++k) parent = create(parent);
+        for (int k = 0; k < hierarchy.n_children; ++k) create(root);
+    }
+
+    double rebuild_ms = get_ms([]() { system::transform::update(); });
+
+    jobs::load(0);
+    double single_ms = get_update_ms(roots);
+    jobs::unload();
+
+    jobs::load(jobs::get_default_n_workers());
+    double parallel_ms = get_update_ms(roots);
+    int n_workers = jobs::get_n_workers();
+    jobs::unload();
+
+    float error = 0.0;
+    std::vector<Matrix> matrices;
+    double reference_ms = get_ms([&]() {
+        for (auto entity : entities) matrices.push_back(get_reference_matrix(entity));
+    });
+    for (size_t i = 0; i < entities.size(); ++i) {
+        Matrix matrix = system::transform::get_world_matrix(entities[i]);
+        error = std::max(error, get_max_error(matrix, matrices[i]));
+    }
+
+    std::printf(
+        "%-6s %6zu entities: rebuild %7.2f ms, update %7.3f ms (%d workers %7.3f ms), "
+        "recursive %8.2f ms, max error %g\n",
+        hierarchy.name,
+        entities.size(),
+        rebuild_ms,
+        single_ms,
+        n_workers,
+        parallel_ms,
+        reference_ms,
+        error
+    );
+
+    reg.clear();
+    return error <= MAX_ERROR;
+}
+
+int main() {
+    SetTraceLogLevel(LOG_WARNING);
+    system::transform::load();
+
+    bool is_exact = true;
+    for (const auto &hierarchy : HIERARCHIES) {
+        is_exact = bench(hierarchy) && is_exact;
+    }
+
+    std::printf("world matrices: %s\n", is_exact ? "match the reference" : "MISMATCH");
+    return is_exact ? 0 : 1;
+}
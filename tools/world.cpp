@@ -0,0 +1,164 @@
+// World file tool, built by "make world" from the repository root.
+// "<src> <dst>" converts a world between JSON and the binary format, chosen by
+// the file extensions (".world" is binary). "--bench <n_entities>" times the
+// save and load of both formats on a procedurally generated world of that
+// size and checks that both formats load exactly the same world data.
+// Works on the world data only, so it needs neither a window nor the assets.
+
+#include "core/pbr.hpp"
+#include "core/world.hpp"
+#include "core/world_serializer.hpp"
+#include "component/component.hpp"
+#include "raylib/raylib.h"
+#include "raylib/raymath.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace soft_tissues;
+
+static constexpr int N_BENCH_REPEATS = 5;
+
+static const std::string MATERIAL_MANIFEST_FILE_PATH = "resources/pbr/manifest.json";
+
+// Rooms of tiles over the whole grid, meshes scattered over them, every 8th
+// entity is a light attached to the previous one
+static world_serializer::WorldData generate_world(int n_entities) {
+    std::vector<std::string> material_keys;
+    for (const auto &desc : pbr::load_material_manifest(MATERIAL_MANIFEST_FILE_PATH)) {
+        material_keys.push_back(desc.key);
+    }
+    if (material_keys.empty()) {
+        throw std::runtime_error("No materials in: " + MATERIAL_MANIFEST_FILE_PATH);
+    }
+
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> u(-1.0, 1.0);
+    auto get_material_key = [&]() { return material_keys[rng() % material_keys.size()]; };
+    std::array<tile::TileWall, 4> walls = {
+        tile::TileWall::NONE, tile::TileWall::SOLID, tile::TileWall::DOOR, tile::TileWall::NONE
+    };
+
+    world_serializer::WorldData data;
+
+    int n_tiles = world::get_tiles_count();
+    for (int i = 0; i < n_tiles; ++i) {
+        data.tiles.push_back(
+            {(uint32_t)i,
+             i / 64,
+             walls,
+             {0, 0, 0, 0},
+             get_material_key(),
+             get_material_key(),
+             get_material_key()}
+        );
+    }
+
+    for (int i = 0; i < n_entities; ++i) {
+        uint32_t id = i + 1;
+        data.entities.push_back(id);
+
+        Vector3 position = {100.0f * u(rng), 3.0f * u(rng), 100.0f * u(rng)};
+        Quaternion rotation = QuaternionNormalize({u(rng), u(rng), u(rng), u(rng)});
+        data.transforms.push_back({id, component::Transform(position, Vector3One(), rotation)});
+
+        if (i % 8 != 7) {
+            data.meshes.push_back({id, {"cube", get_material_key(), {0, 0, 0, 0}}});
+            continue;
+        }
+
+        auto light_type = i % 16 == 7 ? component::LightType::SPOT : component::LightType::POINT;
+        component::LightParams params = component::PointParams{{1.0, 0.5, 0.1}};
+        if (light_type == component::LightType::SPOT) {
+            params = component::SpotParams{{1.0, 0.5, 0.1}, 0.95, 0.8};
+        }
+        float intensity = 10.0 * (1.0 + u(rng));
+        data.lights.push_back({id, component::Light(light_type, WHITE, intensity, params)});
+        data.parents.push_back({id, id - 1});
+    }
+    data.players.push_back(1);
+
+    return data;
+}
+
+template <typename F> static double get_ms(F &&f) {
+    double best_ms = 0.0;
+    for (int i = 0; i < N_BENCH_REPEATS; ++i) {
+        auto start_time = std::chrono::steady_clock::now();
+        f();
+        auto end_time = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+        if (i == 0 || ms < best_ms) best_ms = ms;
+    }
+
+    return best_ms;
+}
+
+static int bench(int n_entities) {
+    auto data = generate_world(n_entities);
+
+    std::string json_str;
+    std::vector<unsigned char> bytes;
+    double json_save_ms = get_ms([&]() { json_str = world_serializer::to_json(data).dump(4); });
+    double json_load_ms = get_ms([&]() {
+        world_serializer::from_json(nlohmann::json::parse(json_str));
+    });
+    double binary_save_ms = get_ms([&]() { bytes = world_serializer::to_binary(data); });
+    double binary_load_ms = get_ms([&]() { world_serializer::from_binary(bytes); });
+
+    auto json_data = world_serializer::from_json(nlohmann::json::parse(json_str));
+    auto binary_data = world_serializer::from_binary(bytes);
+    bool is_exact = world_serializer::to_binary(json_data)
+                    == world_serializer::to_binary(binary_data);
+
+    std::printf(
+        "%d tiles, %d entities, encoding and decoding only (best of %d)\n",
+        (int)data.tiles.size(),
+        n_entities,
+        N_BENCH_REPEATS
+    );
+    std::printf(
+        "json:   %10.2f KB, save %8.2f ms, load %8.2f ms\n",
+        json_str.size() / 1024.0,
+        json_save_ms,
+        json_load_ms
+    );
+    std::printf(
+        "binary: %10.2f KB, save %8.2f ms, load %8.2f ms\n",
+        bytes.size() / 1024.0,
+        binary_save_ms,
+        binary_load_ms
+    );
+    std::printf("loaded data: %s\n", is_exact ? "identical" : "MISMATCH");
+
+    return is_exact ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    SetTraceLogLevel(LOG_WARNING);
+
+    try {
+        if (argc == 3 && std::string_view(argv[1]) == "--bench") {
+            return bench(std::stoi(argv[2]));
+        }
+
+        if (argc == 3) {
+            world_serializer::convert(argv[1], argv[2]);
+            std::printf("converted: %s -> %s\n", argv[1], argv[2]);
+            return 0;
+        }
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "world: %s\n", e.what());
+        return 1;
+    }
+
+    std::fprintf(stderr, "usage: %s <src> <dst> | --bench <n_entities>\n", argv[0]);
+    return 1;
+}